@@ -0,0 +1,69 @@
+#include "source_generator.hpp"
+
+#include "../seam/lexer/lexer.hpp"
+#include "../seam/types/module.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace
+{
+	struct benchmark_result
+	{
+		std::size_t lexemes;
+		double seconds;
+	};
+
+	benchmark_result lex_source(const std::string& source)
+	{
+		const auto module = std::make_shared<seam::types::module>("benchmark");
+		seam::lexer::lexer lexer{ module, source };
+
+		std::size_t lexemes = 0;
+
+		const auto start = std::chrono::steady_clock::now();
+		do
+		{
+			lexer.next_lexeme();
+			++lexemes;
+		} while (lexer.current_lexeme().type != seam::lexer::lexeme_type::eof);
+		const auto end = std::chrono::steady_clock::now();
+
+		return { lexemes, std::chrono::duration<double>(end - start).count() };
+	}
+
+	void run(const char* name, const std::string& source, const int iterations)
+	{
+		auto best = lex_source(source);
+		for (auto i = 1; i < iterations; ++i)
+		{
+			if (const auto result = lex_source(source); result.seconds < best.seconds)
+			{
+				best = result;
+			}
+		}
+
+		std::cout << name << ": " << source.size() / (1024 * 1024) << " MiB, "
+			<< best.lexemes << " lexemes, "
+			<< best.seconds * 1000 << " ms, "
+			<< static_cast<std::size_t>(best.lexemes / best.seconds) << " lexemes/s, "
+			<< source.size() / best.seconds / (1024 * 1024) << " MiB/s\n";
+	}
+}
+
+/**
+ * Lexer micro-benchmark.
+ *
+ * usage: lexer_benchmark [size in MiB] [iterations]
+ */
+int main(int argc, char** argv)
+{
+	const std::size_t size_mib = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 16;
+	const int iterations = argc > 2 ? std::atoi(argv[2]) : 5;
+
+	run("generated", seam::benchmarks::generate_source(size_mib * 1024 * 1024), iterations);
+	run("operators", seam::benchmarks::generate_operator_source(size_mib * 1024 * 1024), iterations);
+}
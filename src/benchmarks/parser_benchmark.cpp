@@ -0,0 +1,502 @@
+#include "source_generator.hpp"
+
+#include "../seam/ir/ast/flat_expressions.hpp"
+#include "../seam/ir/ast/visitor.hpp"
+#include "../seam/lexer/lexer.hpp"
+#include "../seam/parser/parser.hpp"
+#include "../seam/parser/passes/body_flattener.hpp"
+#include "../seam/parser/passes/function_collector.hpp"
+#include "../seam/parser/passes/pass_manager.hpp"
+#include "../seam/parser/passes/types.hpp"
+#include "../seam/types/module.hpp"
+#include "../seam/types/module_cache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+	std::atomic<std::size_t> allocations{ 0 }; // heap allocations so far.
+	thread_local std::size_t thread_allocations = 0; // heap allocations of the thread so far.
+}
+
+// Counts heap allocations, the other forms of new and delete end up here.
+void* operator new(const std::size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	++thread_allocations;
+	if (const auto memory = std::malloc(size == 0 ? 1 : size))
+	{
+		return memory;
+	}
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+namespace
+{
+	template <typename Function>
+	double time_best(const int iterations, Function&& function)
+	{
+		auto best = 0.0;
+		for (auto i = 0; i < iterations; ++i)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			function();
+			const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			if (i == 0 || seconds < best)
+			{
+				best = seconds;
+			}
+		}
+		return best;
+	}
+
+	void report(const char* name, const std::string& source, const double seconds)
+	{
+		std::cout << "  " << name << ": " << seconds * 1000 << " ms, "
+			<< source.size() / seconds / (1024 * 1024) << " MiB/s\n";
+	}
+
+	std::size_t peak_rss_kib()
+	{
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS counters{};
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return counters.PeakWorkingSetSize / 1024;
+#else
+		rusage usage{};
+		getrusage(RUSAGE_SELF, &usage);
+		return static_cast<std::size_t>(usage.ru_maxrss); // KiB on Linux.
+#endif
+	}
+
+	void run(const char* name, const std::string& source, const int iterations)
+	{
+		std::cout << name << ": " << source.size() / 1024 << " KiB\n";
+
+		const auto walk = [&](seam::lexer::lexer& lexer)
+		{
+			do
+			{
+				lexer.next_lexeme();
+			} while (lexer.current_lexeme().type != seam::lexer::lexeme_type::eof);
+		};
+
+		report("token stream, streaming", source, time_best(iterations, [&]
+		{
+			seam::lexer::lexer lexer{ std::make_shared<seam::types::module>("benchmark"), source };
+			walk(lexer);
+		}));
+
+		report("token stream, batched", source, time_best(iterations, [&]
+		{
+			seam::lexer::lexer lexer{ std::make_shared<seam::types::module>("benchmark"), source, seam::lexer::lexer_mode::batched };
+			walk(lexer);
+		}));
+
+		// Parse and teardown are timed separately, teardown being the release of the module.
+		auto best_parse = 0.0;
+		auto best_teardown = 0.0;
+		std::size_t parse_allocations = 0;
+		for (auto i = 0; i < iterations; ++i)
+		{
+			auto module = std::make_shared<seam::types::module>("benchmark");
+			const auto allocations_before = allocations.load();
+			const auto parse = time_best(1, [&]
+			{
+				seam::parser::parser parser{ module, "benchmark", source };
+				module->body = parser.parse();
+			});
+			parse_allocations = allocations.load() - allocations_before;
+			const auto teardown = time_best(1, [&] { module.reset(); });
+
+			best_parse = i == 0 ? parse : std::min(best_parse, parse);
+			best_teardown = i == 0 ? teardown : std::min(best_teardown, teardown);
+		}
+		report("streaming", source, best_parse);
+		report("teardown", source, best_teardown);
+		std::cout << "  heap allocations while parsing: " << parse_allocations << '\n';
+
+		report("batched", source, time_best(iterations, [&]
+		{
+			const auto module = std::make_shared<seam::types::module>("benchmark");
+			seam::parser::parser parser{ module, "benchmark", source, seam::lexer::lexer_mode::batched };
+			module->body = parser.parse();
+		}));
+
+		report("streaming, lazy bodies", source, time_best(iterations, [&]
+		{
+			const auto module = std::make_shared<seam::types::module>("benchmark");
+			seam::parser::parser parser{ module, "benchmark", source };
+			module->body = parser.parse(seam::parser::body_parsing::lazy);
+		}));
+
+		report("batched, lazy bodies", source, time_best(iterations, [&]
+		{
+			const auto module = std::make_shared<seam::types::module>("benchmark");
+			seam::parser::parser parser{ module, "benchmark", source, seam::lexer::lexer_mode::batched };
+			module->body = parser.parse(seam::parser::body_parsing::lazy);
+		}));
+
+		report("streaming, parallel bodies", source, time_best(iterations, [&]
+		{
+			const auto module = std::make_shared<seam::types::module>("benchmark");
+			seam::parser::parser parser{ module, "benchmark", source };
+			module->body = parser.parse(seam::parser::body_parsing::parallel);
+		}));
+
+		report("batched, parallel bodies", source, time_best(iterations, [&]
+		{
+			const auto module = std::make_shared<seam::types::module>("benchmark");
+			seam::parser::parser parser{ module, "benchmark", source, seam::lexer::lexer_mode::batched };
+			module->body = parser.parse(seam::parser::body_parsing::parallel);
+		}));
+
+		const auto tokens = seam::lexer::lexer::tokenize(std::make_shared<seam::types::module>("benchmark"), source);
+		report("token stream, cached tokens", source, time_best(iterations, [&]
+		{
+			seam::lexer::lexer lexer{ std::make_shared<seam::types::module>("benchmark"), tokens };
+			walk(lexer);
+		}));
+
+		report("batched, cached tokens", source, time_best(iterations, [&]
+		{
+			const auto module = std::make_shared<seam::types::module>("benchmark");
+			seam::parser::parser parser{ module, "benchmark", tokens };
+			module->body = parser.parse();
+		}));
+	}
+
+	struct node_counter
+	{
+		std::size_t count = 0;
+
+		bool visit(seam::ir::ast::node* node)
+		{
+			++count;
+			return true;
+		}
+	};
+
+	void run_traversals(const char* name, const std::string& source, const int iterations)
+	{
+		const auto module = std::make_shared<seam::types::module>("benchmark");
+		seam::parser::parser parser{ module, "benchmark", source };
+		module->body = parser.parse();
+
+		node_counter counter;
+		module->body->visit(&counter);
+		std::cout << name << ": " << source.size() / 1024 << " KiB, " << counter.count << " nodes\n";
+
+		report("traversal, counting nodes", source, time_best(iterations, [&]
+		{
+			node_counter counter;
+			module->body->visit(&counter);
+		}));
+
+		report("function_collector", source, time_best(iterations, [&]
+		{
+			seam::parser::passes::function_collector collector;
+			collector.run(module->body);
+		}));
+
+		seam::parser::passes::function_collector collector;
+		collector.run(module->body);
+		report("types", source, time_best(iterations, [&]
+		{
+			using seam::parser::passes::analysis;
+			seam::parser::passes::pass_manager manager{ analysis::function_table | analysis::resolved_symbols | analysis::flat_bodies };
+			manager.add<seam::parser::passes::types>(module->types);
+
+			seam::parser::passes::pass_context context{ *module, module->body, collector.definitions_ };
+			manager.run(context);
+		}));
+
+		// Flattening and typing again redo the work of a round, resolving symbols twice does not work.
+		const auto round = [&](const std::size_t workers)
+		{
+			using seam::parser::passes::analysis;
+			seam::parser::passes::pass_manager manager{ analysis::function_table | analysis::resolved_symbols, workers };
+			manager.add<seam::parser::passes::body_flattener>();
+			manager.add<seam::parser::passes::types>(module->types);
+
+			seam::parser::passes::pass_context context{ *module, module->body, collector.definitions_ };
+			manager.run(context);
+		};
+		report("function round, 1 worker", source, time_best(iterations, [&] { round(1); }));
+		report("function round, every hardware thread", source, time_best(iterations, [&] { round(0); }));
+
+		const auto parsed = std::make_shared<seam::types::module>("benchmark");
+		seam::parser::parser pass_parser{ parsed, "benchmark", source };
+		parsed->body = pass_parser.parse();
+		for (const auto& statistics : pass_parser.pass_statistics())
+		{
+			std::cout << "  pass " << statistics.name << ": " << std::chrono::duration<double, std::milli>(statistics.time).count() << " ms, "
+				<< statistics.nodes << " nodes, " << statistics.allocations << " allocations, "
+				<< statistics.arena_bytes / 1024 << " KiB arena\n";
+		}
+	}
+
+	struct expression_summary
+	{
+		std::size_t bytes = 0; // bytes of the expression nodes.
+		std::size_t value = 0; // checksum, keeps the traversals from being optimized away.
+
+		bool visit(seam::ir::ast::expression::unary* node)
+		{
+			bytes += sizeof(*node);
+			value += static_cast<std::size_t>(node->operation);
+			return true;
+		}
+
+		bool visit(seam::ir::ast::expression::binary* node)
+		{
+			bytes += sizeof(*node);
+			value += static_cast<std::size_t>(node->operation);
+			return true;
+		}
+
+		bool visit(seam::ir::ast::expression::call* node)
+		{
+			bytes += sizeof(*node);
+			if (node->arguments.capacity() > node->arguments.inline_capacity)
+			{
+				bytes += node->arguments.capacity() * sizeof(node->arguments[0]);
+			}
+			value += node->arguments.size();
+			return true;
+		}
+
+		bool visit(seam::ir::ast::expression::variable_ref* node)
+		{
+			bytes += sizeof(*node);
+			++value;
+			return true;
+		}
+
+		bool visit(seam::ir::ast::expression::number_literal* node)
+		{
+			bytes += sizeof(*node);
+			return true;
+		}
+
+		bool visit(seam::ir::ast::expression::bool_literal* node)
+		{
+			bytes += sizeof(*node);
+			return true;
+		}
+
+		bool visit(seam::ir::ast::expression::symbol_wrapper* node)
+		{
+			bytes += sizeof(*node);
+			return true;
+		}
+
+		bool visit(seam::ir::ast::expression::function_signature* node)
+		{
+			return false;
+		}
+	};
+
+	struct definition_collector
+	{
+		std::vector<seam::ir::ast::statement::function_definition*> definitions;
+
+		bool visit(seam::ir::ast::statement::function_definition* node)
+		{
+			if (node->flat_body)
+			{
+				definitions.push_back(node);
+			}
+			return false;
+		}
+	};
+
+	/**
+	 * Compares walking the expression trees of every function body with scanning
+	 * their flat encoding, see ir::ast::flat_expressions.
+	 */
+	void run_expressions(const char* name, const std::string& source, const int iterations)
+	{
+		const auto module = std::make_shared<seam::types::module>("benchmark");
+		seam::parser::parser parser{ module, "benchmark", source };
+		module->body = parser.parse();
+
+		definition_collector collector;
+		module->body->visit(&collector);
+
+		expression_summary tree;
+		std::size_t flat_bytes = 0;
+		for (const auto& definition : collector.definitions)
+		{
+			definition->body->visit(&tree);
+			flat_bytes += definition->flat_body->bytes();
+		}
+		std::cout << name << ": " << source.size() / 1024 << " KiB, expression trees " << tree.bytes / 1024
+			<< " KiB, flat expressions " << flat_bytes / 1024 << " KiB\n";
+
+		std::size_t tree_value = 0;
+		report("expression trees", source, time_best(iterations, [&]
+		{
+			expression_summary summary;
+			for (const auto& definition : collector.definitions)
+			{
+				definition->body->visit(&summary);
+			}
+			tree_value = summary.value;
+		}));
+
+		std::size_t flat_value = 0;
+		report("flat expressions", source, time_best(iterations, [&]
+		{
+			std::size_t value = 0;
+			for (const auto& definition : collector.definitions)
+			{
+				for (const auto& expression : definition->flat_body->expressions)
+				{
+					switch (expression.kind())
+					{
+						case seam::ir::ast::node_kind::unary:
+						case seam::ir::ast::node_kind::binary:
+							value += static_cast<std::size_t>(expression.operation());
+							break;
+						case seam::ir::ast::node_kind::call:
+							value += definition->flat_body->call_arguments(expression).size();
+							break;
+						case seam::ir::ast::node_kind::variable_ref:
+							++value;
+							break;
+						default:
+							break;
+					}
+				}
+			}
+			flat_value = value;
+		}));
+
+		if (tree_value != flat_value)
+		{
+			std::cout << "  mismatch between the traversals: " << tree_value << " != " << flat_value << '\n';
+		}
+	}
+
+	void run_cache(const char* name, const std::string& source, const int iterations)
+	{
+		const auto path = (std::filesystem::temp_directory_path() / "parser_benchmark.seamast").string();
+		const auto source_hash = seam::types::hash_source(source);
+
+		const auto module = std::make_shared<seam::types::module>("benchmark");
+		{
+			seam::parser::parser parser{ module, "benchmark", source };
+			module->body = parser.parse();
+		}
+
+		seam::types::write_module(*module, source_hash, path);
+		std::cout << name << ": " << source.size() / 1024 << " KiB, cache " << std::filesystem::file_size(path) / 1024 << " KiB\n";
+
+		report("write cache", source, time_best(iterations, [&]
+		{
+			seam::types::write_module(*module, source_hash, path);
+		}));
+
+		report("parse and run passes", source, time_best(iterations, [&]
+		{
+			const auto module = std::make_shared<seam::types::module>("benchmark");
+			seam::parser::parser parser{ module, "benchmark", source };
+			module->body = parser.parse();
+		}));
+
+		report("hash source and read cache", source, time_best(iterations, [&]
+		{
+			seam::types::read_module(path, seam::types::hash_source(source));
+		}));
+
+		std::filesystem::remove(path);
+	}
+
+	void run_incremental(const char* name, const std::string& source, const int iterations)
+	{
+		// Alternates between two sources differing in a literal of a function in the middle.
+		const auto literal = source.find("x: i32 = ", source.size() / 2) + 9;
+		const auto length = source.find('\n', literal) - literal;
+		auto edited = source;
+		edited.replace(literal, length, "12345");
+
+		const auto lines = std::count(source.begin(), source.end(), '\n');
+		std::cout << name << ": " << source.size() / 1024 << " KiB, " << lines << " lines\n";
+
+		const auto module = std::make_shared<seam::types::module>("benchmark");
+		{
+			seam::parser::parser parser{ module, "benchmark", source };
+			module->body = parser.parse();
+		}
+
+		const auto offset = static_cast<std::uint32_t>(literal);
+		const std::vector<seam::parser::text_edit> forward{ { { { offset }, { offset + static_cast<std::uint32_t>(length) } }, 5 } };
+		const std::vector<seam::parser::text_edit> backward{ { { { offset }, { offset + 5 } }, static_cast<std::uint32_t>(length) } };
+
+		auto is_edited = false;
+		const auto seconds = time_best(iterations * 2, [&]
+		{
+			seam::parser::parser parser{ module, "benchmark", is_edited ? source : edited };
+			parser.reparse(is_edited ? backward : forward);
+			is_edited = !is_edited;
+		});
+		std::cout << "  reparse after editing a literal: " << seconds * 1000 << " ms\n";
+	}
+}
+
+/**
+ * Parser benchmark, parses (and runs passes over) generated modules and
+ * releases them again.
+ *
+ * usage: parser_benchmark [size in MiB] [iterations]
+ */
+int main(int argc, char** argv)
+{
+	const std::size_t size_mib = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 16;
+	const int iterations = argc > 2 ? std::atoi(argv[2]) : 3;
+
+	std::cout << "hardware threads: " << std::thread::hardware_concurrency() << '\n';
+	seam::parser::passes::pass_manager::allocation_counter = [] { return thread_allocations; };
+
+	run("generated", seam::benchmarks::generate_source(size_mib * 1024 * 1024), iterations);
+	run("operators", seam::benchmarks::generate_operator_source(size_mib * 1024 * 1024), iterations);
+	run("100k-term chains", seam::benchmarks::generate_chain_source(100000), iterations);
+	run_traversals("passes", seam::benchmarks::generate_source(size_mib * 1024 * 1024), iterations);
+	run_expressions("expressions", seam::benchmarks::generate_operator_source(size_mib * 1024 * 1024), iterations);
+	run_cache("cache", seam::benchmarks::generate_source(size_mib * 1024 * 1024), iterations);
+	run_incremental("incremental", seam::benchmarks::generate_source(1024 * 1024), iterations);
+
+	std::cout << "peak RSS: " << peak_rss_kib() / 1024 << " MiB\n";
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <string>
+
+namespace seam::benchmarks
+{
+	/**
+	 * Generates a machine-generated looking Seam module.
+	 *
+	 * The output mimics what our code generators emit: large comment banners,
+	 * deep indentation, many small helper functions and arithmetic kernels.
+	 *
+	 * @param target_size approximate size of the generated source in bytes.
+	 * @returns generated source.
+	 */
+	inline std::string generate_source(const std::size_t target_size)
+	{
+		std::string source;
+		source.reserve(target_size + 1024);
+
+		for (std::size_t index = 0; source.size() < target_size; ++index)
+		{
+			const auto name = "helper_" + std::to_string(index);
+
+			source += "///\n";
+			source += "    generated by seam-gen, do not edit.\n";
+			source += "    function: " + name + "\n";
+			source += "///\n";
+			source += "// " + name + " kernel\n";
+			source += "fn " + name + "(a: i32, b: i32) -> i32\n";
+			source += "{\n";
+			source += "\tx: i32 = " + std::to_string(index % 97) + "\n";
+			source += "\ty: i32 = x + 2 * x - x / 3 + x % 5 * 11\n";
+			source += "\tv := y + 1\n";
+			source += "\tif (y >= 10 && x != 2 || y <= 3)\n";
+			source += "\t{\n";
+			source += "\t\tz: i32 = y * (x + 7) - (y - 1) * 3\n";
+			source += "\t}\n";
+			source += "\telse\n";
+			source += "\t{\n";
+			source += "\t\tw: i32 = y\n";
+			source += "\t}\n";
+			source += "\twhile (x < 100)\n";
+			source += "\t{\n";
+			source += "\t\t" + name + "(1, 2)\n";
+			source += "\t}\n";
+			source += "\treturn y\n";
+			source += "}\n\n";
+		}
+
+		source += "fn main() @constructor\n{\n\thelper_0(1, 2)\n}\n";
+		return source;
+	}
+
+	/**
+	 * Generates operator-dense Seam source (long arithmetic kernels).
+	 *
+	 * @param target_size approximate size of the generated source in bytes.
+	 * @returns generated source.
+	 */
+	inline std::string generate_operator_source(const std::size_t target_size)
+	{
+		std::string source;
+		source.reserve(target_size + 1024);
+
+		for (std::size_t index = 0; source.size() < target_size; ++index)
+		{
+			source += "fn kernel_" + std::to_string(index) + "() -> i32\n{\n";
+			source += "\tx: i32 = 1\n";
+			for (auto line = 0; line < 8; ++line)
+			{
+				source += "\tr" + std::to_string(line) + ": i32 = (x+1)*(x-2)/(x+3)%(x-4)+(x*x)-(x/2)\n";
+				source += "\tc" + std::to_string(line) + ": bool = x<=1&&x>=2||x!=3&&x==4||x<5&&x>6\n";
+			}
+			source += "\treturn x\n}\n";
+		}
+
+		return source;
+	}
+
+	/**
+	 * Generates a module with a few very long operator chains, the shape
+	 * produced by generated lookup tables and unrolled kernels.
+	 *
+	 * @param terms number of terms in each expression.
+	 * @returns generated source.
+	 */
+	inline std::string generate_chain_source(const std::size_t terms)
+	{
+		static constexpr const char* operators[] = { " + ", " * ", " - ", " / ", " % ", " + -" };
+
+		std::string source;
+		source += "fn chain() -> i32\n{\n";
+		source += "\tx: i32 = 1\n";
+		source += "\ty: i32 = x";
+		for (std::size_t index = 1; index < terms; ++index)
+		{
+			source += operators[index % std::size(operators)];
+			source += index % 7 == 0 ? "(x + 1)" : "x";
+		}
+		source += "\n\tc: bool = x < 1";
+		for (std::size_t index = 1; index < terms; ++index)
+		{
+			source += index % 2 == 0 ? " && x < " : " || x > ";
+			source += std::to_string(index % 100);
+		}
+		source += "\n\tn: i32 = ";
+		for (std::size_t index = 1; index < terms; ++index)
+		{
+			source += "- ";
+		}
+		source += "x\n\treturn y\n}\n";
+		return source;
+	}
+}
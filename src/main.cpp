@@ -2,28 +2,74 @@
 #include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/Support/Program.h>
 
+#include "seam/lexer/line_index.hpp"
 #include "seam/parser/parser.hpp"
 #include "seam/utils/exception.hpp"
+#include "seam/utils/source_file.hpp"
 #include "seam/types/module.hpp"
+#include "seam/types/module_cache.hpp"
 #include "seam/code_generation/code_generation.hpp"
 
 #include <memory>
 
-int main()
+int main(int argc, char** argv)
 {
-	const auto module = std::make_shared<seam::types::module>("test_module");
+	if (argc != 2)
+	{
+		llvm::errs() << "usage: " << (argc > 0 ? argv[0] : "compiler") << " <source file | ->\n";
+		return 1;
+	}
 
-	seam::parser::parser parser(module, "test", R"(
-fn main()
-{
-	x := 5 + 3
-	return
-}
-	)");
+	std::shared_ptr<seam::types::module> module;
+
+	std::shared_ptr<const seam::utils::source_file> source;
+	try
+	{
+		source = std::make_shared<const seam::utils::source_file>(argv[1]);
+	}
+	catch (const std::exception& ex)
+	{
+		llvm::WithColor::error() << ex.what() << '\n';
+		return 1;
+	}
+
+	// Modules whose source is unchanged since the last build are read from their cache.
+	const auto is_cached = source->path() != "-";
+	const auto cache_path = source->path() + ".seamast";
+	const auto source_hash = is_cached ? seam::types::hash_source(source->contents()) : 0;
+	if (is_cached)
+	{
+		try
+		{
+			module = seam::types::read_module(cache_path, source_hash);
+		}
+		catch (const std::exception& ex)
+		{
+			llvm::WithColor::warning() << "ignoring module cache: " << ex.what() << '\n';
+		}
+	}
 	
 	try
 	{
-		module->body = parser.parse();
+		if (!module)
+		{
+			module = std::make_shared<seam::types::module>("test_module");
+
+			seam::parser::parser parser(module, source);
+			module->body = parser.parse(seam::parser::body_parsing::parallel);
+
+			if (is_cached)
+			{
+				try
+				{
+					seam::types::write_module(*module, source_hash, cache_path);
+				}
+				catch (const std::exception& ex)
+				{
+					llvm::WithColor::warning() << ex.what() << '\n';
+				}
+			}
+		}
 
 		/*seam::code_generation::code_generation code_gen{ module.get() };
 		auto module = code_gen.generate();
@@ -59,12 +105,15 @@ fn main()
 	}
 	catch (const seam::utils::exception& ex)
 	{
-		llvm::errs() << ex.position.line << ':' << ex.position.column << ": ";
+		const auto location = seam::lexer::line_index{ source->contents() }.locate(ex.position);
+		llvm::errs() << source->path() << ':' << location.line << ':' << location.column << ": ";
 		llvm::WithColor::error() << ex.what() << '\n';
+		return 1;
 	}
 	catch (const std::exception& ex)
 	{
 		llvm::WithColor::error();
 		llvm::errs() << ex.what() << '\n';
+		return 1;
 	}
 }
@@ -1,6 +1,7 @@
 #include "code_generation.hpp"
 #include "../ir/ast/visitor.hpp"
 #include "../ir/ast/type.hpp"
+#include "../ir/ast/flat_expressions.hpp"
 
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/Verifier.h>
@@ -68,10 +69,14 @@ namespace seam::code_generation
                     }
                     default:
                     {
-                        throw utils::compiler_exception{ {0, 0}, "internal compiler error: unknown type" };
+                        throw utils::compiler_exception{ { 0 }, "internal compiler error: unknown type" };
                     }
                 }
             }
+            else if constexpr (std::is_same_v<std::decay_t<decltype(arg)>, ir::ast::optional_descriptor>)
+            {
+                throw std::runtime_error("TODO: optional types are not supported");
+            }
             else
             {
                 throw std::runtime_error("TODO: class types are not supported");
@@ -89,7 +94,7 @@ namespace seam::code_generation
         }
 
 	    // set return type
-        const auto return_type = get_llvm_type(static_cast<ir::ast::type*>(signature->return_type.get()));
+        const auto return_type = get_llvm_type(signature->return_type);
         if (!llvm::FunctionType::isValidReturnType(return_type))
         {
             throw utils::compiler_exception(position, "internal compiler error: invalid return type"); // func->range doesn't exist
@@ -98,7 +103,7 @@ namespace seam::code_generation
         std::vector<llvm::Type*> param_types;
     	for (const auto& param : signature->parameters)
     	{
-            const auto param_type = get_llvm_type(static_cast<ir::ast::type*>(param->var->type_.get()));
+            const auto param_type = get_llvm_type(param->var->type_);
     		if (!llvm::FunctionType::isValidArgumentType(param_type))
     		{
     			throw utils::compiler_exception(position, "internal compiler error: invalid parameter type"); // functio nrange doesn't exist
@@ -112,7 +117,7 @@ namespace seam::code_generation
         return function_type;
     }
 	
-	struct function_collector : ir::ast::visitor
+	struct function_collector
 	{
 		std::vector<ir::ast::statement::function_definition*> collected_functions;
         std::vector<ir::ast::statement::extern_function_definition*> collected_extern_functions;
@@ -123,78 +128,131 @@ namespace seam::code_generation
             return false;
         }
 
-		bool visit(ir::ast::statement::function_definition* node) override
+		bool visit(ir::ast::statement::function_definition* node)
 		{
 			collected_functions.push_back(node);
 			return false; // future: might return true for lambda funcs
 		}
 	};
 
-    struct code_gen_visitor : ir::ast::visitor
+    struct code_gen_visitor
     {
-	    explicit code_gen_visitor(llvm::IRBuilder<>& builder, code_generation& gen) :
-            builder(builder), gen(gen)
+	    explicit code_gen_visitor(llvm::IRBuilder<>& builder, code_generation& gen, const ir::ast::flat_expressions& flat) :
+            builder(builder), gen(gen), flat(flat), values(flat.expressions.size())
         {}
 
         llvm::IRBuilder<>& builder;
         code_generation& gen;
         std::unordered_map<ir::ast::expression::variable*, llvm::Value*> variables;
 
+        const ir::ast::flat_expressions& flat; // expressions of the function body.
+        std::vector<llvm::Value*> values; // value of each flat expression once generated.
+        std::vector<llvm::Value*> arguments;
+
         llvm::Value* value = nullptr;
 
-        bool visit(ir::ast::expression::symbol_wrapper* node) override
+        /**
+         * Generates an expression of a statement, operands first, into value.
+         *
+         * @param root expression referred to by the statement.
+         */
+        void evaluate(ir::ast::expression::expression* root)
         {
-            value = gen.get_or_declare_function(node->range.start,
-                static_cast<ir::ast::expression::resolved_symbol*>(node->value.get())->signature.get());
-            return false;
+            const auto span = flat.find(root);
+            for (auto index = span.first; index <= span.root; ++index)
+            {
+                const auto& expression = flat.expressions[index];
+                switch (expression.kind())
+                {
+                    case ir::ast::node_kind::symbol_wrapper:
+                    {
+                        value = generate(static_cast<ir::ast::expression::symbol_wrapper*>(expression.node));
+                        break;
+                    }
+                    case ir::ast::node_kind::call:
+                    {
+                        arguments.clear();
+                        for (const auto argument : flat.call_arguments(expression))
+                        {
+                            arguments.push_back(values[argument]);
+                        }
+                        value = generate(static_cast<ir::ast::expression::call*>(expression.node), values[expression.left], arguments);
+                        break;
+                    }
+                    case ir::ast::node_kind::bool_literal:
+                    {
+                        value = generate(static_cast<ir::ast::expression::bool_literal*>(expression.node));
+                        break;
+                    }
+                    case ir::ast::node_kind::variable_ref:
+                    {
+                        value = generate(static_cast<ir::ast::expression::variable_ref*>(expression.node));
+                        break;
+                    }
+                    case ir::ast::node_kind::number_literal:
+                    {
+                        value = generate(static_cast<ir::ast::expression::number_literal*>(expression.node));
+                        break;
+                    }
+                    case ir::ast::node_kind::binary:
+                    {
+                        value = generate(static_cast<ir::ast::expression::binary*>(expression.node), values[expression.left], values[expression.right]);
+                        break;
+                    }
+                    case ir::ast::node_kind::unary:
+                    {
+                        value = generate(static_cast<ir::ast::expression::unary*>(expression.node), values[expression.left]);
+                        break;
+                    }
+                    default:
+                    {
+                        value = nullptr;
+                        break;
+                    }
+                }
+                values[index] = value;
+            }
+        }
+
+        llvm::Value* generate(ir::ast::expression::symbol_wrapper* node)
+        {
+            return gen.get_or_declare_function(node->range.start,
+                static_cast<ir::ast::expression::resolved_symbol*>(node->value)->signature);
         }
     	
-        bool visit(ir::ast::expression::call* node) override
+        llvm::Value* generate(ir::ast::expression::call* node, llvm::Value* function, const std::vector<llvm::Value*>& arguments)
         {
         	// TODO: Handle call expressions in code_gen.
-            node->function->visit(this);
-            if (!llvm::isa<llvm::Function>(value))
+            if (!llvm::isa<llvm::Function>(function))
             {
                 throw utils::compiler_exception{ node->range.start, "internal compiler error: expected function for call" };
             }
 
-            const auto func = static_cast<llvm::Function*>(value);
+            const auto func = static_cast<llvm::Function*>(function);
 
-            std::vector<llvm::Value*> arguments;
-            for (const auto& arg : node->arguments)
-            {
-                arg->visit(this);
-                arguments.emplace_back(value);
-            }
             // TODO: More work here...
-            value = builder.CreateCall(func, llvm::makeArrayRef(arguments));
-            return false;
+            return builder.CreateCall(func, llvm::makeArrayRef(arguments));
         }
     	
-        bool visit(ir::ast::expression::bool_literal* node) override
+        llvm::Value* generate(ir::ast::expression::bool_literal* node)
         {
-            value = llvm::ConstantInt::get(builder.getContext(), llvm::APInt(1, node->value));
-            return false;
+            return llvm::ConstantInt::get(builder.getContext(), llvm::APInt(1, node->value));
         }
 
-        bool visit(ir::ast::expression::variable_ref* node) override
+        llvm::Value* generate(ir::ast::expression::variable_ref* node)
         {
-			const auto var = node->var.get();
+			const auto var = node->var;
 			const auto& it = variables.find(var);
 			if (it != variables.cend())
 			{
-				value = it->second;
+				return it->second;
             }
-			else
-			{
-				value = builder.CreateAlloca(gen.get_llvm_type(var->type_.get()), nullptr); // TODO: allocate all variables in entry block
-			}
-            return false;
+			return builder.CreateAlloca(gen.get_llvm_type(var->type_), nullptr); // TODO: allocate all variables in entry block
         }
 
-        bool visit(ir::ast::expression::number_literal* node) override
+        llvm::Value* generate(ir::ast::expression::number_literal* node)
         {
-            value = std::visit(
+            return std::visit(
                 [this, node](auto&& value) -> llvm::Value*
                 {
                     using value_t = std::decay_t<decltype(value)>;
@@ -227,6 +285,14 @@ namespace seam::code_generation
 								type_size = 8;
 								break;
 							}
+							case ir::ast::type::built_in_type::f32:
+							{
+								return llvm::ConstantFP::get(builder.getContext(), llvm::APFloat(static_cast<float>(value)));
+							}
+							case ir::ast::type::built_in_type::f64:
+							{
+								return llvm::ConstantFP::get(builder.getContext(), llvm::APFloat(static_cast<double>(value)));
+							}
 							default:
 							{
 								throw utils::compiler_exception{ node->range.start, "internal compiler error: unknown integer type" };
@@ -256,11 +322,10 @@ namespace seam::code_generation
                     {
                         throw utils::compiler_exception{ node->range.start, "internal compiler error: unknown number type" };
                     }
-                }, node->value);
-            return false;
+                }, node->constant->value);
         }
 
-        bool visit(ir::ast::statement::while_loop* node) override
+        bool visit(ir::ast::statement::while_loop* node)
         {
             auto start_block = builder.GetInsertBlock();
 
@@ -273,7 +338,7 @@ namespace seam::code_generation
             }
 
             builder.SetInsertPoint(loop_start_block);
-            node->condition->visit(this);
+            evaluate(node->condition);
             auto condition_value = value;
 
             auto loop_body_block = llvm::BasicBlock::Create(builder.getContext(), "loopbody",
@@ -297,11 +362,11 @@ namespace seam::code_generation
             return false;
         }
     	
-		bool visit(ir::ast::statement::assignment* node) override
+		bool visit(ir::ast::statement::assignment* node)
 		{
-			node->to->visit(this);
+			evaluate(node->to);
 			const auto to = value;
-			node->from->visit(this);
+			evaluate(node->from);
 			auto from = value;
 
 			if (llvm::isa<llvm::AllocaInst>(from))
@@ -314,9 +379,9 @@ namespace seam::code_generation
 			return false;
 		}
 
-        bool visit(ir::ast::statement::if_stat* node) override
+        bool visit(ir::ast::statement::if_stat* node)
         {
-            node->condition->visit(this);
+            evaluate(node->condition);
             auto condition_value = value;
 
             auto start_block = builder.GetInsertBlock();
@@ -377,16 +442,17 @@ namespace seam::code_generation
             return false;
         }
 
-        bool visit(ir::ast::statement::expression_* node) override
+        bool visit(ir::ast::statement::expression_* node)
         {
-            return true;
+            evaluate(node->value);
+            return false;
         }
     	
-        bool visit(ir::ast::statement::ret* node) override
+        bool visit(ir::ast::statement::ret* node)
         {
             if (node->value)
             {
-                node->value->visit(this); // generate return
+                evaluate(node->value); // generate return
 				if (llvm::isa<llvm::AllocaInst>(value))
 				{
 					value = builder.CreateLoad(value);
@@ -400,19 +466,37 @@ namespace seam::code_generation
             return false;
         }
 
-        bool visit(ir::ast::statement::normal_block* node) override
+        bool visit(ir::ast::statement::normal_block* node)
         {
 			return true;
         }
 
-        bool visit(ir::ast::expression::binary* node) override
+        llvm::Value* generate(ir::ast::expression::unary* node, llvm::Value* operand)
         {
-            node->left->visit(this);
-            const auto lhs_value = value;
-
-            node->right->visit(this);
-            const auto rhs_value = value;
+            switch (node->operation)
+            {
+                case lexer::lexeme_type::symbol_minus:
+                {
+                    const auto type = std::get_if<ir::ast::type::built_in_type>(&node->eval_type->value);
+                    if (type && (*type == ir::ast::type::built_in_type::f32 || *type == ir::ast::type::built_in_type::f64))
+                    {
+                        return builder.CreateFNeg(operand, "fnegtmp");
+                    }
+                    return builder.CreateNeg(operand, "negtmp");
+                }
+                case lexer::lexeme_type::symbol_not:
+                {
+                    return builder.CreateNot(operand, "nottmp");
+                }
+                default:
+                {
+                    throw utils::compiler_exception{ node->range.start, "internal compiler error: invalid unary operation" };
+                }
+            }
+        }
 
+        llvm::Value* generate(ir::ast::expression::binary* node, llvm::Value* lhs_value, llvm::Value* rhs_value)
+        {
             // TODO: correct?
             bool unsigned_operation = false;//resolved_left->is_unsigned && resolved_right->is_unsigned;
 
@@ -576,13 +660,13 @@ namespace seam::code_generation
                 }
             }
 
-			return false;
+			return value;
         }
     };
 	
     llvm::Function* code_generation::get_or_declare_function(utils::position position, ir::ast::expression::function_signature* signature)
     {
-        auto name = signature->is_extern ? signature->name : signature->mangled_name;
+        auto name = signature->is_extern ? std::string{ mod_->interner.spelling(signature->name) } : signature->mangled_name;
         auto func = llvm_module->getFunction(name);
     	if (!func)
     	{
@@ -594,12 +678,12 @@ namespace seam::code_generation
 
     void code_generation::compile_function(ir::ast::statement::function_definition* func)
 	{
-        llvm::Function* llvm_func = get_or_declare_function(func->range.start, func->signature.get());
+        llvm::Function* llvm_func = get_or_declare_function(func->range.start, func->signature);
         llvm::BasicBlock* basic_block = llvm::BasicBlock::Create(context_, "entry",
             llvm_func);
         llvm::IRBuilder<> builder(basic_block);
 
-        code_gen_visitor code_gen { builder, *this };
+        code_gen_visitor code_gen { builder, *this, *func->flat_body };
         func->body->visit(&code_gen);
 
         const auto& attribs = func->signature->attributes;
@@ -619,7 +703,7 @@ namespace seam::code_generation
 
     void code_generation::compile_extern_function(ir::ast::statement::extern_function_definition* func)
     {
-        get_or_declare_function(func->range.start, func->signature.get());
+        get_or_declare_function(func->range.start, func->signature);
     }
 
     std::shared_ptr<llvm::Module> code_generation::generate()
@@ -633,10 +717,14 @@ namespace seam::code_generation
             compile_extern_function(func);
         }
 
-        // Iterate over collected functions
+        // Iterate over collected functions, skipping bodies that were never parsed
+        // as nothing reachable calls them (and they have internal linkage).
         for (const auto func : collector.collected_functions)
         {
-			compile_function(func);
+            if (func->body)
+            {
+                compile_function(func);
+            }
         }
 
         auto entry_function = llvm::Function::Create(llvm::FunctionType::get(llvm::Type::getVoidTy(context_), false),
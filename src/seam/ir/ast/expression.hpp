@@ -1,207 +1,251 @@
 #pragma once
 
-#include <vector>
-#include <memory>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <variant>
 
 #include "node.hpp"
 #include "type.hpp"
 #include "../../lexer/lexeme.hpp"
-
-namespace seam::ir::ast
-{
-	struct visitor;
-}
+#include "../../utils/interner.hpp"
+#include "../../utils/small_vector.hpp"
 
 namespace seam::ir::ast::expression
 {	
 	struct expression : node
 	{
-		std::shared_ptr<type> eval_type{};
+		static constexpr node_kind first_kind = node_kind::unary;
+		static constexpr node_kind last_kind = node_kind::number_literal;
 
-		explicit expression(const utils::position_range range)
-			: node(range)
-		{}
+		type* eval_type = nullptr;
 
-		virtual ~expression() = default;
+		explicit expression(const utils::position_range range, const node_kind kind)
+			: node(range, kind)
+		{}
 	};
 
-	struct unary : expression
+	struct unary final : expression
 	{
-		std::unique_ptr<expression> right;
+		static constexpr node_kind first_kind = node_kind::unary;
+		static constexpr node_kind last_kind = node_kind::unary;
+
+		expression* right;
 		lexer::lexeme_type operation;
 
-		void visit(visitor* vst) override;
+		template <typename Visitor>
+		void visit(Visitor* vst);
 
 		explicit unary(utils::position_range range,
-			std::unique_ptr<expression> rhs,
+			expression* rhs,
 			lexer::lexeme_type operation) :
-			expression(range),
-			right(std::move(rhs)),
+			expression(range, node_kind::unary),
+			right(rhs),
 			operation(operation)
 		{}
 	};
 
-	struct binary : expression
+	struct binary final : expression
 	{
-		std::unique_ptr<expression> left;
-		std::unique_ptr<expression> right;
+		static constexpr node_kind first_kind = node_kind::binary;
+		static constexpr node_kind last_kind = node_kind::binary;
+
+		expression* left;
+		expression* right;
 		lexer::lexeme_type operation;
 
-		void visit(visitor* vst) override;
+		template <typename Visitor>
+		void visit(Visitor* vst);
 		
 		explicit binary(utils::position_range range,
-			std::unique_ptr<expression> lhs,
-			std::unique_ptr<expression> rhs,
+			expression* lhs,
+			expression* rhs,
 			lexer::lexeme_type operation) :
-			expression(range),
-			left(std::move(lhs)),
-			right(std::move(rhs)),
+			expression(range, node_kind::binary),
+			left(lhs),
+			right(rhs),
 			operation(operation)
 		{}
 	};
 	
-	using expression_list = std::vector<std::unique_ptr<expression>>;
+	using expression_list = utils::small_vector<expression*, 2>; // calls rarely take more than two arguments.
 
 	struct variable
 	{
-		std::string name;
-		std::shared_ptr<type> type_;
+		utils::symbol_id name;
+		type* type_;
 
-		variable(std::string name, std::shared_ptr<type> type_) :
-			name(std::move(name)),
-			type_(std::move(type_))
+		variable(const utils::symbol_id name, type* type_) :
+			name(name),
+			type_(type_)
 		{}
 	};
 
 	struct variable_ref final : expression
 	{
-		std::shared_ptr<variable> var;
+		static constexpr node_kind first_kind = node_kind::variable_ref;
+		static constexpr node_kind last_kind = node_kind::variable_ref;
 
-		void visit(visitor* vst) override;
+		variable* var;
 
-		variable_ref(utils::position_range range, std::shared_ptr<variable> var) :
-			expression(range),
-			var(std::move(var))
+		template <typename Visitor>
+		void visit(Visitor* vst);
+
+		variable_ref(utils::position_range range, variable* var) :
+			expression(range, node_kind::variable_ref),
+			var(var)
 		{}
 	};
 
 	struct literal : expression
 	{
-		void visit(visitor* vst) override = 0;
+		static constexpr node_kind first_kind = node_kind::bool_literal;
+		static constexpr node_kind last_kind = node_kind::number_literal;
 
-		explicit literal(utils::position_range range) :
-			expression(range)
+	protected:
+		explicit literal(utils::position_range range, const node_kind kind) :
+			expression(range, kind)
 		{}
 	};
 
-	struct bool_literal : literal
+	struct bool_literal final : literal
 	{
+		static constexpr node_kind first_kind = node_kind::bool_literal;
+		static constexpr node_kind last_kind = node_kind::bool_literal;
+
 		bool value;
 
-		void visit(visitor* vst) override;
+		template <typename Visitor>
+		void visit(Visitor* vst);
 
 		explicit bool_literal(utils::position_range range, bool value) :
-			literal(range), value(value)
+			literal(range, node_kind::bool_literal), value(value)
 		{}
 	};
 
-	struct string_literal : literal
+	struct string_literal final : literal
 	{
+		static constexpr node_kind first_kind = node_kind::string_literal;
+		static constexpr node_kind last_kind = node_kind::string_literal;
+
 		std::string value;
 
-		void visit(visitor* vst) override;
+		template <typename Visitor>
+		void visit(Visitor* vst);
 
 		explicit string_literal(utils::position_range range, std::string value) :
-			literal(range), value(std::move(value))
+			literal(range, node_kind::string_literal), value(std::move(value))
 		{}
 	};
 
-	struct number_literal final : literal
+	/**
+	 * Decoded value of a number literal, created by types::constant_pool once
+	 * per distinct spelling in a module.
+	 */
+	struct number_constant
 	{
+		std::string_view spelling; // spelling of the literal, suffix included.
 		std::variant<std::uint64_t, double> value;
-		bool is_unsigned;
+		type* suffix_type; // type named by the suffix, nullptr if the literal has none.
+	};
 
-		void visit(visitor* vst) override;
+	struct number_literal final : literal
+	{
+		static constexpr node_kind first_kind = node_kind::number_literal;
+		static constexpr node_kind last_kind = node_kind::number_literal;
 
-		void parse_float(const std::string& value);
-		void parse_integer(const std::string& value, bool is_unsigned);
+		const number_constant* constant;
 
-		explicit number_literal(utils::position_range range, const std::string& value);
+		template <typename Visitor>
+		void visit(Visitor* vst);
+
+		explicit number_literal(utils::position_range range, const number_constant* constant);
 	};
 
 	struct call final : expression
 	{
-		std::unique_ptr<expression> function;
+		static constexpr node_kind first_kind = node_kind::call;
+		static constexpr node_kind last_kind = node_kind::call;
+
+		expression* function;
 		expression_list arguments;
 
-		explicit call(const utils::position_range range, std::unique_ptr<expression> function, expression_list arguments) :
-			expression(range), function(std::move(function)), arguments(std::move(arguments))
+		explicit call(const utils::position_range range, expression* function, expression_list arguments) :
+			expression(range, node_kind::call), function(function), arguments(std::move(arguments))
 		{}
 
-		void visit(visitor* vst) override;
+		template <typename Visitor>
+		void visit(Visitor* vst);
 	};
 
 	struct symbol
 	{
-		
+	protected:
+		~symbol() = default;
 	};
 	
 	struct symbol_wrapper final : expression
 	{
-		std::unique_ptr<symbol> value;
+		static constexpr node_kind first_kind = node_kind::symbol_wrapper;
+		static constexpr node_kind last_kind = node_kind::symbol_wrapper;
+
+		symbol* value;
 
-		void visit(visitor* vst) override;
+		template <typename Visitor>
+		void visit(Visitor* vst);
 
-		symbol_wrapper(utils::position_range range, std::unique_ptr <symbol> value) :
-			expression(range), value(std::move(value))
+		symbol_wrapper(utils::position_range range, symbol* value) :
+			expression(range, node_kind::symbol_wrapper), value(value)
 		{}
 	};
 
 	struct unresolved_symbol final : symbol
 	{
-		std::string value;
+		utils::symbol_id value;
 
-		explicit unresolved_symbol(std::string value) :
-			value(std::move(value))
+		explicit unresolved_symbol(const utils::symbol_id value) :
+			value(value)
 		{}
 	};
 
 	using parameter = variable_ref;
-	using parameter_list = std::vector<std::unique_ptr<parameter>>;
+	using parameter_list = utils::small_vector<parameter*, 2>;
 	using attribute_list = std::unordered_set<std::string>;
 
-	struct function_signature : node
+	struct function_signature final : node
 	{
-		std::string name;
-		std::shared_ptr<type> return_type;
-		std::vector<std::unique_ptr<variable_ref>> parameters;
+		static constexpr node_kind first_kind = node_kind::function_signature;
+		static constexpr node_kind last_kind = node_kind::function_signature;
+
+		utils::symbol_id name;
+		type* return_type;
+		parameter_list parameters;
 		std::unordered_set<std::string> attributes;
 		bool is_extern = false;
 
 		std::string mangled_name;
 
-		explicit function_signature(std::string module_name, std::string name, std::shared_ptr<type> return_type, parameter_list parameters,
-			attribute_list attributes) :
-			node({ 0,0 }),
-			name(std::move(name)),
-			return_type(std::move(return_type)),
+		explicit function_signature(const std::string& module_name, const utils::symbol_id name, const std::string_view spelling,
+			type* return_type, parameter_list parameters, attribute_list attributes) :
+			node({ 0,0 }, node_kind::function_signature),
+			name(name),
+			return_type(return_type),
 			parameters(std::move(parameters)),
 			attributes(std::move(attributes))
 		{
-			mangled_name = module_name + "@" + this->name;
+			mangled_name = module_name + "@" + std::string{ spelling };
 		}
 
-		void visit(visitor* vst) override;
+		template <typename Visitor>
+		void visit(Visitor* vst);
 	};
 
 	struct resolved_symbol final : symbol
 	{
-		std::shared_ptr<function_signature> signature;
+		function_signature* signature;
 
-		explicit resolved_symbol(std::shared_ptr<function_signature> sig) :
-			signature(std::move(sig))
+		explicit resolved_symbol(function_signature* sig) :
+			signature(sig)
 		{}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "flat_expressions.hpp"
+#include "visitor.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+namespace seam::ir::ast
+{
+	namespace
+	{
+		/**
+		 * Returns a child of an expression.
+		 *
+		 * @param node expression.
+		 * @param index index of the child, in evaluation order.
+		 * @returns the child, or nullptr past the last one.
+		 */
+		expression::expression* child(expression::expression* node, const std::size_t index)
+		{
+			switch (node->kind)
+			{
+				case node_kind::unary:
+				{
+					return index == 0 ? static_cast<expression::unary*>(node)->right : nullptr;
+				}
+				case node_kind::binary:
+				{
+					const auto binary = static_cast<expression::binary*>(node);
+					return index == 0 ? binary->left : index == 1 ? binary->right : nullptr;
+				}
+				case node_kind::call:
+				{
+					const auto call = static_cast<expression::call*>(node);
+					if (index == 0)
+					{
+						return call->function;
+					}
+					return index <= call->arguments.size() ? call->arguments[index - 1] : nullptr;
+				}
+				default:
+				{
+					return nullptr;
+				}
+			}
+		}
+
+		// Appends every expression a statement refers to, without recursing into the
+		// expression trees, which can be as deep as they are long.
+		struct flattener
+		{
+			struct frame
+			{
+				expression::expression* node;
+				std::size_t next_child;
+				std::size_t first_child_root; // index in child_roots_ of the roots of its finished children.
+			};
+
+			std::vector<flat_expression> expressions_;
+			std::vector<std::uint32_t> arguments_;
+			std::vector<std::pair<const expression::expression*, flat_expressions::span>> roots_;
+
+			std::vector<frame> stack_;
+			std::vector<std::uint32_t> child_roots_;
+
+			void clear()
+			{
+				expressions_.clear();
+				arguments_.clear();
+				roots_.clear();
+				stack_.clear(); // left over by a body too long to flatten.
+				child_roots_.clear();
+			}
+
+			bool visit(expression::expression* root)
+			{
+				const auto first = static_cast<std::uint32_t>(expressions_.size());
+
+				stack_.push_back({ root, 0, 0 });
+				while (!stack_.empty())
+				{
+					const auto top = stack_.size() - 1;
+					if (const auto next = child(stack_[top].node, stack_[top].next_child))
+					{
+						++stack_[top].next_child;
+						stack_.push_back({ next, 0, child_roots_.size() });
+						continue;
+					}
+
+					const auto node = stack_[top].node;
+					const auto children = child_roots_.cbegin() + static_cast<std::ptrdiff_t>(stack_[top].first_child_root);
+
+					if (expressions_.size() > flat_expression::max_index)
+					{
+						throw std::length_error{ "too many expressions in function" };
+					}
+
+					flat_expression flat{ node, 0, static_cast<std::uint32_t>(node->kind), 0, 0 };
+					switch (node->kind)
+					{
+						case node_kind::unary:
+						{
+							flat.left = children[0];
+							flat.operation_ = static_cast<std::uint32_t>(static_cast<expression::unary*>(node)->operation);
+							break;
+						}
+						case node_kind::binary:
+						{
+							flat.left = children[0];
+							flat.right = children[1];
+							flat.operation_ = static_cast<std::uint32_t>(static_cast<expression::binary*>(node)->operation);
+							break;
+						}
+						case node_kind::call:
+						{
+							const auto argument_count = static_cast<std::uint32_t>(child_roots_.cend() - children) - 1;
+							if (arguments_.size() > flat_expression::max_index)
+							{
+								throw std::length_error{ "too many call arguments in function" };
+							}
+
+							flat.left = children[0];
+							flat.right = static_cast<std::uint32_t>(arguments_.size());
+							arguments_.push_back(argument_count);
+							arguments_.insert(arguments_.cend(), children + 1, child_roots_.cend());
+							break;
+						}
+						default:
+						{
+							break;
+						}
+					}
+
+					child_roots_.resize(stack_[top].first_child_root);
+					child_roots_.push_back(static_cast<std::uint32_t>(expressions_.size()));
+					expressions_.push_back(flat);
+					stack_.pop_back();
+				}
+				child_roots_.clear();
+
+				roots_.emplace_back(root, flat_expressions::span{ first, static_cast<std::uint32_t>(expressions_.size() - 1) });
+				return false;
+			}
+		};
+	}
+
+	flat_expressions::flat_expressions(statement::normal_block* body)
+	{
+		// Reused across bodies, so flattening allocates just the exactly sized arrays kept.
+		thread_local flattener vst;
+		vst.clear();
+		body->visit(&vst);
+
+		expressions.assign(vst.expressions_.cbegin(), vst.expressions_.cend());
+		arguments.assign(vst.arguments_.cbegin(), vst.arguments_.cend());
+		roots_.assign(vst.roots_.cbegin(), vst.roots_.cend());
+		finish();
+	}
+
+	flat_expressions::flat_expressions(std::vector<flat_expression> expressions, std::vector<std::uint32_t> arguments,
+		std::vector<std::pair<const expression::expression*, span>> roots) :
+		expressions(std::move(expressions)), arguments(std::move(arguments)), roots_(std::move(roots))
+	{
+		finish();
+	}
+
+	void flat_expressions::finish()
+	{
+		expressions.shrink_to_fit();
+		arguments.shrink_to_fit();
+		roots_.shrink_to_fit();
+		std::sort(roots_.begin(), roots_.end(), [](const auto& a, const auto& b) { return std::less<>{}(a.first, b.first); });
+	}
+
+	flat_expressions::span flat_expressions::find(const expression::expression* root) const
+	{
+		const auto it = std::lower_bound(roots_.cbegin(), roots_.cend(), root, [](const auto& entry, const auto node) { return std::less<>{}(entry.first, node); });
+		if (it == roots_.cend() || it->first != root)
+		{
+			throw std::out_of_range{ "expression is not referred to by a statement of the function" };
+		}
+		return it->second;
+	}
+
+	std::size_t flat_expressions::bytes() const
+	{
+		return sizeof(flat_expressions) + expressions.capacity() * sizeof(flat_expression)
+			+ arguments.capacity() * sizeof(std::uint32_t) + roots_.capacity() * sizeof(roots_.front());
+	}
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "expression.hpp"
+#include "statement.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace seam::ir::ast
+{
+	/**
+	 * An expression of a flat_expressions array, children are referred to
+	 * by index and always come before their parent.
+	 *
+	 * Indices are 24 bits wide, leaving room for the kind and operator next to
+	 * them, so a record is as large as the node pointer and two indices. Every
+	 * bitfield is declared std::uint32_t, compilers that start a new storage unit
+	 * when the declared type changes (MSVC) would pad the record otherwise.
+	 */
+	struct flat_expression
+	{
+		static constexpr std::uint32_t max_index = (1u << 24) - 1;
+
+		expression::expression* node; // tree node the expression was flattened from.
+		std::uint32_t left : 24; // operand of a unary, left operand of a binary, or function of a call.
+		std::uint32_t kind_ : 8; // node_kind, see kind.
+		std::uint32_t right : 24; // right operand of a binary, or argument count of a call in flat_expressions::arguments.
+		std::uint32_t operation_ : 8; // lexer::lexeme_type of unary and binary operators, see operation.
+
+		[[nodiscard]] node_kind kind() const { return static_cast<node_kind>(kind_); }
+		[[nodiscard]] lexer::lexeme_type operation() const { return static_cast<lexer::lexeme_type>(operation_); }
+	};
+
+	static_assert(sizeof(flat_expression) == sizeof(expression::expression*) + 2 * sizeof(std::uint32_t));
+
+	/**
+	 * The expressions of a function body stored contiguously in post-order, an
+	 * alternative encoding of the expression trees that passes can scan linearly.
+	 *
+	 * Every expression of a statement (say, the right hand side of an assignment)
+	 * occupies a contiguous span ending with its root, spans follow the order the
+	 * statements are visited in.
+	 */
+	struct flat_expressions
+	{
+		/**
+		 * A span of expressions.
+		 */
+		struct span
+		{
+			std::uint32_t first;
+			std::uint32_t root; // last expression of the span.
+		};
+
+		/**
+		 * The indices of the arguments of a call.
+		 */
+		struct argument_range
+		{
+			const std::uint32_t* first;
+			const std::uint32_t* last;
+
+			[[nodiscard]] const std::uint32_t* begin() const { return first; }
+			[[nodiscard]] const std::uint32_t* end() const { return last; }
+			[[nodiscard]] std::size_t size() const { return static_cast<std::size_t>(last - first); }
+			[[nodiscard]] std::uint32_t operator[](const std::size_t index) const { return first[index]; }
+		};
+
+		std::vector<flat_expression> expressions; // in post-order.
+		std::vector<std::uint32_t> arguments; // of every call its argument count, then the indices of its arguments.
+
+		/**
+		 * Flattens the expressions of a function body.
+		 *
+		 * @param body body to flatten.
+		 * @throws std::length_error if the body has more expressions or call arguments than indices can refer to.
+		 */
+		explicit flat_expressions(statement::normal_block* body);
+
+		/**
+		 * Adopts expressions flattened elsewhere, see types::read_module.
+		 *
+		 * @param expressions expressions in post-order.
+		 * @param arguments argument counts and indices of the arguments of calls.
+		 * @param roots spans of the expressions statements refer to.
+		 */
+		explicit flat_expressions(std::vector<flat_expression> expressions, std::vector<std::uint32_t> arguments,
+			std::vector<std::pair<const expression::expression*, span>> roots);
+
+		/**
+		 * Finds the span of an expression of a statement.
+		 *
+		 * @param root expression referred to by a statement.
+		 * @returns span of the expression and its subexpressions.
+		 */
+		[[nodiscard]] span find(const expression::expression* root) const;
+
+		/**
+		 * Returns the arguments of a call.
+		 *
+		 * @param call expression of kind node_kind::call.
+		 * @returns indices of the arguments in evaluation order.
+		 */
+		[[nodiscard]] argument_range call_arguments(const flat_expression& call) const
+		{
+			const auto first = arguments.data() + call.right + 1;
+			return { first, first + arguments[call.right] };
+		}
+
+		/**
+		 * Returns the number of bytes the encoding occupies.
+		 */
+		[[nodiscard]] std::size_t bytes() const;
+	private:
+		std::vector<std::pair<const expression::expression*, span>> roots_; // spans of statement expressions, sorted by expression.
+
+		/**
+		 * Releases spare capacity and sorts the roots for find.
+		 */
+		void finish();
+	};
+}
@@ -2,24 +2,92 @@
 
 #include "../../utils/position.hpp"
 
+#include <cstdint>
+
 namespace seam::ir::ast
 {
-	struct visitor;
+	/**
+	 * Concrete type of a node.
+	 *
+	 * Kinds of node types deriving from the same base are kept next to each other,
+	 * so every node type covers a contiguous range of kinds, see node::is.
+	 */
+	enum class node_kind : std::uint8_t
+	{
+		// expression::expression
+		unary,
+		binary,
+		variable_ref,
+		call,
+		symbol_wrapper,
+		bool_literal, // expression::literal
+		string_literal,
+		number_literal,
+
+		function_signature,
+
+		// statement::statement
+		normal_block, // statement::base_block
+		restricted_block,
+		expression_,
+		ret,
+		assignment,
+		if_stat,
+		numerical_for_loop, // statement::loop
+		while_loop,
+		function_definition, // statement::restricted
+		extern_function_definition,
+		alias_type_definition, // statement::type_definition
+		class_type_definition,
+	};
+
 	struct node
 	{
-		utils::position_range range; // the range of text the node ranges over. 
+		static constexpr node_kind first_kind = node_kind::unary;
+		static constexpr node_kind last_kind = node_kind::class_type_definition;
+
+		utils::position_range range; // the range of text the node ranges over.
+		const node_kind kind;
+
+		/**
+		 * Visits the node with a visitor, dispatching on its kind.
+		 *
+		 * The visitor is called with the node as its most derived type it has a
+		 * visit overload for, if the overload returns true (or there is none)
+		 * the children of the node are visited as well.
+		 *
+		 * @param vst visitor, see visitor.hpp.
+		 */
+		template <typename Visitor>
+		void visit(Visitor* vst);
 
 		/**
-		 * Virtual visit method for visitor pattern.
+		 * Checks whether the node is of a node type.
 		 *
-		 * @param vst visitor
-		 * @note not implemented for base node, will throw exception.
+		 * @returns whether the node is a T.
 		 */
-		virtual void visit(visitor* vst) = 0;
+		template <typename T>
+		[[nodiscard]] bool is() const
+		{
+			return kind >= T::first_kind && kind <= T::last_kind;
+		}
 
-		virtual ~node() = default;
+		/**
+		 * Casts the node to a node type.
+		 *
+		 * @returns the node as a T, or nullptr if it is not one.
+		 */
+		template <typename T>
+		[[nodiscard]] T* as()
+		{
+			return is<T>() ? static_cast<T*>(this) : nullptr;
+		}
 	protected:
-		explicit node(const utils::position_range range)
-			: range(range) {}
+		explicit node(const utils::position_range range, const node_kind kind)
+			: range(range), kind(kind) {}
+
+		// Nodes live in the module arena, which destroys them by their concrete
+		// type, so the destructor does not need to be virtual.
+		~node() = default;
 	};
 }
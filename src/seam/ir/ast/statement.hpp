@@ -1,219 +1,279 @@
 #pragma once
 
-#include <memory>
 #include <string>
-#include <unordered_map>
 #include <unordered_set>
 #include <utility>
-#include <vector>
 
 #include "node.hpp"
 #include "expression.hpp"
 #include "type.hpp"
+#include "../../utils/small_vector.hpp"
+
+namespace seam::ir::ast
+{
+	struct flat_expressions;
+}
 
 namespace seam::ir::ast::statement
 {	
 	struct statement : node
 	{
-		explicit statement(utils::position_range range)
-			: node(range) {}
+		static constexpr node_kind first_kind = node_kind::normal_block;
+		static constexpr node_kind last_kind = node_kind::class_type_definition;
 
-		virtual ~statement() = default;
+		explicit statement(utils::position_range range, const node_kind kind)
+			: node(range, kind) {}
 	};
 
-	using statement_list = std::vector<std::unique_ptr<statement>>;
+	using statement_list = utils::small_vector<statement*, 4>; // most blocks are if and while bodies of one or two statements.
 
 	struct restricted : statement
 	{
-		explicit restricted(utils::position_range range)
-			: statement(range) {}
+		static constexpr node_kind first_kind = node_kind::function_definition;
+		static constexpr node_kind last_kind = node_kind::class_type_definition;
 
-		virtual ~restricted() = default;
+		explicit restricted(utils::position_range range, const node_kind kind)
+			: statement(range, kind) {}
 	};
 
-	using restricted_list = std::vector<std::unique_ptr<restricted>>;
+	using restricted_list = utils::small_vector<restricted*, 2>;
 
 	struct base_block : statement
 	{
-		base_block* parent;
-		std::unordered_map<std::string, std::shared_ptr<expression::variable>> variables;
-		std::unordered_map<std::string, std::shared_ptr<type>> types;
+		static constexpr node_kind first_kind = node_kind::normal_block;
+		static constexpr node_kind last_kind = node_kind::restricted_block;
 
-		explicit base_block(utils::position_range range) :
-			statement(range)
+		explicit base_block(utils::position_range range, const node_kind kind) :
+			statement(range, kind)
 		{}
 	};
 
 	struct restricted_block final : base_block
-	{	
+	{
+		static constexpr node_kind first_kind = node_kind::restricted_block;
+		static constexpr node_kind last_kind = node_kind::restricted_block;
+
 		restricted_list body;
 
-		void visit(visitor* vst) override;
+		template <typename Visitor>
+		void visit(Visitor* vst);
 
 		explicit restricted_block(utils::position_range range)
-			: base_block(range)
+			: base_block(range, node_kind::restricted_block)
 		{}
 
 		explicit restricted_block(utils::position_range range, restricted_list body)
-			: base_block(range), body(std::move(body))
+			: base_block(range, node_kind::restricted_block), body(std::move(body))
 		{}
 	};
 
 	struct normal_block final : base_block
 	{
+		static constexpr node_kind first_kind = node_kind::normal_block;
+		static constexpr node_kind last_kind = node_kind::normal_block;
+
 		statement_list body;
 		
-		void visit(visitor* vst) override;
+		template <typename Visitor>
+		void visit(Visitor* vst);
 
 		explicit normal_block(utils::position_range range)
-			: base_block(range) {}
+			: base_block(range, node_kind::normal_block) {}
 
 		explicit normal_block(utils::position_range range, statement_list body)
-			: base_block(range), body(std::move(body)) {}
+			: base_block(range, node_kind::normal_block), body(std::move(body)) {}
 	};
 
 	struct expression_ final : statement
 	{
-		std::unique_ptr<expression::expression> value;
+		static constexpr node_kind first_kind = node_kind::expression_;
+		static constexpr node_kind last_kind = node_kind::expression_;
 
-		void visit(visitor* vst) override;
+		expression::expression* value;
 
-		explicit expression_(utils::position_range range, std::unique_ptr<expression::expression> value) :
-			statement(range), value(std::move(value)) {}
+		template <typename Visitor>
+		void visit(Visitor* vst);
+
+		explicit expression_(utils::position_range range, expression::expression* value) :
+			statement(range, node_kind::expression_), value(value) {}
 	};
 
 	struct ret final : statement
 	{
-		std::unique_ptr<expression::expression> value;
+		static constexpr node_kind first_kind = node_kind::ret;
+		static constexpr node_kind last_kind = node_kind::ret;
+
+		expression::expression* value;
 
-		void visit(visitor* vst) override;
+		template <typename Visitor>
+		void visit(Visitor* vst);
 
-		explicit ret(utils::position_range range, std::unique_ptr<expression::expression> return_value) :
-			statement(range), value(std::move(return_value)) {}
+		explicit ret(utils::position_range range, expression::expression* return_value) :
+			statement(range, node_kind::ret), value(return_value) {}
 	};
 
 	struct assignment final : statement
 	{
-		std::unique_ptr<expression::expression> to;
-		std::unique_ptr<expression::expression> from;
+		static constexpr node_kind first_kind = node_kind::assignment;
+		static constexpr node_kind last_kind = node_kind::assignment;
 
-		void visit(visitor* vst) override;
+		expression::expression* to;
+		expression::expression* from;
 
-		explicit assignment(utils::position_range range, std::unique_ptr<expression::expression> to, std::unique_ptr<expression::expression> from) :
-			statement(range),
-			to(std::move(to)),
-			from(std::move(from))
+		template <typename Visitor>
+		void visit(Visitor* vst);
+
+		explicit assignment(utils::position_range range, expression::expression* to, expression::expression* from) :
+			statement(range, node_kind::assignment),
+			to(to),
+			from(from)
 		{}
 	};
 
 	struct if_stat final : statement
 	{
-		std::unique_ptr<expression::expression> condition;
-		std::unique_ptr<normal_block> main_body;
-		std::unique_ptr<normal_block> else_body;
+		static constexpr node_kind first_kind = node_kind::if_stat;
+		static constexpr node_kind last_kind = node_kind::if_stat;
+
+		expression::expression* condition;
+		normal_block* main_body;
+		normal_block* else_body;
 		// elseif
 
-		void visit(visitor* vst) override;
+		template <typename Visitor>
+		void visit(Visitor* vst);
 		
 		explicit if_stat(utils::position_range range,
-			std::unique_ptr<expression::expression> condition,
-			std::unique_ptr<normal_block> main_body,
-			std::unique_ptr<normal_block> else_body) :
-			statement(range),
-			condition(std::move(condition)),
-			main_body(std::move(main_body)),
-			else_body(std::move(else_body)) {}
+			expression::expression* condition,
+			normal_block* main_body,
+			normal_block* else_body) :
+			statement(range, node_kind::if_stat),
+			condition(condition),
+			main_body(main_body),
+			else_body(else_body) {}
 	};
 	
 	struct loop : statement
 	{
+		static constexpr node_kind first_kind = node_kind::numerical_for_loop;
+		static constexpr node_kind last_kind = node_kind::while_loop;
+
 		// numberial for loop, range for loop
 		// initial, final, <optional step>
-		std::unique_ptr<normal_block> body;
-
-		void visit(visitor* vst) override;
+		normal_block* body;
 
-		explicit loop(utils::position_range range, std::unique_ptr<normal_block> body) :
-			statement(range), body(std::move(body)) {}
+	protected:
+		explicit loop(utils::position_range range, const node_kind kind, normal_block* body) :
+			statement(range, kind), body(body) {}
 	};
 
 	struct numerical_for_loop final : loop 
 	{
-		std::unique_ptr<expression::number_literal> initial; // used as variable
-		std::unique_ptr<expression::number_literal> final;
-		std::unique_ptr<expression::number_literal> step;
+		static constexpr node_kind first_kind = node_kind::numerical_for_loop;
+		static constexpr node_kind last_kind = node_kind::numerical_for_loop;
+
+		expression::number_literal* initial; // used as variable
+		expression::number_literal* final;
+		expression::number_literal* step;
 
-		void visit(visitor* vst) override;
+		template <typename Visitor>
+		void visit(Visitor* vst);
 
-		explicit numerical_for_loop(utils::position_range range, std::unique_ptr<expression::number_literal> initial,
-			std::unique_ptr<expression::number_literal> final, std::unique_ptr<expression::number_literal> step, std::unique_ptr<normal_block> body)
-				: loop(range, std::move(body)), 
-					initial(std::move(initial)), final(std::move(final)), step(std::move(step)) {}
+		explicit numerical_for_loop(utils::position_range range, expression::number_literal* initial,
+			expression::number_literal* final, expression::number_literal* step, normal_block* body)
+				: loop(range, node_kind::numerical_for_loop, body), 
+					initial(initial), final(final), step(step) {}
 	};
 	
 	struct while_loop final : loop
 	{
-		std::unique_ptr<expression::expression> condition;
+		static constexpr node_kind first_kind = node_kind::while_loop;
+		static constexpr node_kind last_kind = node_kind::while_loop;
 
-		void visit(visitor* vst) override;
+		expression::expression* condition;
 
-		explicit while_loop(utils::position_range range, std::unique_ptr<expression::expression> condition, std::unique_ptr<normal_block> body) :
-			loop(range, std::move(body)), condition(std::move(condition)) {}
+		template <typename Visitor>
+		void visit(Visitor* vst);
+
+		explicit while_loop(utils::position_range range, expression::expression* condition, normal_block* body) :
+			loop(range, node_kind::while_loop, body), condition(condition) {}
 	};
 
 	struct function_definition final : restricted
 	{
-		std::shared_ptr<expression::function_signature> signature;
-		std::unique_ptr<normal_block> body;
-		std::unordered_set<std::shared_ptr<expression::function_signature>> function_dependencies;
+		static constexpr node_kind first_kind = node_kind::function_definition;
+		static constexpr node_kind last_kind = node_kind::function_definition;
+
+		expression::function_signature* signature;
+		normal_block* body; // nullptr while the body is skipped, see parser::body_parsing.
+		std::size_t body_checkpoint = 0; // lexer checkpoint of the opening brace of a skipped body.
+		std::size_t body_types = 0; // number of type bindings visible to a skipped body, see parser::scoped_table::size.
+		flat_expressions* flat_body = nullptr; // expressions of the body in post-order, filled by the passes.
+		std::unordered_set<expression::function_signature*> function_dependencies;
 
-		void visit(visitor* vst) override;
+		template <typename Visitor>
+		void visit(Visitor* vst);
 
-		explicit function_definition(utils::position_range range, std::shared_ptr<expression::function_signature> signature, std::unique_ptr<normal_block> body) :
-			restricted(range), signature(signature), body(std::move(body)) {}
+		explicit function_definition(utils::position_range range, expression::function_signature* signature, normal_block* body) :
+			restricted(range, node_kind::function_definition), signature(signature), body(body) {}
 	};
 
 	struct extern_function_definition final : restricted
 	{
-		std::shared_ptr<expression::function_signature> signature;
+		static constexpr node_kind first_kind = node_kind::extern_function_definition;
+		static constexpr node_kind last_kind = node_kind::extern_function_definition;
 
-		void visit(visitor* vst);
+		expression::function_signature* signature;
 
-		explicit extern_function_definition(utils::position_range range, std::shared_ptr<expression::function_signature> signature) :
-			restricted(range),
+		template <typename Visitor>
+		void visit(Visitor* vst);
+
+		explicit extern_function_definition(utils::position_range range, expression::function_signature* signature) :
+			restricted(range, node_kind::extern_function_definition),
 			signature(signature)
 		{}
 	};
 
 	struct type_definition : restricted
 	{
+		static constexpr node_kind first_kind = node_kind::alias_type_definition;
+		static constexpr node_kind last_kind = node_kind::class_type_definition;
+
 		using restricted::restricted;
 	};
 
 	struct alias_type_definition final : type_definition
 	{
-		std::string name;
-		std::shared_ptr<type> target_type;
+		static constexpr node_kind first_kind = node_kind::alias_type_definition;
+		static constexpr node_kind last_kind = node_kind::alias_type_definition;
 
-		void visit(visitor* vst) override;
+		utils::symbol_id name;
+		type* target_type;
 
-		explicit alias_type_definition(utils::position_range range, std::string name, std::shared_ptr<type> target_type) :
-			type_definition(range), name(std::move(name)), target_type(std::move(target_type)) {}
+		template <typename Visitor>
+		void visit(Visitor* vst);
+
+		explicit alias_type_definition(utils::position_range range, const utils::symbol_id name, type* target_type) :
+			type_definition(range, node_kind::alias_type_definition), name(name), target_type(target_type) {}
 	};
 
 	struct class_type_definition final : type_definition
 	{
-		std::string name;
+		static constexpr node_kind first_kind = node_kind::class_type_definition;
+		static constexpr node_kind last_kind = node_kind::class_type_definition;
+
+		utils::symbol_id name;
 		expression::parameter_list fields;
-		std::unique_ptr<restricted_block> body;
+		restricted_block* body;
 
-		void visit(visitor* vst) override;
+		template <typename Visitor>
+		void visit(Visitor* vst);
 
-		explicit class_type_definition(utils::position_range range, std::string name, expression::parameter_list fields,
-			std::unique_ptr<restricted_block> body) :
-			type_definition(range),
-			name(std::move(name)),
+		explicit class_type_definition(utils::position_range range, const utils::symbol_id name, expression::parameter_list fields,
+			restricted_block* body) :
+			type_definition(range, node_kind::class_type_definition),
+			name(name),
 			fields(std::move(fields)),
-			body(std::move(body)) {}
+			body(body) {}
 	};
 }
@@ -16,6 +16,17 @@ namespace seam::ir::ast
 		
 	};
 
+	struct type;
+
+	struct optional_descriptor
+	{
+		type* value_type; // type of the value when present.
+	};
+
+	/**
+	 * A type, created by types::type_context only, which creates every type
+	 * once so types are compared by pointer.
+	 */
 	struct type
 	{
 		enum class built_in_type
@@ -36,7 +47,7 @@ namespace seam::ir::ast
 			f64
 		};
 
-		std::variant<built_in_type, class_descriptor> value;
+		std::variant<built_in_type, optional_descriptor, class_descriptor> value;
 
 		bool is(built_in_type t)
 		{
@@ -53,5 +64,9 @@ namespace seam::ir::ast
 		explicit type(built_in_type t) :
 			value(t)
 		{}
+
+		explicit type(optional_descriptor t) :
+			value(t)
+		{}
 	};
 }
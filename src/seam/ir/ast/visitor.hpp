@@ -3,44 +3,338 @@
 #include "node.hpp"
 #include "statement.hpp"
 
-#define BASE_VISITOR(c) virtual bool visit(c* a) { return true; }
-#define VISITOR(b, c) virtual bool visit(c* a) { return visit(static_cast<b*>(a)); }
+#include <type_traits>
+#include <utility>
+
+// Visitors are plain structs with `bool visit(T* node)` overloads for the node
+// types they are interested in, no base class or virtual functions involved.
+//
+// A node is handed to the overload for the most derived of its types the visitor
+// has one for (the usual overload resolution on pointer conversions), so an
+// overload for statement::statement sees every statement without a more specific
+// overload. Returning true visits the children of the node, returning false skips
+// them; nodes without any matching overload always have their children visited.
+//
+// Visitors may also have `void leave(T* node)` overloads, picked the same way and
+// called after the children of a node were visited, for a post-order walk. Nodes
+// whose visit returned false are not left either.
+//
+// Dispatch is a switch on node::kind, the visit overloads are called directly and
+// can be inlined into the traversal.
 
 namespace seam::ir::ast
 {
-    struct visitor
-    {
-        virtual ~visitor() = default;
-        
-        BASE_VISITOR(node);
-
-        VISITOR(node, expression::function_signature);
-        VISITOR(node, statement::statement);
-        VISITOR(node, expression::expression);
-    	
-        
-		VISITOR(statement::statement, statement::function_definition); 
-        VISITOR(statement::statement, statement::class_type_definition);
-        VISITOR(statement::statement, statement::alias_type_definition);
-        VISITOR(statement::statement, statement::restricted);
-        VISITOR(statement::statement, statement::restricted_block);
-        VISITOR(statement::statement, statement::normal_block);
-        VISITOR(statement::statement, statement::expression_);
-        VISITOR(statement::statement, statement::ret);
-        VISITOR(statement::statement, statement::while_loop);
-        VISITOR(statement::statement, statement::if_stat);
-        VISITOR(statement::statement, statement::assignment);
-        
-        VISITOR(statement::restricted, statement::extern_function_definition);
-
-        VISITOR(expression::expression, expression::variable_ref);
-        VISITOR(expression::expression, expression::symbol_wrapper);
-        VISITOR(expression::expression, expression::call);
-        VISITOR(expression::expression, expression::bool_literal);
-        VISITOR(expression::expression, expression::string_literal);
-		VISITOR(expression::expression, expression::number_literal);
-        VISITOR(expression::expression, expression::binary);
-    };
+	namespace detail
+	{
+		template <typename Visitor, typename T, typename = void>
+		struct has_visit : std::false_type {};
+
+		template <typename Visitor, typename T>
+		struct has_visit<Visitor, T, std::void_t<decltype(std::declval<Visitor&>().visit(std::declval<T*>()))>> : std::true_type {};
+
+		template <typename Visitor, typename T, typename = void>
+		struct has_leave : std::false_type {};
+
+		template <typename Visitor, typename T>
+		struct has_leave<Visitor, T, std::void_t<decltype(std::declval<Visitor&>().leave(std::declval<T*>()))>> : std::true_type {};
+
+		/**
+		 * Hands a node to the visitor.
+		 *
+		 * @returns whether the children of the node should be visited.
+		 */
+		template <typename Visitor, typename T>
+		bool enter(Visitor* vst, T* node)
+		{
+			if constexpr (has_visit<Visitor, T>::value)
+			{
+				return vst->visit(node);
+			}
+			else
+			{
+				return true;
+			}
+		}
+
+		/**
+		 * Hands a node to the visitor once its children were visited.
+		 */
+		template <typename Visitor, typename T>
+		void leave(Visitor* vst, T* node)
+		{
+			if constexpr (has_leave<Visitor, T>::value)
+			{
+				vst->leave(node);
+			}
+		}
+	}
+
+	template <typename Visitor>
+	void node::visit(Visitor* vst)
+	{
+		switch (kind)
+		{
+			case node_kind::unary: static_cast<expression::unary*>(this)->visit(vst); break;
+			case node_kind::binary: static_cast<expression::binary*>(this)->visit(vst); break;
+			case node_kind::variable_ref: static_cast<expression::variable_ref*>(this)->visit(vst); break;
+			case node_kind::call: static_cast<expression::call*>(this)->visit(vst); break;
+			case node_kind::symbol_wrapper: static_cast<expression::symbol_wrapper*>(this)->visit(vst); break;
+			case node_kind::bool_literal: static_cast<expression::bool_literal*>(this)->visit(vst); break;
+			case node_kind::string_literal: static_cast<expression::string_literal*>(this)->visit(vst); break;
+			case node_kind::number_literal: static_cast<expression::number_literal*>(this)->visit(vst); break;
+			case node_kind::function_signature: static_cast<expression::function_signature*>(this)->visit(vst); break;
+			case node_kind::normal_block: static_cast<statement::normal_block*>(this)->visit(vst); break;
+			case node_kind::restricted_block: static_cast<statement::restricted_block*>(this)->visit(vst); break;
+			case node_kind::expression_: static_cast<statement::expression_*>(this)->visit(vst); break;
+			case node_kind::ret: static_cast<statement::ret*>(this)->visit(vst); break;
+			case node_kind::assignment: static_cast<statement::assignment*>(this)->visit(vst); break;
+			case node_kind::if_stat: static_cast<statement::if_stat*>(this)->visit(vst); break;
+			case node_kind::numerical_for_loop: static_cast<statement::numerical_for_loop*>(this)->visit(vst); break;
+			case node_kind::while_loop: static_cast<statement::while_loop*>(this)->visit(vst); break;
+			case node_kind::function_definition: static_cast<statement::function_definition*>(this)->visit(vst); break;
+			case node_kind::extern_function_definition: static_cast<statement::extern_function_definition*>(this)->visit(vst); break;
+			case node_kind::alias_type_definition: static_cast<statement::alias_type_definition*>(this)->visit(vst); break;
+			case node_kind::class_type_definition: static_cast<statement::class_type_definition*>(this)->visit(vst); break;
+		}
+	}
 }
 
-#undef VISITOR
\ No newline at end of file
+namespace seam::ir::ast::expression
+{
+	template <typename Visitor>
+	void unary::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			right->visit(vst);
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void binary::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			left->visit(vst);
+			right->visit(vst);
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void variable_ref::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void call::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			function->visit(vst);
+			for (const auto& argument : arguments)
+			{
+				argument->visit(vst);
+			}
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void bool_literal::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void string_literal::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void number_literal::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void symbol_wrapper::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void function_signature::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			for (const auto& param : parameters)
+			{
+				param->visit(vst);
+			}
+			detail::leave(vst, this);
+		}
+	}
+}
+
+namespace seam::ir::ast::statement
+{
+	template <typename Visitor>
+	void restricted_block::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			for (const auto& statement : body)
+			{
+				statement->visit(vst);
+			}
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void function_definition::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			signature->visit(vst);
+			if (body)
+			{
+				body->visit(vst);
+			}
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void normal_block::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			for (const auto& statement : body)
+			{
+				statement->visit(vst);
+			}
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void expression_::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			value->visit(vst);
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void ret::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			if (value)
+			{
+				value->visit(vst);
+			}
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void assignment::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			from->visit(vst);
+			to->visit(vst);
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void if_stat::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			condition->visit(vst);
+			main_body->visit(vst);
+			if (else_body)
+			{
+				else_body->visit(vst);
+			}
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void numerical_for_loop::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			initial->visit(vst);
+			final->visit(vst);
+			step->visit(vst);
+			body->visit(vst);
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void while_loop::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			condition->visit(vst);
+			body->visit(vst);
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void extern_function_definition::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void alias_type_definition::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			detail::leave(vst, this);
+		}
+	}
+
+	template <typename Visitor>
+	void class_type_definition::visit(Visitor* vst)
+	{
+		if (detail::enter(vst, this))
+		{
+			body->visit(vst);
+			detail::leave(vst, this);
+		}
+	}
+}
@@ -125,7 +125,7 @@ namespace seam::lexer
 	{
 		lexeme_type type = lexeme_type::eof;
 		std::string_view value {};
-		utils::position position { 0, 0 };
+		utils::position position { 0 };
 
 		/**
 		 * Returns string which corresponds with type.
@@ -149,6 +149,7 @@ namespace seam::lexer
 				case lexeme_type::symbol_minus_assign: return "-=";
 				case lexeme_type::symbol_multiply: return "*";
 				case lexeme_type::symbol_multiply_assign: return "*=";
+				case lexeme_type::symbol_mod: return "%";
 				case lexeme_type::symbol_open_parenthesis: return "(";
 				case lexeme_type::symbol_close_parenthesis: return ")";
 				case lexeme_type::symbol_open_bracket: return "[";
@@ -168,6 +169,8 @@ namespace seam::lexer
 				case lexeme_type::symbol_lteq: return "<=";
 				case lexeme_type::symbol_gt: return ">";
 				case lexeme_type::symbol_gteq: return ">=";
+				case lexeme_type::symbol_and: return "&&";
+				case lexeme_type::symbol_or: return "||";
 				case lexeme_type::kw_fn: return "fn";
 				case lexeme_type::kw_as: return "as";
 				case lexeme_type::kw_return: return "return";
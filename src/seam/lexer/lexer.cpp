@@ -1,16 +1,25 @@
 #include "lexer.hpp"
+#include "scanner.hpp"
 #include "../utils/exception.hpp"
 
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
 #include <sstream>
 #include <cctype>
-#include <unordered_map>
 #include <unordered_set>
 #include <iostream>
 
 namespace seam::lexer
 {
-	using lexeme_map_t = std::unordered_map<std::string_view, lexeme_type>;
-	const lexeme_map_t keyword_map
+	struct keyword_entry
+	{
+		std::string_view spelling;
+		lexeme_type type = lexeme_type::identifier;
+	};
+
+	constexpr keyword_entry keywords[]
 	{
 		{ "fn", lexeme_type::kw_fn },
 		{ "as", lexeme_type::kw_as },
@@ -30,7 +39,73 @@ namespace seam::lexer
 		{ "extern", lexeme_type::kw_extern },
 	};
 
-	const lexeme_map_t symbol_map
+	constexpr std::size_t min_keyword_length = 2;
+	constexpr std::size_t max_keyword_length = 6;
+	constexpr std::size_t keyword_table_size = 32;
+
+	/**
+	 * Perfect hash over the keyword set, only valid for values of at least
+	 * min_keyword_length characters.
+	 *
+	 * @param value identifier to hash.
+	 * @returns slot in keyword_table.
+	 */
+	constexpr std::size_t keyword_hash(const std::string_view value)
+	{
+		return (value.size()
+			+ static_cast<unsigned char>(value[0]) * 5
+			+ static_cast<unsigned char>(value[1]) * 2) % keyword_table_size;
+	}
+
+	constexpr auto keyword_table = []
+	{
+		std::array<keyword_entry, keyword_table_size> table{};
+		for (const auto& keyword : keywords)
+		{
+			table[keyword_hash(keyword.spelling)] = keyword;
+		}
+		return table;
+	}();
+
+	constexpr bool is_keyword_table_perfect()
+	{
+		for (const auto& keyword : keywords)
+		{
+			if (keyword.spelling.size() < min_keyword_length || keyword.spelling.size() > max_keyword_length
+				|| keyword_table[keyword_hash(keyword.spelling)].spelling != keyword.spelling)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static_assert(is_keyword_table_perfect(), "keyword hash has collisions, pick new keyword_hash coefficients");
+
+	/**
+	 * Looks up the keyword spelled by value.
+	 *
+	 * @param value identifier to look up.
+	 * @returns keyword type, or lexeme_type::identifier if value is not a keyword.
+	 */
+	constexpr lexeme_type lookup_keyword(const std::string_view value)
+	{
+		if (value.size() < min_keyword_length || value.size() > max_keyword_length)
+		{
+			return lexeme_type::identifier;
+		}
+
+		const auto& entry = keyword_table[keyword_hash(value)];
+		return entry.spelling == value ? entry.type : lexeme_type::identifier;
+	}
+
+	struct symbol_definition
+	{
+		std::string_view spelling;
+		lexeme_type type;
+	};
+
+	constexpr symbol_definition symbols[]
 	{
 		{ "+", lexeme_type::symbol_add },
 		{ "+=", lexeme_type::symbol_add_assign },
@@ -62,26 +137,81 @@ namespace seam::lexer
 		{ "||", lexeme_type::symbol_or },
 	};
 
-	const std::unordered_set<std::string> attributes = { "constructor", "export" };
-	
-	bool is_start_identifier_char(const char value)
+	constexpr std::size_t max_symbol_follow = 2;
+
+	/**
+	 * Decision table entry for symbols starting with a given byte.
+	 *
+	 * lexeme_type::eof is used to mark missing symbols, as it can never be
+	 * produced by lex_symbol.
+	 */
+	struct symbol_entry
 	{
-		return std::isalpha(value) || value == '_';
-	}
+		lexeme_type single = lexeme_type::eof; // symbol made of the first byte alone.
+		char follow[max_symbol_follow] {}; // second bytes which extend the symbol.
+		lexeme_type follow_type[max_symbol_follow] { lexeme_type::eof, lexeme_type::eof };
+	};
 
-	bool is_identifier_char(const char value)
+	constexpr auto symbol_table = []
 	{
-		return std::isalnum(value) || value == '_';
-	}
+		std::array<symbol_entry, 256> table{};
+		for (const auto& symbol : symbols)
+		{
+			auto& entry = table[static_cast<unsigned char>(symbol.spelling[0])];
+			if (symbol.spelling.size() == 1)
+			{
+				entry.single = symbol.type;
+				continue;
+			}
+
+			for (std::size_t i = 0; i < max_symbol_follow; ++i)
+			{
+				if (entry.follow_type[i] == lexeme_type::eof)
+				{
+					entry.follow[i] = symbol.spelling[1];
+					entry.follow_type[i] = symbol.type;
+					break;
+				}
+			}
+		}
+		return table;
+	}();
 
-	bool is_keyword_char(const char value)
+	constexpr bool is_symbol_table_complete()
 	{
-		return value != '_' && !std::isupper(value);
+		for (const auto& symbol : symbols)
+		{
+			const auto& entry = symbol_table[static_cast<unsigned char>(symbol.spelling[0])];
+			if (symbol.spelling.size() == 1)
+			{
+				if (entry.single != symbol.type)
+				{
+					return false;
+				}
+				continue;
+			}
+
+			auto found = false;
+			for (std::size_t i = 0; i < max_symbol_follow; ++i)
+			{
+				found |= entry.follow[i] == symbol.spelling[1] && entry.follow_type[i] == symbol.type;
+			}
+
+			if (symbol.spelling.size() != 2 || !found)
+			{
+				return false;
+			}
+		}
+		return true;
 	}
+
+	static_assert(is_symbol_table_complete(), "symbol does not fit in symbol_table, increase max_symbol_follow");
+
+	const std::unordered_set<std::string> attributes = { "constructor", "export" };
 	
 	utils::position lexer::current_position() const
 	{
-		return { line_, read_offset_ - line_start_offset_ };
+		return { static_cast<std::uint32_t>(read_offset_) };
 	}
 	
 	char lexer::peek_character(const std::size_t offset) const
@@ -91,53 +221,34 @@ namespace seam::lexer
 	
 	void lexer::consume_character()
 	{
-		if (peek_character() == '\n')
-		{
-			++line_;
-			line_start_offset_ = read_offset_;
-		}
 		++read_offset_;
 	}
 
 	void lexer::skip_whitespace()
 	{
-		char next_character;
-		while ((next_character = peek_character()) != eof_character && std::isspace(next_character))
-		{
-			consume_character();
-		}
+		read_offset_ = scanner::skip_whitespace(source_, read_offset_);
 	}
 
-	void lexer::skip_comment(lexeme& ref)
+	void lexer::skip_comment()
 	{
-		consume_character();
-		const auto is_long_comment = peek_character() == '/';
+		// Consume //
+		read_offset_ += 2;
 
-		while (true)
+		if (peek_character() != '/')
 		{
-			const auto next_character = peek_character();
-			if (!is_long_comment && next_character == '\n')
-			{
-				consume_character();
-				return;
-			}
-
-			// There has got to be a better way to do this...
-			if (is_long_comment && next_character == '/' && peek_character(1) == '/' && peek_character(2) == '/')
-			{
-				consume_character();
-				consume_character();
-				consume_character();
-				return;
-			}
-
-			if (is_long_comment && next_character == eof_character)
-			{
-				throw utils::lexical_exception { current_position(), "unterminated long comment" };
-			}
+			read_offset_ = std::min(scanner::find_newline(source_, read_offset_) + 1, source_.length());
+			return;
+		}
 
-			consume_character();
+		const auto end_offset = scanner::find_long_comment_end(source_, read_offset_);
+		if (end_offset == std::string_view::npos)
+		{
+			read_offset_ = source_.length();
+			throw utils::lexical_exception { current_position(), "unterminated long comment" };
 		}
+
+		// Consume ///
+		read_offset_ = end_offset + 3;
 	}
 
 	void lexer::lex_string_literal(lexeme& ref)
@@ -161,6 +272,11 @@ namespace seam::lexer
 				return;
 			}
 
+			if (read_offset_ >= source_.length())
+			{
+				throw utils::lexical_exception{ ref.position, "unterminated string literal" };
+			}
+
 			consume_character();
 		}
 	}
@@ -168,37 +284,37 @@ namespace seam::lexer
 	void lexer::lex_number_literal(lexeme& ref)
 	{
 		const auto is_hex = peek_character() == '0' && peek_character(1) == 'x';
+		const auto is_binary = peek_character() == '0' && peek_character(1) == 'b';
 		auto is_float = false;
 
 		const auto start_offset = read_offset_;
 
-		if (is_hex)
+		if (is_hex || is_binary)
 		{
 			consume_character();
-			consume_character(); // Consume 0x.
+			consume_character(); // Consume 0x or 0b.
 		}
 
 		while (true)
 		{
 			if (peek_character() == '.')
 			{
+				if (is_hex || is_binary || is_float)
+				{
+					throw utils::lexical_exception{
+						current_position(),
+						"malformed number"
+					};
+				}
+
 				is_float = true;
 				consume_character();
 			}
 
-			if (is_hex && is_float)
-			{
-				throw utils::lexical_exception{
-					current_position(),
-					"malformed number"
-				};
-			}
-
-			const auto next_char = peek_character(); // Not yet parsed correctly I think?
+			const auto next_char = peek_character();
 			if ((is_hex ? std::isxdigit(next_char) : std::isdigit(next_char)) || next_char == '_')
 			{
 				consume_character();
-				//peek_character();
 			}
 			else
 			{
@@ -206,43 +322,34 @@ namespace seam::lexer
 			}
 		}
 
+		// Exponent of a decimal number, the sign is only part of it directly after the e.
+		if (!is_hex && !is_binary && (peek_character() == 'e' || peek_character() == 'E'))
+		{
+			const auto sign = peek_character(1) == '+' || peek_character(1) == '-';
+			if (std::isdigit(peek_character(sign ? 2 : 1)))
+			{
+				consume_character();
+				if (sign)
+				{
+					consume_character();
+				}
+			}
+		}
+
+		// Digits of the exponent followed by the type suffix (10u8, 1.5f32), validated when the literal is decoded.
+		read_offset_ = scanner::find_identifier_end(source_, read_offset_);
+
 		ref.value = source_.substr(start_offset, read_offset_ - start_offset);
 		ref.type = lexeme_type::literal_number;
 	}
 
 	void lexer::lex_keyword_or_identifier(lexeme& ref)
 	{
-		auto can_be_keyword = is_keyword_char(peek_character());
-
 		const auto start_offset = read_offset_;
-		consume_character();
-
-		while (true)
-		{
-			const auto next_char = peek_character();
-
-			if (!is_keyword_char(next_char))
-			{
-				can_be_keyword = false;
-			}
-
-			if (!is_identifier_char(next_char))
-			{
-				ref.type = lexeme_type::identifier;
-				ref.value = source_.substr(start_offset, read_offset_ - start_offset);
-				break;
-			}
-
-			consume_character();
-		}
+		read_offset_ = scanner::find_identifier_end(source_, read_offset_ + 1);
 
-		if (can_be_keyword)
-		{
-			if (const auto keyword_type = keyword_map.find(source_.substr(start_offset, read_offset_ - start_offset)); keyword_type != keyword_map.cend())
-			{
-				ref.type = keyword_type->second;
-			}
-		}
+		ref.value = source_.substr(start_offset, read_offset_ - start_offset);
+		ref.type = lookup_keyword(ref.value);
 	}
 
 	void lexer::lex_attribute(lexeme& ref)
@@ -251,7 +358,7 @@ namespace seam::lexer
 
 		const auto start_offset = read_offset_;
 
-		if (!is_start_identifier_char(peek_character()))
+		if (!scanner::is(peek_character(), scanner::identifier_start))
 		{
 			throw utils::lexical_exception{
 				current_position(),
@@ -259,67 +366,106 @@ namespace seam::lexer
 			};
 		}
 
-		consume_character();
+		read_offset_ = scanner::find_identifier_end(source_, read_offset_ + 1);
+		ref.type = lexeme_type::attribute;
 
-		while (true)
+		const auto proposed_attribute = source_.substr(start_offset, read_offset_ - start_offset);
+		if (attributes.find(std::string{ proposed_attribute }) == attributes.cend())
 		{
-			const auto next_char = peek_character();
-
-			if (!is_identifier_char(next_char))
-			{
-				ref.type = lexeme_type::attribute;
-
-				const auto proposed_attribute = source_.substr(start_offset, read_offset_ - start_offset);
-				if (attributes.find(std::string{ proposed_attribute }) == attributes.cend())
-				{
-					std::stringstream error_message;
-					error_message << "unknown attribute: '" << proposed_attribute << "'";
-					throw utils::lexical_exception{ current_position(), error_message.str() };
-				}
-
-				ref.value = proposed_attribute;
-				break;
-			}
-
-			consume_character();
+			std::stringstream error_message;
+			error_message << "unknown attribute: '" << proposed_attribute << "'";
+			throw utils::lexical_exception{ current_position(), error_message.str() };
 		}
+
+		ref.value = proposed_attribute;
 	}
 
 	void lexer::lex_symbol(lexeme& ref)
 	{
-		// TODO: REFACTOR THIS
 		const auto start_offset = read_offset_;
-
+		const auto& entry = symbol_table[static_cast<unsigned char>(peek_character())];
 		consume_character();
-		lexeme_map_t::const_iterator symbol;
-		if (peek_character(1) != eof_character && (symbol = symbol_map.find(source_.substr(start_offset, 2))) != symbol_map.cend())
-		{
-			consume_character();
-			ref.type = symbol->second;
-		}
-		else if (symbol = symbol_map.find(source_.substr(start_offset, 1)); symbol != symbol_map.cend())
+
+		// Maximal munch, prefer the two character form.
+		const auto next_character = peek_character();
+		for (std::size_t i = 0; i < max_symbol_follow; ++i)
 		{
-			ref.type = symbol->second;
+			if (entry.follow_type[i] != lexeme_type::eof && entry.follow[i] == next_character)
+			{
+				consume_character();
+				ref.type = entry.follow_type[i];
+				ref.value = source_.substr(start_offset, 2);
+				return;
+			}
 		}
-		else
+
+		if (entry.single == lexeme_type::eof)
 		{
 			throw utils::lexical_exception{
 				current_position(),
 				"unexpected symbol"
 			};
 		}
+
+		ref.type = entry.single;
+		ref.value = source_.substr(start_offset, 1);
 	}
 	
-	lexer::lexer(std::shared_ptr<types::module> current_module, const std::string_view& source)
-		: current_module(current_module), source_(source) {}
+	lexer::lexer(std::shared_ptr<types::module> current_module, const std::string_view& source, const lexer_mode mode)
+		: current_module(current_module), source_(source), mode_(mode)
+	{
+		if (source_.length() > std::numeric_limits<std::uint32_t>::max())
+		{
+			throw utils::lexical_exception{ { 0 }, "source file is too large" };
+		}
+	}
+
+	lexer::lexer(std::shared_ptr<types::module> current_module, std::shared_ptr<const token_buffer> tokens)
+		: current_module(current_module), source_(tokens->source), mode_(lexer_mode::batched), tokens_(std::move(tokens))
+	{}
+
+	std::shared_ptr<const token_buffer> lexer::tokenize(std::shared_ptr<types::module> current_module, const std::string_view source)
+	{
+		lexer source_lexer{ std::move(current_module), source };
+
+		auto tokens = std::make_shared<token_buffer>();
+		tokens->source = source;
+
+		// Generated code averages a token every 3-4 bytes.
+		const auto expected_tokens = source.length() / 3;
+		tokens->types.reserve(expected_tokens);
+		tokens->offsets.reserve(expected_tokens);
+		tokens->lengths.reserve(expected_tokens);
+
+		lexeme current;
+		do
+		{
+			source_lexer.lex(current);
+			tokens->push_back(current.type, current.position.offset,
+				static_cast<std::uint32_t>(source_lexer.read_offset_ - current.position.offset));
+		} while (current.type != lexeme_type::eof);
+
+		return tokens;
+	}
+
+	bool lexer::on_same_line(const utils::position start, const utils::position end) const
+	{
+		return scanner::find_newline(source_.substr(0, end.offset), start.offset) == end.offset;
+	}
 
 
 
 	void lexer::lex(lexeme& ref)
 	{
 		skip_whitespace();
+		while (peek_character() == '/' && peek_character(1) == '/')
+		{
+			skip_comment();
+			skip_whitespace();
+		}
 
 		ref.position = current_position();
+		ref.value = {};
 
 		switch (peek_character())
 		{
@@ -328,25 +474,19 @@ namespace seam::lexer
 				ref.type = lexeme_type::eof;
 				break;
 			}
-			case '/': // Comment or division operations.
+			case '/': // Division operations.
 			{
 				consume_character();
-				const auto next_character = peek_character();
 
-				if (next_character == '/') // Is a comment.
-				{
-					skip_comment(ref);
-					next_lexeme();
-					break;
-				}
-
-				if (next_character == '=') // Divide-Assign operator.
+				if (peek_character() == '=') // Divide-Assign operator.
 				{
 					consume_character();
 					ref.type = lexeme_type::symbol_divide_assign;
+					ref.value = source_.substr(ref.position.offset, 2);
 					break;
 				}
 				ref.type = lexeme_type::symbol_divide; // Otherwise - just divide symbol.
+				ref.value = source_.substr(ref.position.offset, 1);
 				break;
 			}
 			case '"': // String literal.
@@ -362,13 +502,13 @@ namespace seam::lexer
 			}			
 			default:
 			{
-				if (is_start_identifier_char(peek_character())) // Must be keyword or identifier.
+				if (scanner::is(peek_character(), scanner::identifier_start)) // Must be keyword or identifier.
 				{
 					lex_keyword_or_identifier(ref);
 					return;
 				}
 					
-				if (std::isdigit(peek_character())) // Number literal.
+				if (scanner::is(peek_character(), scanner::digit)) // Number literal.
 				{
 					lex_number_literal(ref);
 					return;
@@ -380,26 +520,92 @@ namespace seam::lexer
 		}	
 	}
 
-	lexeme& lexer::peek_lexeme()
+	const token_buffer& lexer::tokens()
+	{
+		if (!tokens_)
+		{
+			tokens_ = tokenize(current_module, source_);
+		}
+		return *tokens_;
+	}
+
+	constexpr auto lookahead_mask = lexer::max_lookahead;
+	static_assert(((lexer::max_lookahead + 1) & lookahead_mask) == 0, "lookahead ring size must be a power of two");
+
+	void lexer::produce(lexeme& ref)
+	{
+		if (mode_ == lexer_mode::batched)
+		{
+			// Keep returning eof once the buffer is exhausted.
+			const auto& buffer = tokens();
+			buffer.read(std::min(next_token_++, buffer.size() - 1), ref);
+			return;
+		}
+
+		lex(ref);
+	}
+
+	const lexeme& lexer::peek_lexeme(const std::size_t distance)
 	{
-		if (!peeked_lexeme_)
+		if (distance == 0 || distance > max_lookahead)
+		{
+			throw std::out_of_range{ "lookahead distance out of range" };
+		}
+
+		while (lookahead_count_ < distance)
 		{
-			peeked_lexeme_ = lexeme{};
-			lex(*peeked_lexeme_);
+			produce(lookahead_[(current_index_ + ++lookahead_count_) & lookahead_mask]);
 		}
-		return *peeked_lexeme_;
+		return lookahead_[(current_index_ + distance) & lookahead_mask];
 	}
 
 	void lexer::next_lexeme()
 	{
-		if (peeked_lexeme_)
+		// Lexemes are produced in place, moving only advances the ring.
+		current_index_ = (current_index_ + 1) & lookahead_mask;
+		if (lookahead_count_ > 0)
+		{
+			--lookahead_count_;
+			return;
+		}
+
+		produce(lookahead_[current_index_]);
+	}
+
+	std::size_t lexer::checkpoint() const
+	{
+		if (mode_ == lexer_mode::batched)
 		{
-			current_ = peeked_lexeme_;
-			peeked_lexeme_.reset();
+			return next_token_ - lookahead_count_ - 1;
+		}
+
+		return current_lexeme().position.offset;
+	}
+
+	void lexer::restore(const std::size_t checkpoint)
+	{
+		if (mode_ == lexer_mode::batched)
+		{
+			next_token_ = checkpoint;
 		}
 		else
 		{
-			lex(*current_);
+			read_offset_ = checkpoint;
 		}
+
+		lookahead_count_ = 0;
+		produce(lookahead_[current_index_]);
+	}
+
+	void lexer::seek(const utils::position position)
+	{
+		if (mode_ == lexer_mode::batched)
+		{
+			const auto& offsets = tokens().offsets;
+			restore(std::lower_bound(offsets.cbegin(), offsets.cend(), position.offset) - offsets.cbegin());
+			return;
+		}
+
+		restore(position.offset);
 	}
 }
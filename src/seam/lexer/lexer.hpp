@@ -1,14 +1,25 @@
 #pragma once
 
 #include "lexeme.hpp"
+#include "token_buffer.hpp"
 #include "../utils/position.hpp"
 #include "../types/module.hpp"
 
+#include <array>
+#include <cstddef>
 #include <memory>
-#include <optional>
 
 namespace seam::lexer
 {
+	/**
+	 * How a lexer produces lexemes.
+	 */
+	enum class lexer_mode
+	{
+		streaming, // lex one lexeme at a time, on demand.
+		batched, // tokenize the whole source into a token_buffer on first use.
+	};
+
 	/**
 	 * Implementation of lexer.
 	 */
@@ -21,18 +32,22 @@ namespace seam::lexer
 		std::string_view source_;
 
 		std::size_t read_offset_ = 0;
-		std::size_t line_ = 1;
-		std::size_t line_start_offset_ = 0;
+
+		lexer_mode mode_;
+		std::shared_ptr<const token_buffer> tokens_; // batched mode only.
+		std::size_t next_token_ = 0; // index of the next token in tokens_.
 		
-		std::optional<lexeme> current_;
-		std::optional<lexeme> peeked_lexeme_;
+		// Ring of the current lexeme followed by lexemes already lexed ahead of it.
+		std::array<lexeme, 8> lookahead_ {};
+		std::size_t current_index_ = 0; // slot of the current lexeme.
+		std::size_t lookahead_count_ = 0; // lexemes buffered after the current one.
 
 		[[nodiscard]] utils::position current_position() const;
 		[[nodiscard]] char peek_character(std::size_t offset = 0) const;
 		void consume_character();
 		
 		void skip_whitespace();
-		void skip_comment(lexeme& ref);
+		void skip_comment();
 		void lex_string_literal(lexeme& ref);
 		void lex_number_literal(lexeme& ref);
 		void lex_keyword_or_identifier(lexeme& ref);
@@ -40,21 +55,67 @@ namespace seam::lexer
 		void lex_symbol(lexeme& ref);
 
 		void lex(lexeme& ref);
+
+		/**
+		 * Produces the next lexeme, lexing it or reading it from the token buffer.
+		 */
+		void produce(lexeme& ref);
+
+		/**
+		 * Returns the token buffer, tokenizing the source on first use.
+		 */
+		const token_buffer& tokens();
 	public:
+		/**
+		 * Maximum number of lexemes that can be peeked past the current one.
+		 */
+		static constexpr std::size_t max_lookahead = std::tuple_size_v<decltype(lookahead_)> - 1;
+
 		/**
 		 * Initialise lexer with source to lex.
 		 *
 		 * @param source source to lex.
+		 * @param mode whether to lex on demand or tokenize the whole source up front.
+		 * @throws lexical_exception if source is too large to be addressed by utils::position.
+		 */
+		explicit lexer(std::shared_ptr<types::module> current_module, const std::string_view& source,
+			lexer_mode mode = lexer_mode::streaming);
+
+		/**
+		 * Initialise lexer over an already tokenized source.
+		 *
+		 * @param tokens tokens to read, see tokenize.
+		 */
+		explicit lexer(std::shared_ptr<types::module> current_module, std::shared_ptr<const token_buffer> tokens);
+
+		/**
+		 * Tokenizes a whole source file.
+		 *
+		 * @param source source to tokenize.
+		 * @returns tokens of source, ending with an eof token.
+		 * @throws lexical_exception if lexing fails.
+		 */
+		static std::shared_ptr<const token_buffer> tokenize(std::shared_ptr<types::module> current_module, std::string_view source);
+
+		/**
+		 * Checks whether two positions are on the same line.
+		 *
+		 * @param start first position.
+		 * @param end second position, not before start.
+		 * @returns true if there is no newline between start and end.
 		 */
-		explicit lexer(std::shared_ptr<types::module> current_module, const std::string_view& source);
+		[[nodiscard]] bool on_same_line(utils::position start, utils::position end) const;
 
 		/**
 		 * Peeks a future lexeme.
 		 *
 		 * @note does not automatically move to the next lexeme.
-		 * @return current lexeme held in lexer.
+		 * @param distance how far past the current lexeme to look, 1 is the next lexeme.
+		 * @return lexeme distance lexemes after the current one, valid until the lexer moves.
+		 * @throws lexical_exception if lexing fails.
+		 * @throws std::out_of_range if distance is 0 or greater than max_lookahead.
 		 */
-		lexeme& peek_lexeme();
+		const lexeme& peek_lexeme(std::size_t distance = 1);
 		
 		/**
 		 * Retrieves the current lexeme.
@@ -62,7 +123,7 @@ namespace seam::lexer
 		 * @note does not automatically move to the next lexeme.
 		 * @return current lexeme held in lexer.
 		 */
-		[[nodiscard]] const lexeme& current_lexeme() const { return *current_; }
+		[[nodiscard]] const lexeme& current_lexeme() const { return lookahead_[current_index_]; }
 
 		/**
 		 * Moves the lexer to the next lexeme.
@@ -70,5 +131,29 @@ namespace seam::lexer
 		 * @throws lexical_exception if lexing fails.
 		 */
 		void next_lexeme();
+
+		/**
+		 * Takes a checkpoint at the current lexeme.
+		 *
+		 * @returns checkpoint to pass to restore, a source offset when streaming
+		 * and a token index when batched.
+		 */
+		[[nodiscard]] std::size_t checkpoint() const;
+
+		/**
+		 * Moves the lexer to a checkpoint, making the lexeme it was taken at current again.
+		 *
+		 * @param checkpoint checkpoint taken by this lexer (or one over the same tokens).
+		 * @throws lexical_exception if lexing fails.
+		 */
+		void restore(std::size_t checkpoint);
+
+		/**
+		 * Moves the lexer to the first lexeme starting at or after a source position.
+		 *
+		 * @param position start of a lexeme, or of whitespace or comments before one.
+		 * @throws lexical_exception if lexing fails.
+		 */
+		void seek(utils::position position);
 	};
 }
@@ -0,0 +1,21 @@
+#include "line_index.hpp"
+#include "scanner.hpp"
+
+#include <algorithm>
+
+namespace seam::lexer
+{
+	line_index::line_index(const std::string_view source) :
+		newline_offsets_(scanner::find_newlines(source))
+	{}
+
+	line_index::location line_index::locate(const utils::position position) const
+	{
+		// Number of newlines before position.
+		const auto line = static_cast<std::size_t>(std::lower_bound(newline_offsets_.cbegin(), newline_offsets_.cend(), position.offset)
+			- newline_offsets_.cbegin());
+		const std::size_t line_start_offset = line == 0 ? 0 : newline_offsets_[line - 1] + 1;
+
+		return { line + 1, position.offset - line_start_offset + 1 };
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "../utils/position.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace seam::lexer
+{
+	/**
+	 * Newline table of a source file, used to turn byte offsets into
+	 * line and column numbers for diagnostics.
+	 */
+	class line_index
+	{
+		std::vector<std::uint32_t> newline_offsets_;
+
+	public:
+		/**
+		 * Line and column of a position, both starting at 1.
+		 */
+		struct location
+		{
+			std::size_t line;
+			std::size_t column;
+		};
+
+		/**
+		 * Builds the newline table of source.
+		 *
+		 * @param source source to index.
+		 */
+		explicit line_index(std::string_view source);
+
+		/**
+		 * Resolves position to a line and column.
+		 *
+		 * @param position position to resolve.
+		 * @returns line and column of position.
+		 */
+		[[nodiscard]] location locate(utils::position position) const;
+	};
+}
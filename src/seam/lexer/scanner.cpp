@@ -0,0 +1,210 @@
+#include "scanner.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SEAM_SCANNER_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SEAM_SCANNER_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace seam::lexer::scanner
+{
+	namespace
+	{
+#if defined(SEAM_SCANNER_AVX2) || defined(SEAM_SCANNER_SSE2)
+#define SEAM_SCANNER_SIMD
+		using mask_t = std::uint32_t;
+
+#if defined(SEAM_SCANNER_AVX2)
+		using block = __m256i;
+		constexpr std::size_t block_size = 32;
+
+		block load(const char* data) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data)); }
+		block splat(const char value) { return _mm256_set1_epi8(value); }
+		block equal(const block a, const block b) { return _mm256_cmpeq_epi8(a, b); }
+		block greater(const block a, const block b) { return _mm256_cmpgt_epi8(a, b); }
+		block either(const block a, const block b) { return _mm256_or_si256(a, b); }
+		block both(const block a, const block b) { return _mm256_and_si256(a, b); }
+		mask_t to_mask(const block value) { return static_cast<mask_t>(_mm256_movemask_epi8(value)); }
+#else
+		using block = __m128i;
+		constexpr std::size_t block_size = 16;
+
+		block load(const char* data) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)); }
+		block splat(const char value) { return _mm_set1_epi8(value); }
+		block equal(const block a, const block b) { return _mm_cmpeq_epi8(a, b); }
+		block greater(const block a, const block b) { return _mm_cmpgt_epi8(a, b); }
+		block either(const block a, const block b) { return _mm_or_si128(a, b); }
+		block both(const block a, const block b) { return _mm_and_si128(a, b); }
+		mask_t to_mask(const block value) { return static_cast<mask_t>(_mm_movemask_epi8(value)); }
+#endif
+
+		constexpr auto full_mask = static_cast<mask_t>((std::uint64_t{ 1 } << block_size) - 1);
+
+		// Signed comparisons, bytes above 0x7f are negative and never fall in an ASCII range.
+		block in_range(const block value, const char low, const char high)
+		{
+			return both(greater(value, splat(static_cast<char>(low - 1))), greater(splat(static_cast<char>(high + 1)), value));
+		}
+
+		block classify_whitespace(const block value)
+		{
+			return either(equal(value, splat(' ')), in_range(value, '\t', '\r'));
+		}
+
+		block classify_identifier(const block value)
+		{
+			const auto letters = in_range(either(value, splat(0x20)), 'a', 'z');
+			const auto digits = in_range(value, '0', '9');
+			return either(either(letters, digits), equal(value, splat('_')));
+		}
+
+		std::size_t count_trailing_zeros(const mask_t value)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward(&index, value);
+			return index;
+#else
+			return static_cast<std::size_t>(__builtin_ctz(value));
+#endif
+		}
+
+#endif
+	}
+
+	std::size_t skip_whitespace(const std::string_view source, std::size_t offset)
+	{
+		const auto data = source.data();
+		const auto size = source.size();
+
+#ifdef SEAM_SCANNER_SIMD
+		while (offset + block_size <= size)
+		{
+			if (const auto stop = ~to_mask(classify_whitespace(load(data + offset))) & full_mask)
+			{
+				return offset + count_trailing_zeros(stop);
+			}
+			offset += block_size;
+		}
+#endif
+
+		while (offset < size && is(data[offset], whitespace))
+		{
+			++offset;
+		}
+		return offset;
+	}
+
+	std::size_t find_identifier_end(const std::string_view source, std::size_t offset)
+	{
+		const auto data = source.data();
+		const auto size = source.size();
+
+#ifdef SEAM_SCANNER_SIMD
+		while (offset + block_size <= size)
+		{
+			if (const auto stop = ~to_mask(classify_identifier(load(data + offset))) & full_mask)
+			{
+				return offset + count_trailing_zeros(stop);
+			}
+			offset += block_size;
+		}
+#endif
+
+		while (offset < size && is(data[offset], identifier))
+		{
+			++offset;
+		}
+		return offset;
+	}
+
+	std::size_t find_newline(const std::string_view source, std::size_t offset)
+	{
+		const auto data = source.data();
+		const auto size = source.size();
+
+#ifdef SEAM_SCANNER_SIMD
+		while (offset + block_size <= size)
+		{
+			if (const auto newlines = to_mask(equal(load(data + offset), splat('\n'))))
+			{
+				return offset + count_trailing_zeros(newlines);
+			}
+			offset += block_size;
+		}
+#endif
+
+		while (offset < size && data[offset] != '\n')
+		{
+			++offset;
+		}
+		return offset;
+	}
+
+	std::size_t find_long_comment_end(const std::string_view source, std::size_t offset)
+	{
+		const auto data = source.data();
+		const auto size = source.size();
+
+#ifdef SEAM_SCANNER_SIMD
+		// Each block is compared at three shifted positions so "///" straddling
+		// two blocks is still found.
+		const auto slash = splat('/');
+		while (offset + block_size + 2 <= size)
+		{
+			if (const auto terminators = to_mask(both(both(equal(load(data + offset), slash), equal(load(data + offset + 1), slash)),
+				equal(load(data + offset + 2), slash))))
+			{
+				return offset + count_trailing_zeros(terminators);
+			}
+			offset += block_size;
+		}
+#endif
+
+		for (; offset + 2 < size; ++offset)
+		{
+			if (data[offset] == '/' && data[offset + 1] == '/' && data[offset + 2] == '/')
+			{
+				return offset;
+			}
+		}
+		return std::string_view::npos;
+	}
+
+	std::vector<std::uint32_t> find_newlines(const std::string_view source)
+	{
+		const auto data = source.data();
+		const auto size = source.size();
+
+		std::vector<std::uint32_t> newlines;
+		newlines.reserve(size / 32);
+
+		std::size_t offset = 0;
+
+#ifdef SEAM_SCANNER_SIMD
+		const auto newline = splat('\n');
+		for (; offset + block_size <= size; offset += block_size)
+		{
+			for (auto mask = to_mask(equal(load(data + offset), newline)); mask; mask &= mask - 1)
+			{
+				newlines.push_back(static_cast<std::uint32_t>(offset + count_trailing_zeros(mask)));
+			}
+		}
+#endif
+
+		for (; offset < size; ++offset)
+		{
+			if (data[offset] == '\n')
+			{
+				newlines.push_back(static_cast<std::uint32_t>(offset));
+			}
+		}
+		return newlines;
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace seam::lexer::scanner
+{
+	enum character_class : std::uint8_t
+	{
+		whitespace = 1 << 0,
+		identifier_start = 1 << 1,
+		identifier = 1 << 2,
+		digit = 1 << 3,
+	};
+
+	constexpr auto character_classes = []
+	{
+		std::array<std::uint8_t, 256> table{};
+		for (const auto c : { ' ', '\t', '\n', '\v', '\f', '\r' })
+		{
+			table[static_cast<unsigned char>(c)] |= whitespace;
+		}
+
+		for (auto c = 'a'; c <= 'z'; ++c)
+		{
+			table[static_cast<unsigned char>(c)] |= identifier_start | identifier;
+			table[static_cast<unsigned char>(c - 'a' + 'A')] |= identifier_start | identifier;
+		}
+
+		for (auto c = '0'; c <= '9'; ++c)
+		{
+			table[static_cast<unsigned char>(c)] |= identifier | digit;
+		}
+
+		table['_'] |= identifier_start | identifier;
+		return table;
+	}();
+
+	constexpr bool is(const char value, const character_class type)
+	{
+		return character_classes[static_cast<unsigned char>(value)] & type;
+	}
+
+	/**
+	 * Skips a run of whitespace.
+	 *
+	 * @param source source being scanned.
+	 * @param offset offset to start scanning at.
+	 * @returns offset of the first non-whitespace character, or source size.
+	 */
+	std::size_t skip_whitespace(std::string_view source, std::size_t offset);
+
+	/**
+	 * Finds the end of an identifier.
+	 *
+	 * @param source source being scanned.
+	 * @param offset offset to start scanning at.
+	 * @returns offset of the first non-identifier character, or source size.
+	 */
+	std::size_t find_identifier_end(std::string_view source, std::size_t offset);
+
+	/**
+	 * Finds the next newline.
+	 *
+	 * @param source source being scanned.
+	 * @param offset offset to start scanning at.
+	 * @returns offset of the newline, or source size.
+	 */
+	std::size_t find_newline(std::string_view source, std::size_t offset);
+
+	/**
+	 * Finds the terminator ("///") of a long comment.
+	 *
+	 * @param source source being scanned.
+	 * @param offset offset to start scanning at.
+	 * @returns offset of the terminator, or std::string_view::npos if there is none.
+	 */
+	std::size_t find_long_comment_end(std::string_view source, std::size_t offset);
+
+	/**
+	 * Collects the offset of every newline.
+	 *
+	 * @param source source being scanned.
+	 * @returns offsets of all newlines, in ascending order.
+	 */
+	std::vector<std::uint32_t> find_newlines(std::string_view source);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "lexeme.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+namespace seam::lexer
+{
+	static_assert(static_cast<std::size_t>(lexeme_type::kw_extern) <= std::numeric_limits<std::uint8_t>::max(),
+		"lexeme_type no longer fits in token_buffer::types");
+
+	/**
+	 * A fully tokenized source file, stored as a structure of arrays.
+	 *
+	 * Produced by lexer::tokenize, a token buffer can be cached and handed to
+	 * any number of lexers (and so parsers) over the same source.
+	 */
+	struct token_buffer
+	{
+		std::string_view source; // source the tokens refer to.
+
+		std::vector<std::uint8_t> types; // lexeme_type of each token.
+		std::vector<std::uint32_t> offsets; // offset of the first character of each token.
+		std::vector<std::uint32_t> lengths; // length of each token in source, including quotes and '@'.
+
+		/**
+		 * Returns the number of tokens, including the trailing eof token.
+		 */
+		[[nodiscard]] std::size_t size() const { return types.size(); }
+
+		/**
+		 * Appends a token.
+		 *
+		 * @param type type of the token.
+		 * @param offset offset of the first character of the token.
+		 * @param length length of the token in source.
+		 */
+		void push_back(const lexeme_type type, const std::uint32_t offset, const std::uint32_t length)
+		{
+			types.push_back(static_cast<std::uint8_t>(type));
+			offsets.push_back(offset);
+			lengths.push_back(length);
+		}
+
+		/**
+		 * Materialises a token into an existing lexeme.
+		 *
+		 * @param index index of the token.
+		 * @param ref lexeme to overwrite, ends up equal to the one the lexer produced for this token.
+		 */
+		void read(const std::size_t index, lexeme& ref) const
+		{
+			// Fields are written in place, building a temporary and copying it
+			// over costs a store-forwarding stall per token.
+			const auto offset = offsets[index];
+			const auto length = lengths[index];
+
+			ref.type = static_cast<lexeme_type>(types[index]);
+			ref.position.offset = offset;
+			switch (ref.type)
+			{
+				case lexeme_type::eof:
+				{
+					ref.value = {};
+					break;
+				}
+				case lexeme_type::literal_string: // "value"
+				{
+					ref.value = { source.data() + offset + 1, length - 2 };
+					break;
+				}
+				case lexeme_type::attribute: // @value
+				{
+					ref.value = { source.data() + offset + 1, length - 1 };
+					break;
+				}
+				default:
+				{
+					ref.value = { source.data() + offset, length };
+					break;
+				}
+			}
+		}
+
+		/**
+		 * Materialises a token as a lexeme.
+		 *
+		 * @param index index of the token.
+		 * @returns lexeme equal to the one the lexer produced for this token.
+		 */
+		[[nodiscard]] lexeme at(const std::size_t index) const
+		{
+			lexeme result;
+			read(index, result);
+			return result;
+		}
+	};
+}
@@ -2,9 +2,17 @@
 
 #include "parser.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
 #include <iostream>
+#include <stdexcept>
+#include <thread>
 
 #include "../utils/exception.hpp"
+#include "../utils/work_stealing.hpp"
 #include "passes/pass.hpp"
 
 namespace seam::parser
@@ -26,44 +34,12 @@ namespace seam::parser
 		}
 	}
 
-	std::shared_ptr<ir::ast::expression::variable> get_variable_from_block(ir::ast::statement::base_block* block, const std::string& variable_name)
-	{
-		const auto& it = block->variables.find(variable_name);
-		if (it != block->variables.cend())
-		{
-			return it->second;
-		}
-
-		if (!block->parent)
-		{
-			return nullptr;
-		}
-
-		return get_variable_from_block(block->parent, variable_name);
-	}
-
-	std::shared_ptr<ir::ast::type> get_type_from_block(ir::ast::statement::base_block* block, const std::string& type_name)
-	{
-		const auto& it = block->types.find(type_name);
-		if (it != block->types.cend())
-		{
-			return it->second;
-		}
-
-		if (!block->parent)
-		{
-			return nullptr;
-		}
-
-		return get_type_from_block(block->parent, type_name);
-	}
-
-	std::shared_ptr<ir::ast::type> parser::parse_type()
+	ir::ast::type* parser::parse_type()
 	{
 		const auto start_position = lexer_.current_lexeme().position;
 		expect(lexer::lexeme_type::identifier);
 
-		auto target_type_name = std::string{ lexer_.current_lexeme().value };
+		const auto target_type_name = lexer_.current_lexeme().value;
 		lexer_.next_lexeme();
 
 		bool is_optional = false;
@@ -73,7 +49,7 @@ namespace seam::parser
 			is_optional = true;
 		}
 
-		const auto type = get_type_from_block(current_block, target_type_name);
+		const auto type = types_.find(intern(target_type_name));
 
 		if (!type)
 		{
@@ -82,24 +58,24 @@ namespace seam::parser
 			throw utils::parser_exception{ start_position, error_message.str() };
 		}
 
-		return type;
+		return is_optional ? current_module->types.optional(type) : type;
 	}
 
-	std::unique_ptr<ir::ast::expression::parameter> parser::parse_parameter()
+	ir::ast::expression::parameter* parser::parse_parameter()
 	{
 		const auto start_position = lexer_.current_lexeme().position;
 		// Verify next token is parameter name (identifier)
 		expect(lexer::lexeme_type::identifier);
 
-		const auto parameter_name = std::string{ lexer_.current_lexeme().value };
+		const auto parameter_name = intern(lexer_.current_lexeme().value);
 		lexer_.next_lexeme();
 
 		// Check for colon preceding parameter type
 		expect(lexer::lexeme_type::symbol_colon, true);
 
-		return std::make_unique<ir::ast::expression::variable_ref>(
+		return make<ir::ast::expression::variable_ref>(
 			utils::position_range { start_position, lexer_.current_lexeme().position },
-			std::make_shared<ir::ast::expression::variable>(parameter_name, parse_type()));
+			make<ir::ast::expression::variable>(parameter_name, parse_type()));
 	}
 
 	ir::ast::expression::parameter_list parser::parse_parameter_list()
@@ -141,7 +117,7 @@ namespace seam::parser
 		return expression_list;
 	}
 
-	std::unique_ptr<ir::ast::expression::call> parser::parse_call_expression(std::unique_ptr<ir::ast::expression::expression> function)
+	ir::ast::expression::call* parser::parse_call_expression(ir::ast::expression::expression* function)
 	{
 		const auto start_position = lexer_.current_lexeme().position;
 
@@ -152,10 +128,10 @@ namespace seam::parser
 
 		expect(lexer::lexeme_type::symbol_close_parenthesis, true);
 
-		return std::make_unique<ir::ast::expression::call>(utils::position_range{ start_position, lexer_.current_lexeme().position }, std::move(function), std::move(arguments));
+		return make<ir::ast::expression::call>(utils::position_range{ start_position, lexer_.current_lexeme().position }, function, std::move(arguments));
 	}
 
-	std::unique_ptr<ir::ast::expression::expression> parser::parse_prefix_expression()
+	ir::ast::expression::expression* parser::parse_prefix_expression()
 	{
 		const auto current_lexeme = lexer_.current_lexeme();
 		const auto start_position = current_lexeme.position;
@@ -174,17 +150,17 @@ namespace seam::parser
 		case lexer::lexeme_type::identifier:
 		{
 			const auto identifier_pos = current_lexeme.position;
-			const auto identifier_name = std::string{ current_lexeme.value };
+			const auto identifier_name = intern(current_lexeme.value);
 
 			lexer_.next_lexeme();
 
-			if (const auto var = get_variable_from_block(current_block, identifier_name))
+			if (const auto var = variables_.find(identifier_name))
 			{
-				return std::make_unique<ir::ast::expression::variable_ref>(utils::position_range{ start_position, lexer_.current_lexeme().position }, var);
+				return make<ir::ast::expression::variable_ref>(utils::position_range{ start_position, lexer_.current_lexeme().position }, var);
 			}
 
-			return std::make_unique<ir::ast::expression::symbol_wrapper>(utils::position_range{ start_position, lexer_.current_lexeme().position },
-				std::make_unique<ir::ast::expression::unresolved_symbol>(identifier_name));
+			return make<ir::ast::expression::symbol_wrapper>(utils::position_range{ start_position, lexer_.current_lexeme().position },
+				make<ir::ast::expression::unresolved_symbol>(identifier_name));
 		}
 		default:
 		{
@@ -195,114 +171,147 @@ namespace seam::parser
 		}
 	}
 
-	std::unique_ptr<ir::ast::expression::expression> parser::parse_expression()
+	namespace
 	{
-		return parse_sub_expression().first;
+		struct priority
+		{
+			std::uint8_t left; // how tightly the operator binds its left operand, 0 if not a binary operator.
+			std::uint8_t right; // how tightly it binds its right operand, lower than left for right associativity.
+		};
+
+		constexpr auto binary_priority = []
+		{
+			std::array<priority, static_cast<std::size_t>(lexer::lexeme_type::kw_extern) + 1> table{};
+			const auto add = [&table](const lexer::lexeme_type type, const std::uint8_t value)
+			{
+				table[static_cast<std::size_t>(type)] = { value, value };
+			};
+
+			add(lexer::lexeme_type::symbol_add, 6);
+			add(lexer::lexeme_type::symbol_minus, 6);
+			add(lexer::lexeme_type::symbol_multiply, 7);
+			add(lexer::lexeme_type::symbol_divide, 7);
+			add(lexer::lexeme_type::symbol_mod, 7);
+			// comparison operators
+			add(lexer::lexeme_type::symbol_eq, 3);
+			add(lexer::lexeme_type::symbol_neq, 3);
+			add(lexer::lexeme_type::symbol_lt, 3);
+			add(lexer::lexeme_type::symbol_lteq, 3);
+			add(lexer::lexeme_type::symbol_gt, 3);
+			add(lexer::lexeme_type::symbol_gteq, 3);
+			// logical operators
+			add(lexer::lexeme_type::symbol_and, 2);
+			add(lexer::lexeme_type::symbol_or, 1);
+			return table;
+		}();
+
+		// higher than any binary priority
+		constexpr std::uint8_t unary_priority = 8;
 	}
 
-	struct priority
+	void parser::reduce_operator()
 	{
-		std::size_t left;
-		std::size_t right;
-
-		// if right > left then right associative
-		priority(std::size_t left, std::size_t right) :
-			left(left), right(right) {}
+		const auto pending = operators_.back();
+		operators_.pop_back();
 
-		priority(std::size_t priority) :
-			left(priority), right(priority) {}
-	};
+		const auto end_position = lexer_.current_lexeme().position;
+		if (pending.is_unary)
+		{
+			auto& operand = operands_.back();
+			operand.value = make<ir::ast::expression::unary>(utils::position_range{ pending.start, end_position }, operand.value, pending.type);
+			operand.start = pending.start;
+			return;
+		}
 
-	std::unordered_map<lexer::lexeme_type, priority> binary_priority
-	{
-		{ lexer::lexeme_type::symbol_add, 6 }, { lexer::lexeme_type::symbol_minus, 6 },
-		{ lexer::lexeme_type::symbol_multiply, 7 }, { lexer::lexeme_type::symbol_divide, 7 }, { lexer::lexeme_type::symbol_mod, 7 },
-		// comparison operators
-		{ lexer::lexeme_type::symbol_eq, 3 }, { lexer::lexeme_type::symbol_neq, 3 },
-		{ lexer::lexeme_type::symbol_lt, 3 }, { lexer::lexeme_type::symbol_lteq, 3 },
-		{ lexer::lexeme_type::symbol_gt, 3 }, { lexer::lexeme_type::symbol_gteq, 3 },
-		// logical operators
-		{ lexer::lexeme_type::symbol_and, 2 }, { lexer::lexeme_type::symbol_or, 1 },
-	};
+		const auto right = operands_.back().value;
+		operands_.pop_back();
 
-	// higher than any binary priority
-	std::size_t unary_priority = 8;
+		auto& left = operands_.back();
+		left.value = make<ir::ast::expression::binary>(utils::position_range{ left.start, end_position }, left.value, right, pending.type);
+	}
 
-	std::pair<std::unique_ptr<ir::ast::expression::expression>, std::optional<lexer::lexeme_type>> parser::parse_sub_expression(std::size_t limit)
+	ir::ast::expression::expression* parser::parse_expression()
 	{
-		const auto start_position = lexer_.current_lexeme().position;
-
-		std::unique_ptr<ir::ast::expression::expression> expression;
-		// TODO: use while loop instead of recursion
-		if (is_unary_operator(lexer_.current_lexeme().type))
-		{
-			auto operator_type = lexer_.current_lexeme().type;
-			lexer_.next_lexeme();
+		// Operands and operators are kept on explicit stacks (shared with the nested
+		// expressions of parentheses and call arguments), so the depth of recursion
+		// does not grow with the length of an operator chain.
+		const auto operand_base = operands_.size();
+		const auto operator_base = operators_.size();
 
-			expression = std::make_unique<ir::ast::expression::unary>(utils::position_range{ start_position, lexer_.current_lexeme().position },
-				parse_sub_expression(unary_priority).first,
-				operator_type);
-			
-		}
-		else
-		{
-			expression = parse_simple_expression();
-		}
-
-		lexer::lexeme_type operator_type = lexer_.current_lexeme().type;
 		while (true)
 		{
-			auto it = binary_priority.find(operator_type);
-			if (it == binary_priority.cend() || limit >= it->second.left)
+			while (is_unary_operator(lexer_.current_lexeme().type))
 			{
-				break;
+				operators_.push_back({ lexer_.current_lexeme().type, unary_priority, true, lexer_.current_lexeme().position });
+				lexer_.next_lexeme();
 			}
 
-			lexer_.next_lexeme();
-
-			auto [next_expression, next_operator_type] = parse_sub_expression(it->second.right);
-
-			expression = std::make_unique<ir::ast::expression::binary>(utils::position_range{ start_position, lexer_.current_lexeme().position },
-				std::move(expression), std::move(next_expression), operator_type);
+			const auto start_position = lexer_.current_lexeme().position;
+			operands_.push_back({ parse_simple_expression(), start_position });
 
-			if (!next_operator_type)
+			const auto operator_type = lexer_.current_lexeme().type;
+			const auto [left, right] = binary_priority[static_cast<std::size_t>(operator_type)];
+			if (left == 0)
 			{
 				break;
 			}
 
-			operator_type = next_operator_type.value();
+			// Everything on the stack that binds at least as tightly becomes the left operand.
+			while (operators_.size() > operator_base && operators_.back().right >= left)
+			{
+				reduce_operator();
+			}
+
+			operators_.push_back({ operator_type, right, false, lexer_.current_lexeme().position });
+			lexer_.next_lexeme();
 		}
 
-		return { std::move(expression), operator_type };
+		while (operators_.size() > operator_base)
+		{
+			reduce_operator();
+		}
+
+		const auto expression = operands_.back().value;
+		operands_.resize(operand_base);
+		return expression;
 	}
 
-	std::unique_ptr<ir::ast::expression::expression> parser::parse_simple_expression()
+	ir::ast::expression::expression* parser::parse_simple_expression()
 	{
 		const auto& start_position = lexer_.current_lexeme().position;
 
 		const auto current_lexeme = lexer_.current_lexeme(); //*dont* use a reference, we call next_lexeme
 
-		std::unique_ptr<ir::ast::expression::expression> expr;
+		ir::ast::expression::expression* expr = nullptr;
 		switch (const auto lexeme_type = current_lexeme.type)
 		{
 		case lexer::lexeme_type::kw_true:
 		case lexer::lexeme_type::kw_false:
 		{
 			lexer_.next_lexeme();
-			expr = std::make_unique<ir::ast::expression::bool_literal>(utils::position_range{ start_position, current_lexeme.position }, lexeme_type != lexer::lexeme_type::kw_false);
+			expr = make<ir::ast::expression::bool_literal>(utils::position_range{ start_position, current_lexeme.position }, lexeme_type != lexer::lexeme_type::kw_false);
 			break;
 		}
 		case lexer::lexeme_type::literal_number:
 		{
+			const ir::ast::expression::number_constant* constant;
+			try
+			{
+				constant = current_module->constants.number(current_lexeme.value);
+			}
+			catch (const std::invalid_argument& ex)
+			{
+				throw utils::parser_exception{ current_lexeme.position, ex.what() };
+			}
+
 			lexer_.next_lexeme();
-			expr = std::make_unique<ir::ast::expression::number_literal>(utils::position_range{ start_position, current_lexeme.position },
-				std::string{ current_lexeme.value });
+			expr = make<ir::ast::expression::number_literal>(utils::position_range{ start_position, current_lexeme.position }, constant);
 			break;
 		}
 		case lexer::lexeme_type::literal_string:
 		{
 			lexer_.next_lexeme();
-			expr = std::make_unique<ir::ast::expression::string_literal>(utils::position_range{ start_position, current_lexeme.position }, std::string{ current_lexeme.value });
+			expr = make<ir::ast::expression::string_literal>(utils::position_range{ start_position, current_lexeme.position }, std::string{ current_lexeme.value });
 			break;
 		}
 		case lexer::lexeme_type::symbol_open_parenthesis:
@@ -321,20 +330,18 @@ namespace seam::parser
 		return expr;
 	}
 
-	std::unique_ptr<ir::ast::expression::expression> parser::parse_primary_expression()
+	ir::ast::expression::expression* parser::parse_primary_expression()
 	{
 		const auto start_position = lexer_.current_lexeme().position;
 
-		auto prefix_expression = parse_prefix_expression();
-
-		auto expression = std::move(prefix_expression);
-		while (lexer_.current_lexeme().position.line == start_position.line)
+		auto expression = parse_prefix_expression();
+		while (lexer_.on_same_line(start_position, lexer_.current_lexeme().position))
 		{
 			switch (lexer_.current_lexeme().type)
 			{
 				case lexer::lexeme_type::symbol_open_parenthesis:
 				{
-					expression = parse_call_expression(std::move(expression));
+					expression = parse_call_expression(expression);
 					continue;
 				}
 			}
@@ -344,7 +351,7 @@ namespace seam::parser
 		return expression;
 	}
 
-	std::unique_ptr<ir::ast::statement::loop> parser::parse_for_statement()
+	ir::ast::statement::loop* parser::parse_for_statement()
 	{
 		const auto start = lexer_.current_lexeme().position;
 		lexer_.next_lexeme(); // collect kw_for
@@ -364,37 +371,37 @@ namespace seam::parser
 		expect(lexer::lexeme_type::symbol_comma, true);
 		auto final = parse_expression();
 
-		std::unique_ptr<ir::ast::expression::number_literal> step;
+		ir::ast::expression::number_literal* step = nullptr;
 		if (lexer_.current_lexeme().type == lexer::lexeme_type::symbol_comma)
 		{
 			//step = parse_expression();
 		}
 		else
 		{
-			//step = std::make_unique<ir::ast::expression::number_literal>();
+			//step = make<ir::ast::expression::number_literal>();
 		} //or just work locally on this
 
 		expect(lexer::lexeme_type::symbol_close_parenthesis, true); //can u wait 2 sec, we need to compile
 return {};
-		//return std::make_unique<ir::ast::statement::numerical_for_loop>(utils::position_range{ start_position, lexer_.current_lexeme().position }, std::move(initial), std::move(final));
+		//return make<ir::ast::statement::numerical_for_loop>(utils::position_range{ start_position, lexer_.current_lexeme().position }, std::move(initial), std::move(final));
 	}
 
-	std::unique_ptr<ir::ast::statement::ret> parser::parse_return_statement()
+	ir::ast::statement::ret* parser::parse_return_statement()
 	{
 		const auto start_position = lexer_.current_lexeme().position;
 		lexer_.next_lexeme();
 
-		std::unique_ptr<ir::ast::expression::expression> expression = nullptr;
+		ir::ast::expression::expression* expression = nullptr;
 		if (lexer_.current_lexeme().type != lexer::lexeme_type::symbol_close_brace
-			&& lexer_.current_lexeme().position.line == start_position.line)
+			&& lexer_.on_same_line(start_position, lexer_.current_lexeme().position))
 		{
 			expression = parse_expression();
 		}
 
-		return std::make_unique<ir::ast::statement::ret>(utils::position_range{ start_position, lexer_.current_lexeme().position }, std::move(expression));
+		return make<ir::ast::statement::ret>(utils::position_range{ start_position, lexer_.current_lexeme().position }, expression);
 	}
 
-	std::unique_ptr<ir::ast::statement::while_loop> parser::parse_while_statement()
+	ir::ast::statement::while_loop* parser::parse_while_statement()
 	{
 		const auto start = lexer_.current_lexeme().position;
 		lexer_.next_lexeme(); // collect kw_while
@@ -405,13 +412,13 @@ return {};
 
 		auto body = parse_block_statement();
 
-		return std::make_unique<ir::ast::statement::while_loop>(
+		return make<ir::ast::statement::while_loop>(
 			utils::position_range{ start, lexer_.current_lexeme().position },
-			std::move(condition),
-			std::move(body));
+			condition,
+			body);
 	}
 
-	std::unique_ptr<ir::ast::statement::if_stat> parser::parse_if_statement()
+	ir::ast::statement::if_stat* parser::parse_if_statement()
 	{
 		const auto start = lexer_.current_lexeme().position;
 		lexer_.next_lexeme(); // collect kw_if
@@ -422,7 +429,7 @@ return {};
 
 		auto main_body = parse_block_statement();
 		
-		std::unique_ptr<ir::ast::statement::normal_block> else_block;
+		ir::ast::statement::normal_block* else_block = nullptr;
 		while (lexer_.current_lexeme().type == lexer::lexeme_type::kw_else
 			|| lexer_.current_lexeme().type == lexer::lexeme_type::kw_elseif)
 		{
@@ -457,24 +464,25 @@ return {};
 			
 		}
 
-		return std::make_unique<ir::ast::statement::if_stat>(
+		return make<ir::ast::statement::if_stat>(
 			utils::position_range { start, lexer_.current_lexeme().position },
-			std::move(condition),
-			std::move(main_body),
-			std::move(else_block)
+			condition,
+			main_body,
+			else_block
 			);
 	}
 	
-	std::unique_ptr<ir::ast::statement::statement> parser::parse_assignment_statement()
+	ir::ast::statement::statement* parser::parse_assignment_statement()
 	{
 		const auto variable_position = lexer_.current_lexeme().position;
-		const auto variable_name = std::string{ lexer_.current_lexeme().value };
+		const auto variable_spelling = lexer_.current_lexeme().value;
+		const auto variable_name = intern(variable_spelling);
 		lexer_.next_lexeme(); // skips identifier
 		
 		const auto assignment_symbol = lexer_.current_lexeme();
 		lexer_.next_lexeme(); // get colon, or colon equals, or equals
 
-		const auto existing_var = get_variable_from_block(current_block, variable_name);
+		const auto existing_var = variables_.find(variable_name);
 		switch (assignment_symbol.type)
 		{
 			case lexer::lexeme_type::symbol_colon:
@@ -483,7 +491,7 @@ return {};
 				if (existing_var)
 				{
 					std::stringstream error_message;
-					error_message << "cannot redefine variable " << variable_name;
+					error_message << "cannot redefine variable " << variable_spelling;
 					
 					throw utils::compiler_exception{
 						lexer_.current_lexeme().position,
@@ -491,8 +499,8 @@ return {};
 					};
 				}
 
-				std::unique_ptr<ir::ast::expression::expression> rhs;
-				std::shared_ptr<ir::ast::type> var_type;
+				ir::ast::expression::expression* rhs = nullptr;
+				ir::ast::type* var_type = nullptr;
 				if (assignment_symbol.type == lexer::lexeme_type::symbol_colon)
 				{
 					var_type = parse_type();
@@ -502,13 +510,13 @@ return {};
 				else
 				{
 					rhs = parse_expression();
-					var_type = auto_type;
+					var_type = current_module->types.built_in(ir::ast::type::built_in_type::auto_);
 				}
 
-				const auto new_variable = std::make_shared<ir::ast::expression::variable>(variable_name, var_type);
-				current_block->variables.emplace(variable_name, new_variable);
-				return std::make_unique<ir::ast::statement::assignment>(utils::position_range{ assignment_symbol.position, lexer_.current_lexeme().position }, 
-					std::make_unique<ir::ast::expression::variable_ref>(utils::position_range{ variable_position, assignment_symbol.position }, new_variable), std::move(rhs));
+				const auto new_variable = make<ir::ast::expression::variable>(variable_name, var_type);
+				variables_.bind(variable_name, new_variable);
+				return make<ir::ast::statement::assignment>(utils::position_range{ assignment_symbol.position, lexer_.current_lexeme().position }, 
+					make<ir::ast::expression::variable_ref>(utils::position_range{ variable_position, assignment_symbol.position }, new_variable), rhs);
 			}
 			/*case lexer::lexeme_type::symbol_equals:
 			{
@@ -523,7 +531,7 @@ return {};
 					};
 				}
 
-				return std::make_unique<ir::ast::statement::variable_assignment>(
+				return make<ir::ast::statement::variable_assignment>(
 					utils::position_range{ assignment_symbol.position, lexer_.current_lexeme().position },
 					variable_name,
 					parse_expression());
@@ -531,15 +539,14 @@ return {};
 		}
 	}
 	
-	std::unique_ptr<ir::ast::statement::normal_block> parser::parse_block_statement()
+	ir::ast::statement::normal_block* parser::parse_block_statement()
 	{
 		expect(lexer::lexeme_type::symbol_open_brace, true);
 		const auto start_position = lexer_.current_lexeme().position;
 
-		const auto old_block = current_block;
-		auto new_block = std::make_unique<ir::ast::statement::normal_block>(utils::position_range{ start_position, lexer_.current_lexeme().position });
-		new_block->parent = old_block;
-		current_block = new_block.get();
+		auto new_block = make<ir::ast::statement::normal_block>(utils::position_range{ start_position, lexer_.current_lexeme().position });
+		variables_.push_scope();
+		types_.push_scope();
 
 		ir::ast::statement::statement_list body;
 		while (true)
@@ -582,9 +589,10 @@ return {};
 			}
 			case lexer::lexeme_type::identifier:
 			{
-				if (lexer_.peek_lexeme().type == lexer::lexeme_type::symbol_colon_equals
-					|| lexer_.peek_lexeme().type == lexer::lexeme_type::symbol_colon
-					|| lexer_.peek_lexeme().type == lexer::lexeme_type::symbol_equals) // a (:=)= 2
+				const auto next_type = lexer_.peek_lexeme().type;
+				if (next_type == lexer::lexeme_type::symbol_colon_equals
+					|| next_type == lexer::lexeme_type::symbol_colon
+					|| next_type == lexer::lexeme_type::symbol_equals) // a (:=)= 2
 				{
 					body.emplace_back(parse_assignment_statement());
 					break;
@@ -597,7 +605,7 @@ return {};
 				// TODO: use parse_primary_expression if we only want to allow call + index
 				auto expression = parse_expression();
 
-				body.push_back(std::make_unique<ir::ast::statement::expression_>(expression->range, std::move(expression)));
+				body.push_back(make<ir::ast::statement::expression_>(expression->range, expression));
 				break;
 			}
 			}
@@ -605,13 +613,62 @@ return {};
 
 		expect(lexer::lexeme_type::symbol_close_brace, true);
 
-		current_block = old_block;
+		variables_.pop_scope();
+		types_.pop_scope();
 
 		new_block->body = std::move(body);
 		return new_block;
 	}
 
-	std::shared_ptr<ir::ast::expression::function_signature> parser::parse_function_signature()
+	void parser::skip_block_statement()
+	{
+		const auto start_position = lexer_.current_lexeme().position;
+		expect(lexer::lexeme_type::symbol_open_brace);
+		const auto start = lexer_.checkpoint();
+
+		std::size_t depth = 0;
+		do
+		{
+			switch (lexer_.current_lexeme().type)
+			{
+			case lexer::lexeme_type::symbol_open_brace:
+			{
+				++depth;
+				break;
+			}
+			case lexer::lexeme_type::symbol_close_brace:
+			{
+				--depth;
+				break;
+			}
+			case lexer::lexeme_type::identifier:
+			{
+				// Interning names in source order here, before the bodies are parsed
+				// concurrently, keeps symbol ids independent of thread scheduling.
+				if (body_parsing_ == body_parsing::parallel)
+				{
+					intern(lexer_.current_lexeme().value);
+				}
+				break;
+			}
+			case lexer::lexeme_type::eof:
+			{
+				// Parse the block for the same error an eager parse reports.
+				lexer_.restore(start);
+				parse_block_statement();
+				throw utils::parser_exception{ start_position, "expected '}' to close block" };
+			}
+			default:
+			{
+				break;
+			}
+			}
+
+			lexer_.next_lexeme();
+		} while (depth != 0);
+	}
+
+	ir::ast::expression::function_signature* parser::parse_function_signature()
 	{
 		const auto start_position = lexer_.current_lexeme().position;
 
@@ -622,7 +679,7 @@ return {};
 		expect(lexer::lexeme_type::identifier);
 
 		// Store function name
-		auto function_name = std::string{ lexer_.current_lexeme().value };
+		const auto function_name = lexer_.current_lexeme().value;
 		lexer_.next_lexeme();
 
 		// Verify next token is open parenthesis (start of parameter_list)
@@ -635,7 +692,7 @@ return {};
 		expect(lexer::lexeme_type::symbol_close_parenthesis, true);
 
 		// Check for explicit return type
-		std::shared_ptr<ir::ast::type> return_type;
+		ir::ast::type* return_type = nullptr;
 		if (lexer_.current_lexeme().type == lexer::lexeme_type::symbol_arrow)
 		{
 			lexer_.next_lexeme();
@@ -646,7 +703,7 @@ return {};
 			// We do not allow for any implicit returns which
 			// are not void, so we can simply set the return
 			// type to void.
-			return_type = get_type_from_block(current_block, "void");
+			return_type = types_.find(intern("void"));
 		}
 
 		// Check for attributes
@@ -664,33 +721,126 @@ return {};
 			lexer_.next_lexeme();
 		}
 
-		return std::make_shared<ir::ast::expression::function_signature>(current_module->name, std::move(function_name), std::move(return_type),
+		return make<ir::ast::expression::function_signature>(current_module->name, intern(function_name), function_name, return_type,
 			std::move(param_list), std::move(attribute_list));
 	}
 
-	std::unique_ptr<ir::ast::statement::function_definition> parser::parse_function_definition_statement()
+	ir::ast::statement::function_definition* parser::parse_function_definition_statement()
 	{
 		const auto start_position = lexer_.current_lexeme().position;
 		auto signature = parse_function_signature();
 
+		if (body_parsing_ != body_parsing::eager)
+		{
+			expect(lexer::lexeme_type::symbol_open_brace);
+			const auto body_checkpoint = lexer_.checkpoint();
+			skip_block_statement();
+
+			const auto function = make<ir::ast::statement::function_definition>(utils::position_range{ start_position, lexer_.current_lexeme().position },
+				signature, nullptr);
+			function->body_checkpoint = body_checkpoint;
+			function->body_types = types_.size();
+			if (body_parsing_ == body_parsing::parallel)
+			{
+				skipped_bodies_.push_back(function);
+			}
+			return function;
+		}
+
 		// Parse function body
 		auto block = parse_block_statement();
 
-		return std::make_unique<ir::ast::statement::function_definition>(utils::position_range{ start_position, lexer_.current_lexeme().position },
-			signature, std::move(block));
+		return make<ir::ast::statement::function_definition>(utils::position_range{ start_position, lexer_.current_lexeme().position },
+			signature, block);
+	}
+
+	void parser::parse_function_body(ir::ast::statement::function_definition* function)
+	{
+		// The body only sees the types defined before it, as if parsed where it is defined.
+		lexer_.restore(function->body_checkpoint);
+		types_.hide(function->body_types);
+		try
+		{
+			function->body = parse_block_statement();
+		}
+		catch (...)
+		{
+			types_.show_all();
+			throw;
+		}
+		types_.show_all();
+	}
+
+	void parser::parse_skipped_bodies()
+	{
+		const auto function_count = skipped_bodies_.size();
+		if (function_count == 0)
+		{
+			return;
+		}
+
+		const auto worker_count = std::min(workers_, function_count);
+		std::vector<utils::arena> arenas(worker_count);
+		std::vector<std::unique_ptr<parser>> workers;
+		workers.reserve(worker_count);
+		for (std::size_t worker = 0; worker < worker_count; ++worker)
+		{
+			workers.emplace_back(new parser{ *this, arenas[worker] });
+		}
+
+		std::vector<std::exception_ptr> errors(function_count);
+		std::atomic<std::size_t> first_error{ function_count };
+
+		utils::parallel_for(function_count, worker_count, [&](const std::size_t worker, const std::size_t index)
+		{
+			// Bodies after a failed one cannot change which error is reported first.
+			if (index > first_error.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+
+			try
+			{
+				workers[worker]->parse_function_body(skipped_bodies_[index]);
+			}
+			catch (...)
+			{
+				errors[index] = std::current_exception();
+				auto failed = first_error.load();
+				while (index < failed && !first_error.compare_exchange_weak(failed, index))
+				{
+				}
+
+				// The failed parser is left mid-body, its scopes still open.
+				workers[worker].reset(new parser{ *this, arenas[worker] });
+			}
+		});
+
+		for (auto& arena : arenas)
+		{
+			current_module->arena.adopt(arena);
+		}
+
+		for (const auto& error : errors)
+		{
+			if (error)
+			{
+				std::rethrow_exception(error);
+			}
+		}
 	}
 
-	std::unique_ptr<ir::ast::statement::extern_function_definition> parser::parse_extern_function_definition_statement()
+	ir::ast::statement::extern_function_definition* parser::parse_extern_function_definition_statement()
 	{
 		const auto start_position = lexer_.current_lexeme().position;
 		auto signature = parse_function_signature();
 		signature->is_extern = true;
 
-		return std::make_unique<ir::ast::statement::extern_function_definition>(utils::position_range{ start_position, lexer_.current_lexeme().position },
+		return make<ir::ast::statement::extern_function_definition>(utils::position_range{ start_position, lexer_.current_lexeme().position },
 			signature);
 	}
 
-	std::unique_ptr<ir::ast::statement::type_definition> parser::parse_type_definition_statement()
+	ir::ast::statement::type_definition* parser::parse_type_definition_statement()
 	{
 		const auto start_position = lexer_.current_lexeme().position;
 
@@ -699,7 +849,8 @@ return {};
 
 		expect(lexer::lexeme_type::identifier);
 
-		const auto type_name = std::string{ lexer_.current_lexeme().value };
+		const auto type_spelling = lexer_.current_lexeme().value;
+		const auto type_name = intern(type_spelling);
 		lexer_.next_lexeme();
 
 		const auto current_token = lexer_.current_lexeme();
@@ -707,10 +858,10 @@ return {};
 		{
 		case lexer::lexeme_type::symbol_equals:
 		{
-			if (const auto existing_type = get_type_from_block(current_block, type_name))
+			if (const auto existing_type = types_.find(type_name))
 			{
 				std::stringstream error_message;
-				error_message << "cannot redefine existing type '" << type_name << '\'';
+				error_message << "cannot redefine existing type '" << type_spelling << '\'';
 				throw utils::parser_exception{ lexer_.current_lexeme().position, error_message.str() };
 			}
 
@@ -720,10 +871,10 @@ return {};
 			const auto target_type = parse_type();
 
 			// register type
-			current_block->types.emplace(type_name, target_type);
+			types_.bind(type_name, target_type);
 			
 			// add type alias node, not required for code gen
-			return std::make_unique<ir::ast::statement::alias_type_definition>(utils::position_range{ start_position, lexer_.current_lexeme().position },
+			return make<ir::ast::statement::alias_type_definition>(utils::position_range{ start_position, lexer_.current_lexeme().position },
 				type_name, target_type);
 		}
 		case lexer::lexeme_type::symbol_open_brace:
@@ -739,7 +890,7 @@ return {};
 				if (current_lexeme.type == lexer::lexeme_type::identifier) // <identifier> : <type>
 				{
 					// <identifier>
-					const auto field_name = std::string{ current_lexeme.value };
+					const auto field_name = intern(current_lexeme.value);
 					lexer_.next_lexeme();
 
 					// :
@@ -748,9 +899,9 @@ return {};
 					// <type>
 					auto type = parse_type();
 
-					fields.push_back(std::make_unique<ir::ast::expression::variable_ref>(
+					fields.push_back(make<ir::ast::expression::variable_ref>(
 						utils::position_range{ start_position, lexer_.current_lexeme().position },
-						std::make_shared<ir::ast::expression::variable>(field_name, type)));
+						make<ir::ast::expression::variable>(field_name, type)));
 				}
 				else // methods, types, ...
 				{
@@ -761,10 +912,10 @@ return {};
 			// }
 			expect(lexer::lexeme_type::symbol_close_brace, true);
 
-			auto body_stat = std::make_unique<ir::ast::statement::restricted_block>(utils::position_range{ start_position, lexer_.current_lexeme().position }, std::move(body));
+			auto body_stat = make<ir::ast::statement::restricted_block>(utils::position_range{ start_position, lexer_.current_lexeme().position }, std::move(body));
 
-			return std::make_unique<ir::ast::statement::class_type_definition>(utils::position_range{ start_position, lexer_.current_lexeme().position },
-				type_name, std::move(fields), std::move(body_stat));
+			return make<ir::ast::statement::class_type_definition>(utils::position_range{ start_position, lexer_.current_lexeme().position },
+				type_name, std::move(fields), body_stat);
 		}
 		default:
 		{
@@ -775,7 +926,7 @@ return {};
 		}
 	}
 
-	std::unique_ptr<ir::ast::statement::restricted> parser::parse_restricted_statement()
+	ir::ast::statement::restricted* parser::parse_restricted_statement()
 	{
 		const auto current_lexeme = lexer_.current_lexeme();
 
@@ -802,33 +953,33 @@ return {};
 		}
 	}
 
-	void register_built_in_types(ir::ast::statement::restricted_block* block)
+	void register_built_in_types(types::module& module, scoped_table<ir::ast::type*>& types)
 	{
-		auto& types = block->types;
-		types.emplace("void", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::void_));
-		types.emplace("bool", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::bool_));
-		types.emplace("string", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::string));
-		types.emplace("i8", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::i8));
-		types.emplace("i16", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::i16));
-		types.emplace("i32", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::i32));
-		types.emplace("i64", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::i64));
-		types.emplace("u8", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::u8));
-		types.emplace("u16", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::u16));
-		types.emplace("u32", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::u32));
-		types.emplace("u64", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::u64));
-		types.emplace("f32", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::f32));
-		types.emplace("f64", std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::f64));
+		const auto add = [&](const std::string_view name, const ir::ast::type::built_in_type type)
+		{
+			types.bind(module.interner.intern(name), module.types.built_in(type));
+		};
+
+		add("void", ir::ast::type::built_in_type::void_);
+		add("bool", ir::ast::type::built_in_type::bool_);
+		add("string", ir::ast::type::built_in_type::string);
+		add("i8", ir::ast::type::built_in_type::i8);
+		add("i16", ir::ast::type::built_in_type::i16);
+		add("i32", ir::ast::type::built_in_type::i32);
+		add("i64", ir::ast::type::built_in_type::i64);
+		add("u8", ir::ast::type::built_in_type::u8);
+		add("u16", ir::ast::type::built_in_type::u16);
+		add("u32", ir::ast::type::built_in_type::u32);
+		add("u64", ir::ast::type::built_in_type::u64);
+		add("f32", ir::ast::type::built_in_type::f32);
+		add("f64", ir::ast::type::built_in_type::f64);
 	}
 
-	std::unique_ptr<ir::ast::statement::restricted_block> parser::parse_restricted_block_statement(bool is_type_scope)
+	ir::ast::statement::restricted_block* parser::parse_restricted_block_statement(bool is_type_scope)
 	{
 		const auto start_position = lexer_.current_lexeme().position;
 
-		const auto old_block = current_block;
-		auto new_block = std::make_unique<ir::ast::statement::restricted_block>(utils::position_range{ start_position, lexer_.current_lexeme().position });
-		current_block = new_block.get();
-
-		register_built_in_types(new_block.get());
+		auto new_block = make<ir::ast::statement::restricted_block>(utils::position_range{ start_position, lexer_.current_lexeme().position });
 
 		ir::ast::statement::restricted_list body;
 		while (true)
@@ -854,29 +1005,242 @@ return {};
 			body.emplace_back(parse_restricted_statement());
 		}
 
-		current_block = old_block;
 		new_block->body = std::move(body);
 		return new_block;
 	}
 
-	parser::parser(std::shared_ptr<types::module> current_module, const std::string_view filename, const std::string_view source) :
-		current_module(current_module), filename_(filename), lexer_(current_module, source) {}
+	parser::parser(std::shared_ptr<types::module> current_module, const std::string_view filename, const std::string_view source,
+		const lexer::lexer_mode mode) :
+		current_module(current_module), filename_(filename), lexer_(current_module, source, mode), arena_(&current_module->arena) {}
 
-	std::unique_ptr<ir::ast::statement::restricted_block> parser::parse()
+	parser::parser(std::shared_ptr<types::module> current_module, std::shared_ptr<const utils::source_file> source,
+		const lexer::lexer_mode mode) :
+		current_module(current_module), source_file_(std::move(source)), filename_(source_file_->path()),
+		lexer_(current_module, source_file_->contents(), mode), arena_(&current_module->arena) {}
+
+	parser::parser(std::shared_ptr<types::module> current_module, const std::string_view filename,
+		std::shared_ptr<const lexer::token_buffer> tokens) :
+		current_module(current_module), filename_(filename), lexer_(current_module, std::move(tokens)), arena_(&current_module->arena) {}
+
+	parser::parser(const parser& owner, utils::arena& arena) :
+		current_module(owner.current_module), source_file_(owner.source_file_), filename_(owner.filename_),
+		lexer_(owner.lexer_), types_(owner.types_), arena_(&arena), concurrent_(true)
 	{
+		// Skipped bodies only ever see the module scope.
+		variables_.push_scope();
+	}
+
+	ir::ast::statement::restricted_block* parser::parse(const body_parsing bodies, const std::size_t workers)
+	{
+		// Skipping and then parsing bodies only pays off with threads to spread them over.
+		workers_ = workers != 0 ? workers : std::max(std::thread::hardware_concurrency(), 1u);
+		body_parsing_ = bodies == body_parsing::parallel && workers_ <= 1 ? body_parsing::eager : bodies;
+
 		// get first lexeme
 		lexer_.next_lexeme();
 
-		// create auto type
-		auto_type = std::make_shared<ir::ast::type>(ir::ast::type::built_in_type::auto_);
+		return parse_root();
+	}
+
+	ir::ast::statement::restricted_block* parser::parse_root()
+	{
+		// module scope, kept open until the passes are done as they may parse skipped bodies.
+		variables_.push_scope();
+		types_.push_scope();
+		register_built_in_types(*current_module, types_);
 
 		// parse root
-		auto root = parse_restricted_block_statement();
+		ir::ast::statement::restricted_block* root = nullptr;
+		try
+		{
+			root = parse_restricted_block_statement();
+			expect(lexer::lexeme_type::eof);
+		}
+		catch (const utils::exception&)
+		{
+			// An error in a body skipped before this one comes first in source order.
+			parse_skipped_bodies();
+			throw;
+		}
+		parse_skipped_bodies();
+
+		if (body_parsing_ == body_parsing::lazy)
+		{
+			pass_statistics_ = passes::pass::run_passes(root, *current_module, [this](ir::ast::statement::function_definition* function)
+			{
+				parse_function_body(function);
+			});
+		}
+		else
+		{
+			pass_statistics_ = passes::pass::run_passes(root, *current_module);
+		}
+		current_module->parsed_bytes = current_module->arena.bytes_used();
+
+		variables_.pop_scope();
+		types_.pop_scope();
+
+		return root;
+	}
+
+	ir::ast::statement::restricted_block* parser::reparse_all()
+	{
+		current_module->body = nullptr;
+		current_module->functions.clear();
+		current_module->arena.release();
+
+		variables_ = {};
+		types_ = {};
+		operands_.clear();
+		operators_.clear();
+		body_parsing_ = body_parsing::eager;
+
+		lexer_.seek({ 0 });
+		return current_module->body = parse_root();
+	}
+
+	ir::ast::statement::restricted_block* parser::reparse(const std::vector<text_edit>& edits)
+	{
+		const auto root = current_module->body;
+		if (edits.empty() && root)
+		{
+			return root;
+		}
+
+		// The nodes reparsing replaces stay in the arena until it is released, which parsing
+		// the whole source again does once they may take as much memory as the module did.
+		if (!root || root->body.empty() || current_module->arena.bytes_used() > 2 * current_module->parsed_bytes)
+		{
+			return reparse_all();
+		}
+
+		// Previous range covered by the edits, and how far the text after it moved.
+		auto damage_start = edits.front().range.start.offset;
+		auto damage_end = edits.front().range.end.offset;
+		std::int64_t shift = 0;
+		for (const auto& edit : edits)
+		{
+			damage_start = std::min(damage_start, edit.range.start.offset);
+			damage_end = std::max(damage_end, edit.range.end.offset);
+			shift += static_cast<std::int64_t>(edit.length) - (edit.range.end.offset - edit.range.start.offset);
+		}
+
+		// Top-level statements tile the source, each one ending where the next starts, so
+		// the damaged ones form a run. Statements merely touching an edit count as damaged.
+		const auto& statements = root->body;
+		const auto first = static_cast<std::size_t>(std::find_if(statements.cbegin(), statements.cend(),
+			[&](const auto statement) { return statement->range.end.offset >= damage_start; }) - statements.cbegin());
+		const auto last = std::max(first + 1, static_cast<std::size_t>(std::find_if(statements.cbegin() + std::min(first, statements.size()), statements.cend(),
+			[&](const auto statement) { return statement->range.start.offset > damage_end; }) - statements.cbegin()));
+
+		if (first >= statements.size())
+		{
+			return reparse_all();
+		}
+
+		// Functions calling a function of the damaged statements are parsed again as well,
+		// the types of their expressions may follow what the damaged functions return.
+		const auto callers = passes::pass::find_callers(*current_module, first, last - first);
+		for (std::size_t index = 0; index < statements.size(); ++index)
+		{
+			const auto function = statements[index]->as<ir::ast::statement::function_definition>();
+			if ((function && !function->body)
+				|| (index >= first && index < last && statements[index]->is<ir::ast::statement::type_definition>()))
+			{
+				return reparse_all();
+			}
+		}
+		if (std::any_of(callers.cbegin(), callers.cend(), [&](const std::size_t index) { return !statements[index]->is<ir::ast::statement::function_definition>(); }))
+		{
+			return reparse_all(); // a calling method cannot be parsed without its class.
+		}
+
+		const auto region_start = first == 0 ? utils::position{ 0 } : statements[first]->range.start;
+		const auto to_eof = last == statements.size();
+		const auto region_end = to_eof ? 0 : static_cast<std::uint32_t>(statements[last]->range.start.offset + shift);
+
+		variables_ = {};
+		types_ = {};
+		variables_.push_scope();
+		types_.push_scope();
+		register_built_in_types(*current_module, types_);
+
+		// Statements are parsed in source order, seeing the aliases before them.
+		std::vector<passes::statement_replacement> replacements;
+		auto next_caller = callers.cbegin();
+		const auto parse_callers = [&](const std::size_t begin, const std::size_t end, const std::int64_t statement_shift)
+		{
+			for (auto index = begin; index < end; ++index)
+			{
+				if (const auto alias = statements[index]->as<ir::ast::statement::alias_type_definition>())
+				{
+					types_.bind(alias->name, alias->target_type);
+				}
+
+				if (next_caller == callers.cend() || *next_caller != index)
+				{
+					continue;
+				}
+				++next_caller;
+
+				const auto caller = statements[index];
+				auto& replacement = replacements.emplace_back(passes::statement_replacement{ index, 1 });
+				lexer_.seek({ static_cast<std::uint32_t>(caller->range.start.offset + statement_shift) });
+				replacement.statements.push_back(parse_restricted_statement());
+				if (replacement.statements.back()->range.end.offset != caller->range.end.offset + statement_shift)
+				{
+					return false;
+				}
+			}
+			return true;
+		};
+
+		try
+		{
+			if (!parse_callers(0, first, 0))
+			{
+				return reparse_all();
+			}
+
+			ir::ast::statement::restricted_list region;
+			lexer_.seek(region_start);
+			while (lexer_.current_lexeme().type != lexer::lexeme_type::eof
+				&& (to_eof || lexer_.current_lexeme().position.offset < region_end))
+			{
+				region.push_back(parse_restricted_statement());
+			}
+
+			// Statements that now run into the next one (say, after deleting a closing brace)
+			// or define types cannot be spliced in.
+			const auto& end_lexeme = lexer_.current_lexeme();
+			if ((to_eof ? end_lexeme.type != lexer::lexeme_type::eof : end_lexeme.position.offset != region_end)
+				|| std::any_of(region.cbegin(), region.cend(),
+					[](const auto statement) { return statement->template is<ir::ast::statement::type_definition>(); }))
+			{
+				return reparse_all();
+			}
+			replacements.push_back({ first, last - first, std::move(region) });
+
+			if (!parse_callers(last, statements.size(), shift))
+			{
+				return reparse_all();
+			}
+		}
+		catch (const utils::exception&)
+		{
+			// Errors within the damaged statements are the ones a full parse reports first.
+			if (!to_eof && lexer_.current_lexeme().position.offset >= region_end)
+			{
+				return reparse_all();
+			}
+			throw;
+		}
 
-		expect(lexer::lexeme_type::eof);
+		pass_statistics_ = passes::pass::run_incremental_passes(*current_module, replacements, last, shift);
 
-		passes::pass::run_passes(root.get());
+		variables_.pop_scope();
+		types_.pop_scope();
 
 		return root;
 	}
-}
\ No newline at end of file
+}
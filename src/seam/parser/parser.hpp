@@ -4,22 +4,102 @@
 #include "../ir/ast/expression.hpp"
 #include "../lexer/lexer.hpp"
 #include "../types/module.hpp"
+#include "../utils/source_file.hpp"
+#include "passes/pass.hpp"
+#include "scoped_table.hpp"
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 namespace seam::parser
 {
+	/**
+	 * When the parser parses function bodies.
+	 */
+	enum class body_parsing
+	{
+		eager, // parse every body where it is defined.
+		lazy, // skip bodies by brace matching, parse them once resolution reaches them from a root function.
+		parallel, // skip bodies by brace matching, then parse all of them on worker threads, eager with a single worker.
+	};
+
+	/**
+	 * Replacement of a range of text, see parser::reparse.
+	 */
+	struct text_edit
+	{
+		utils::position_range range; // replaced range of the previous source, end exclusive.
+		std::uint32_t length; // length of the text replacing it.
+	};
+
 	class parser
 	{
 		std::shared_ptr<types::module> current_module;
 
+		std::shared_ptr<const utils::source_file> source_file_; // keeps a loaded source alive while it is lexed.
 		std::string_view filename_; // name of file currently being parsed.
 		lexer::lexer lexer_; // current lexer instance.
 
-		ir::ast::statement::base_block* current_block = nullptr;
+		scoped_table<ir::ast::expression::variable*> variables_; // variables visible at the current position.
+		scoped_table<ir::ast::type*> types_; // types visible at the current position.
+
+		body_parsing body_parsing_ = body_parsing::eager;
+		std::size_t workers_ = 1; // threads parsing skipped bodies, see body_parsing::parallel.
+		std::vector<ir::ast::statement::function_definition*> skipped_bodies_; // functions whose bodies are left to parse_skipped_bodies.
+
+		utils::arena* arena_; // arena nodes are allocated in, the module's unless parsing skipped bodies.
+		bool concurrent_ = false; // whether other parsers intern names at the same time.
+
+		struct pending_operand
+		{
+			ir::ast::expression::expression* value;
+			utils::position start; // start of the operand, including any unary operators applied to it.
+		};
 
-		std::shared_ptr<ir::ast::type> auto_type;
+		struct pending_operator
+		{
+			lexer::lexeme_type type;
+			std::uint8_t right; // priority towards the right operand.
+			bool is_unary;
+			utils::position start;
+		};
+
+		std::vector<passes::pass_statistics> pass_statistics_; // of the passes last run over the module.
+
+		std::vector<pending_operand> operands_; // operand stack of the expressions currently being parsed.
+		std::vector<pending_operator> operators_; // operator stack of the expressions currently being parsed.
+
+		/**
+		 * Allocates an ast node (or type) in the module arena, or the worker arena
+		 * which is later handed to the module.
+		 *
+		 * @param args arguments forwarded to the constructor of T.
+		 * @returns non-owning pointer to the node, owned by the module.
+		 */
+		template <typename T, typename... Args>
+		T* make(Args&&... args)
+		{
+			return arena_->make<T>(std::forward<Args>(args)...);
+		}
+
+		/**
+		 * Interns a name in the module interner.
+		 *
+		 * @param spelling name to intern.
+		 * @returns id of the name.
+		 */
+		utils::symbol_id intern(const std::string_view spelling)
+		{
+			if (concurrent_)
+			{
+				return current_module->interner.intern_concurrently(spelling);
+			}
+			return current_module->interner.intern(spelling);
+		}
 
 		/**
 		 * 
@@ -43,7 +123,7 @@ namespace seam::parser
 		 *
 		 * @returns a type.
 		 */
-		std::shared_ptr<ir::ast::type> parse_type();
+		ir::ast::type* parse_type();
 
 		/**
 		 * Parses a parameter.
@@ -53,7 +133,7 @@ namespace seam::parser
 		 *
 		 * @returns a parameter.
 		 */
-		std::unique_ptr<ir::ast::expression::parameter> parse_parameter();
+		ir::ast::expression::parameter* parse_parameter();
 
 		/**
 		 * Parses a parameter list.
@@ -67,7 +147,7 @@ namespace seam::parser
 
 		ir::ast::expression::expression_list parse_expression_list();
 		
-		std::unique_ptr<ir::ast::expression::call> parse_call_expression(std::unique_ptr<ir::ast::expression::expression> function);
+		ir::ast::expression::call* parse_call_expression(ir::ast::expression::expression* function);
 		
 		/**
 		 * Parses any generic prefix expression.
@@ -77,7 +157,7 @@ namespace seam::parser
 		 *
 		 * @returns a unique pointer to an expression node when successful, otherwise throws an exception.
 		 */
-		std::unique_ptr<ir::ast::expression::expression> parse_prefix_expression();
+		ir::ast::expression::expression* parse_prefix_expression();
 	
 		/**
 		 * Parses any generic expression.
@@ -87,27 +167,31 @@ namespace seam::parser
 		 *
 		 * @returns a unique pointer to an expression node when successful, otherwise throws an exception.
 		 */
-		std::unique_ptr<ir::ast::expression::expression> parse_expression();
-		
-		std::pair<std::unique_ptr<ir::ast::expression::expression>, std::optional<lexer::lexeme_type>> parse_sub_expression(std::size_t limit = 0);
+		ir::ast::expression::expression* parse_expression();
 
-		std::unique_ptr<ir::ast::expression::expression> parse_simple_expression();
+		/**
+		 * Pops the top operator of the operator stack and replaces its operands
+		 * on the operand stack with the resulting unary or binary expression.
+		 */
+		void reduce_operator();
+
+		ir::ast::expression::expression* parse_simple_expression();
 
 		/**
 		 * Parses primary expression
 		 * primary_expression = prefix_expression '.' name | prefix_expression call_args
 		 */
-		std::unique_ptr<ir::ast::expression::expression> parse_primary_expression();
+		ir::ast::expression::expression* parse_primary_expression();
 		
-		std::unique_ptr<ir::ast::statement::loop> parse_for_statement();
+		ir::ast::statement::loop* parse_for_statement();
 
-		std::unique_ptr<ir::ast::statement::ret> parse_return_statement();
+		ir::ast::statement::ret* parse_return_statement();
 
-		std::unique_ptr<ir::ast::statement::if_stat> parse_if_statement();
+		ir::ast::statement::if_stat* parse_if_statement();
 		
-		std::unique_ptr<ir::ast::statement::while_loop> parse_while_statement();
+		ir::ast::statement::while_loop* parse_while_statement();
 
-		std::unique_ptr<ir::ast::statement::statement> parse_assignment_statement();
+		ir::ast::statement::statement* parse_assignment_statement();
 		
 		/**
 		 * Parses a block statement.
@@ -117,30 +201,60 @@ namespace seam::parser
 		 *
 		 * @returns a unique pointer to a block ast node when successful, otherwise throws an exception.
 		 */
-		std::unique_ptr<ir::ast::statement::normal_block> parse_block_statement();
+		ir::ast::statement::normal_block* parse_block_statement();
+
+		/**
+		 * Skips a block statement by matching braces, without parsing it.
+		 */
+		void skip_block_statement();
+
+		/**
+		 * Parses the body of a function definition that was skipped.
+		 *
+		 * @param function function definition with a skipped body.
+		 */
+		void parse_function_body(ir::ast::statement::function_definition* function);
+
+		/**
+		 * Parses every body in skipped_bodies_, spread over workers_ threads.
+		 *
+		 * Each worker gets its own parser and arena, the arenas are handed to the
+		 * module in a fixed order once every worker is done.
+		 *
+		 * @throws the error of the first body, in source order, that fails to parse.
+		 */
+		void parse_skipped_bodies();
+
+		/**
+		 * Initialise a worker parser for the skipped bodies of another parser.
+		 *
+		 * @param owner parser that skipped the bodies.
+		 * @param arena arena to allocate nodes in.
+		 */
+		explicit parser(const parser& owner, utils::arena& arena);
 
 		/**
 		 * Parses a function definition statement.
 		 *
 		 * @returns a unique pointer to a function definition ast node when successful, otherwise throws an exception.
 		 */
-		std::shared_ptr<ir::ast::expression::function_signature> parse_function_signature();
+		ir::ast::expression::function_signature* parse_function_signature();
 
 		/**
 		 * Parses a function definition statement.
 		 *
 		 * @returns a unique pointer to a function definition ast node when successful, otherwise throws an exception.
 		 */
-		std::unique_ptr<ir::ast::statement::function_definition> parse_function_definition_statement();
+		ir::ast::statement::function_definition* parse_function_definition_statement();
 		
-		std::unique_ptr<ir::ast::statement::extern_function_definition> parse_extern_function_definition_statement();
+		ir::ast::statement::extern_function_definition* parse_extern_function_definition_statement();
 
 		/**
 		 * Parses a type definition statement.
 		 *
 		 * @returns a unique pointer to a type definition ast node when successful, otherwise throws an exception.
 		 */
-		std::unique_ptr<ir::ast::statement::type_definition> parse_type_definition_statement();
+		ir::ast::statement::type_definition* parse_type_definition_statement();
 		
 		/**
 		 * Parses a restricted statement.
@@ -153,7 +267,7 @@ namespace seam::parser
 		 *
 		 * @returns a unique pointer to a restricted statement ast node when successful, otherwise throws an exception.
 		 */
-		std::unique_ptr<ir::ast::statement::restricted> parse_restricted_statement();
+		ir::ast::statement::restricted* parse_restricted_statement();
 		
 		/**
 		 * Parses a restricted block statement.
@@ -168,7 +282,21 @@ namespace seam::parser
 		 * @param is_type_scope whether we're parsing in a type scope.
 		 * @returns a unique pointer to a restricted block ast node when successful, otherwise throws an exception.
 		 */
-		std::unique_ptr<ir::ast::statement::restricted_block> parse_restricted_block_statement(bool is_type_scope = false);
+		ir::ast::statement::restricted_block* parse_restricted_block_statement(bool is_type_scope = false);
+
+		/**
+		 * Parses the module from the current lexeme on and runs the passes over it.
+		 *
+		 * @returns the root of the module.
+		 */
+		ir::ast::statement::restricted_block* parse_root();
+
+		/**
+		 * Releases the previous nodes of the module and parses it from the start.
+		 *
+		 * @returns the root of the module, also stored in the module body.
+		 */
+		ir::ast::statement::restricted_block* reparse_all();
 	public:
 		/**
 		 * Initialise parser with name of file being parsed, as well
@@ -177,12 +305,68 @@ namespace seam::parser
 		 * @param current_module the module to be parsed.
 		 * @param filename name of file to be parsed.
 		 * @param source source of file to parse.
+		 * @param mode whether to lex on demand or tokenize the whole file up front.
+		 */
+		explicit parser(std::shared_ptr<types::module> current_module, const std::string_view filename, const std::string_view source,
+			lexer::lexer_mode mode = lexer::lexer_mode::streaming);
+
+		/**
+		 * Initialise parser with a loaded source file, lexemes are views
+		 * directly into its (usually memory mapped) contents.
+		 *
+		 * @param current_module the module to be parsed.
+		 * @param source file to parse, kept alive for the lifetime of the parser.
+		 * @param mode whether to lex on demand or tokenize the whole file up front.
 		 */
-		explicit parser(std::shared_ptr<types::module> current_module, const std::string_view filename, const std::string_view source);
+		explicit parser(std::shared_ptr<types::module> current_module, std::shared_ptr<const utils::source_file> source,
+			lexer::lexer_mode mode = lexer::lexer_mode::streaming);
+
+		/**
+		 * Initialise parser with name of file being parsed, as well
+		 * as its already tokenized source.
+		 *
+		 * @param current_module the module to be parsed.
+		 * @param filename name of file to be parsed.
+		 * @param tokens tokens of file to parse, see lexer::lexer::tokenize.
+		 */
+		explicit parser(std::shared_ptr<types::module> current_module, const std::string_view filename,
+			std::shared_ptr<const lexer::token_buffer> tokens);
 
 		/**
 		 * TODO: Comment this
+		 *
+		 * @param bodies when to parse function bodies, lazily parsed bodies need the
+		 * parser (and so its source) to be alive until resolution is done.
+		 * @param workers number of threads parsing bodies in parallel, 0 for one per
+		 * hardware thread.
+		 */
+		ir::ast::statement::restricted_block* parse(body_parsing bodies = body_parsing::eager, std::size_t workers = 0);
+
+		/**
+		 * Reparses a module after edits to its source, reusing what they did not touch.
+		 *
+		 * Only the top-level statements overlapping an edit, and the functions calling a
+		 * function they define, are lexed and parsed again. The others keep their nodes,
+		 * moved to their new positions, and their resolution results. Edits touching a
+		 * type definition, a module with skipped bodies, or a statement that no longer
+		 * ends where it did make the whole source be parsed again, releasing the
+		 * previous nodes. So does reparsing once the nodes replaced since the module
+		 * was last parsed as a whole could take as much memory as the module did,
+		 * which bounds the memory of a module edited over and over.
+		 *
+		 * @note lexing stays local to the edits with a streaming lexer only.
+		 * @param edits non-overlapping edits that turned the previous source of the
+		 * module into the source of this parser.
+		 * @returns the root of the module, also stored in the module body.
+		 */
+		ir::ast::statement::restricted_block* reparse(const std::vector<text_edit>& edits);
+
+		/**
+		 * Returns the statistics of the passes last run by parse or reparse.
 		 */
-		std::unique_ptr<ir::ast::statement::restricted_block> parse();
+		[[nodiscard]] const std::vector<passes::pass_statistics>& pass_statistics() const
+		{
+			return pass_statistics_;
+		}
 	};
 }
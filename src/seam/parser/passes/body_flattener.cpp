@@ -0,0 +1,20 @@
+#include "body_flattener.hpp"
+#include "../../ir/ast/flat_expressions.hpp"
+
+namespace seam::parser::passes
+{
+	void body_flattener::run_function(pass_context& context, ir::ast::statement::function_definition* function)
+	{
+		function->flat_body = context.arena().make<ir::ast::flat_expressions>(function->body);
+		nodes_visited += function->flat_body->expressions.size();
+	}
+
+	std::unique_ptr<pass> body_flattener::fork() const
+	{
+		return std::make_unique<body_flattener>(*this);
+	}
+
+	body_flattener::body_flattener() :
+		pass("body_flattener", pass_scope::function, 0, analysis::flat_bodies)
+	{}
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "pass.hpp"
+
+namespace seam::parser::passes
+{
+	/**
+	 * Adds the flat encoding of their expressions to function definitions, see ir::ast::flat_expressions.
+	 */
+	struct body_flattener final : pass
+	{
+		void run_function(pass_context& context, ir::ast::statement::function_definition* function) override;
+		[[nodiscard]] std::unique_ptr<pass> fork() const override;
+
+		body_flattener();
+	};
+}
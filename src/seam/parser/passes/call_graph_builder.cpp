@@ -0,0 +1,15 @@
+#include "call_graph_builder.hpp"
+
+namespace seam::parser::passes
+{
+	void call_graph_builder::run_module(pass_context& context)
+	{
+		auto& calls = context.module.calls;
+		calls.build(context.definitions);
+		nodes_visited += calls.size();
+	}
+
+	call_graph_builder::call_graph_builder() :
+		pass("call_graph_builder", pass_scope::module, analysis::function_table | analysis::resolved_symbols, analysis::call_graph)
+	{}
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "pass.hpp"
+
+namespace seam::parser::passes
+{
+	/**
+	 * Builds module::calls from the function_dependencies of the definitions of the context.
+	 */
+	struct call_graph_builder final : pass
+	{
+		void run_module(pass_context& context) override;
+
+		call_graph_builder();
+	};
+}
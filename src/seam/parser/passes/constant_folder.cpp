@@ -0,0 +1,641 @@
+#include "constant_folder.hpp"
+#include "../../ir/ast/visitor.hpp"
+#include "../../lexer/lexeme.hpp"
+#include "../../types/constant_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace seam::parser::passes
+{
+	namespace
+	{
+		using built_in_type = ir::ast::type::built_in_type;
+		using value = constant_folder::value;
+
+		/**
+		 * Returns the numeric built-in type of an expression, nullptr if it has none.
+		 */
+		const built_in_type* numeric_type(const ir::ast::type* type)
+		{
+			if (!type)
+			{
+				return nullptr;
+			}
+
+			const auto built_in = std::get_if<built_in_type>(&type->value);
+			return built_in && *built_in >= built_in_type::i8 && *built_in <= built_in_type::f64 ? built_in : nullptr;
+		}
+
+		bool is_signed(const built_in_type type)
+		{
+			return type >= built_in_type::i8 && type <= built_in_type::i64;
+		}
+
+		bool is_floating(const built_in_type type)
+		{
+			return type == built_in_type::f32 || type == built_in_type::f64;
+		}
+
+		unsigned width(const built_in_type type)
+		{
+			switch (type)
+			{
+				case built_in_type::i8:
+				case built_in_type::u8:
+				{
+					return 8;
+				}
+				case built_in_type::i16:
+				case built_in_type::u16:
+				{
+					return 16;
+				}
+				case built_in_type::i32:
+				case built_in_type::u32:
+				case built_in_type::f32:
+				{
+					return 32;
+				}
+				default:
+				{
+					return 64;
+				}
+			}
+		}
+
+		/**
+		 * Truncates an integer to the width of its type, sign extending it for signed types.
+		 */
+		std::uint64_t normalize(std::uint64_t integer, const built_in_type type)
+		{
+			const auto bits = width(type);
+			if (bits == 64)
+			{
+				return integer;
+			}
+
+			const auto mask = (std::uint64_t{ 1 } << bits) - 1;
+			integer &= mask;
+			if (is_signed(type) && (integer >> (bits - 1)) != 0)
+			{
+				integer |= ~mask;
+			}
+			return integer;
+		}
+
+		/**
+		 * Rounds a floating point value to its type, monostate if the result is not finite.
+		 */
+		value round(const double floating, const built_in_type type)
+		{
+			const auto rounded = type == built_in_type::f32 ? static_cast<double>(static_cast<float>(floating)) : floating;
+			return std::isfinite(rounded) ? value{ rounded } : value{};
+		}
+
+		template <typename T>
+		bool compare(const lexer::lexeme_type operation, const T left, const T right)
+		{
+			switch (operation)
+			{
+				case lexer::lexeme_type::symbol_eq: return left == right;
+				case lexer::lexeme_type::symbol_neq: return left != right;
+				case lexer::lexeme_type::symbol_lt: return left < right;
+				case lexer::lexeme_type::symbol_lteq: return left <= right;
+				case lexer::lexeme_type::symbol_gt: return left > right;
+				default: return left >= right;
+			}
+		}
+
+		/**
+		 * Evaluates an integer operation of two operands of a type.
+		 *
+		 * @returns the result, monostate if the operation is not an integer operation or traps.
+		 */
+		value evaluate_integer(const lexer::lexeme_type operation, const std::uint64_t left, const std::uint64_t right, const built_in_type type)
+		{
+			switch (operation)
+			{
+				case lexer::lexeme_type::symbol_add: return normalize(left + right, type);
+				case lexer::lexeme_type::symbol_minus: return normalize(left - right, type);
+				case lexer::lexeme_type::symbol_multiply: return normalize(left * right, type);
+				case lexer::lexeme_type::symbol_divide:
+				case lexer::lexeme_type::symbol_mod:
+				{
+					if (right == 0)
+					{
+						return {};
+					}
+					if (!is_signed(type))
+					{
+						return operation == lexer::lexeme_type::symbol_divide ? left / right : left % right;
+					}
+
+					// Dividing the smallest value by -1 overflows, the generated code traps.
+					const auto signed_left = static_cast<std::int64_t>(left);
+					const auto signed_right = static_cast<std::int64_t>(right);
+					if (signed_right == -1 && left == normalize(std::uint64_t{ 1 } << (width(type) - 1), type))
+					{
+						return {};
+					}
+					return static_cast<std::uint64_t>(operation == lexer::lexeme_type::symbol_divide ? signed_left / signed_right : signed_left % signed_right);
+				}
+				default:
+				{
+					return {};
+				}
+			}
+		}
+
+		/**
+		 * Evaluates a floating point operation of two operands of a type.
+		 *
+		 * @returns the result, monostate if the operation is not a floating point operation or the result is not finite.
+		 */
+		value evaluate_floating(const lexer::lexeme_type operation, const double left, const double right, const built_in_type type)
+		{
+			switch (operation)
+			{
+				case lexer::lexeme_type::symbol_add: return round(left + right, type);
+				case lexer::lexeme_type::symbol_minus: return round(left - right, type);
+				case lexer::lexeme_type::symbol_multiply: return round(left * right, type);
+				case lexer::lexeme_type::symbol_divide: return round(left / right, type);
+				default: return {};
+			}
+		}
+
+		/**
+		 * Evaluates an expression whose operands were evaluated already.
+		 *
+		 * @returns the value of the expression, monostate if it is not constant.
+		 */
+		value evaluate(const ir::ast::flat_expressions& flat, const ir::ast::flat_expression& expression, const std::vector<value>& values,
+			const std::vector<std::pair<ir::ast::expression::variable*, value>>& bindings)
+		{
+			const auto type = numeric_type(expression.node->eval_type);
+			const auto operation = expression.operation();
+
+			switch (expression.kind())
+			{
+				case ir::ast::node_kind::bool_literal:
+				{
+					return static_cast<ir::ast::expression::bool_literal*>(expression.node)->value;
+				}
+				case ir::ast::node_kind::number_literal:
+				{
+					if (!type)
+					{
+						return {};
+					}
+
+					const auto& constant = static_cast<ir::ast::expression::number_literal*>(expression.node)->constant->value;
+					if (const auto integer = std::get_if<std::uint64_t>(&constant))
+					{
+						return is_floating(*type) ? round(static_cast<double>(*integer), *type) : value{ normalize(*integer, *type) };
+					}
+					return is_floating(*type) ? round(std::get<double>(constant), *type) : value{};
+				}
+				case ir::ast::node_kind::variable_ref:
+				{
+					const auto var = static_cast<ir::ast::expression::variable_ref*>(expression.node)->var;
+					const auto binding = std::lower_bound(bindings.cbegin(), bindings.cend(), var,
+						[](const auto& bound, const ir::ast::expression::variable* key) { return bound.first < key; });
+					return binding != bindings.cend() && binding->first == var ? binding->second : value{};
+				}
+				case ir::ast::node_kind::unary:
+				{
+					const auto& operand = values[expression.left];
+					if (operation == lexer::lexeme_type::symbol_not)
+					{
+						const auto boolean = std::get_if<bool>(&operand);
+						return boolean ? value{ !*boolean } : value{};
+					}
+					if (operation != lexer::lexeme_type::symbol_minus || !type)
+					{
+						return {};
+					}
+
+					if (const auto integer = std::get_if<std::uint64_t>(&operand))
+					{
+						return normalize(std::uint64_t{ 0 } - *integer, *type);
+					}
+					if (const auto floating = std::get_if<double>(&operand))
+					{
+						return -*floating;
+					}
+					return {};
+				}
+				case ir::ast::node_kind::binary:
+				{
+					const auto& left = values[expression.left];
+					const auto& right = values[expression.right];
+					if (std::holds_alternative<std::monostate>(left) || std::holds_alternative<std::monostate>(right))
+					{
+						return {};
+					}
+
+					switch (operation)
+					{
+						case lexer::lexeme_type::symbol_and:
+						case lexer::lexeme_type::symbol_or:
+						{
+							const auto left_boolean = std::get_if<bool>(&left);
+							const auto right_boolean = std::get_if<bool>(&right);
+							if (!left_boolean || !right_boolean)
+							{
+								return {};
+							}
+							return operation == lexer::lexeme_type::symbol_and ? *left_boolean && *right_boolean : *left_boolean || *right_boolean;
+						}
+						case lexer::lexeme_type::symbol_eq:
+						case lexer::lexeme_type::symbol_neq:
+						case lexer::lexeme_type::symbol_lt:
+						case lexer::lexeme_type::symbol_lteq:
+						case lexer::lexeme_type::symbol_gt:
+						case lexer::lexeme_type::symbol_gteq:
+						{
+							// Comparisons take the signedness of their operands, which share a type.
+							if (left.index() != right.index())
+							{
+								return {};
+							}
+							if (const auto boolean = std::get_if<bool>(&left))
+							{
+								if (operation != lexer::lexeme_type::symbol_eq && operation != lexer::lexeme_type::symbol_neq)
+								{
+									return {};
+								}
+								return compare(operation, *boolean, std::get<bool>(right));
+							}
+							if (const auto floating = std::get_if<double>(&left))
+							{
+								return compare(operation, *floating, std::get<double>(right));
+							}
+
+							const auto operand_type = numeric_type(flat.expressions[expression.left].node->eval_type);
+							if (!operand_type)
+							{
+								return {};
+							}
+							const auto left_integer = std::get<std::uint64_t>(left);
+							const auto right_integer = std::get<std::uint64_t>(right);
+							return is_signed(*operand_type) ?
+								compare(operation, static_cast<std::int64_t>(left_integer), static_cast<std::int64_t>(right_integer)) :
+								compare(operation, left_integer, right_integer);
+						}
+						default:
+						{
+							if (!type)
+							{
+								return {};
+							}
+
+							const auto left_integer = std::get_if<std::uint64_t>(&left);
+							const auto right_integer = std::get_if<std::uint64_t>(&right);
+							if (left_integer && right_integer && !is_floating(*type))
+							{
+								return evaluate_integer(operation, *left_integer, *right_integer, *type);
+							}
+
+							const auto left_floating = std::get_if<double>(&left);
+							const auto right_floating = std::get_if<double>(&right);
+							if (left_floating && right_floating && is_floating(*type))
+							{
+								return evaluate_floating(operation, *left_floating, *right_floating, *type);
+							}
+							return {};
+						}
+					}
+				}
+				default:
+				{
+					return {}; // calls, strings and symbols are not folded.
+				}
+			}
+		}
+
+		/**
+		 * Returns whether a value can be spelled as a literal, or a negated literal, of a type.
+		 */
+		bool is_representable(const value& folded, const ir::ast::type* type)
+		{
+			if (std::holds_alternative<bool>(folded))
+			{
+				return true;
+			}
+
+			const auto built_in = numeric_type(type);
+			const auto integer = std::get_if<std::uint64_t>(&folded);
+			if (!built_in || !integer || !is_signed(*built_in))
+			{
+				return built_in != nullptr;
+			}
+
+			// The smallest signed value has no positive literal to negate.
+			return *integer != normalize(std::uint64_t{ 1 } << (width(*built_in) - 1), *built_in);
+		}
+
+		// Collects the variable each assignment of a function assigns to.
+		struct assignment_collector
+		{
+			std::vector<ir::ast::expression::variable*>& assigned_;
+
+			bool visit(ir::ast::node* node)
+			{
+				return true;
+			}
+
+			bool visit(ir::ast::expression::expression* node)
+			{
+				return false;
+			}
+
+			bool visit(ir::ast::statement::assignment* node)
+			{
+				if (const auto var = node->to->as<ir::ast::expression::variable_ref>())
+				{
+					assigned_.push_back(var->var);
+				}
+				return false;
+			}
+		};
+	}
+
+	ir::ast::expression::expression* constant_folder::fold(ir::ast::expression::expression* root, value& folded)
+	{
+		const auto& flat = *function_->flat_body;
+		const auto span = flat.find(root);
+
+		for (auto index = span.first; index <= span.root; ++index)
+		{
+			const auto& expression = flat.expressions[index];
+			values_[index] = evaluate(flat, expression, values_, bindings_);
+			if (!is_representable(values_[index], expression.node->eval_type))
+			{
+				values_[index] = {};
+			}
+		}
+
+		// Literals and negated number literals are left as they are.
+		const auto is_literal = [&](const std::uint32_t index)
+		{
+			const auto& expression = flat.expressions[index];
+			return expression.kind() == ir::ast::node_kind::bool_literal || expression.kind() == ir::ast::node_kind::number_literal ||
+				(expression.kind() == ir::ast::node_kind::unary && flat.expressions[expression.left].kind() == ir::ast::node_kind::number_literal);
+		};
+
+		// Replaces an expression with the literal of its value, if it is constant.
+		const auto replace = [&](const std::uint32_t index, ir::ast::expression::expression*& child)
+		{
+			if (std::holds_alternative<std::monostate>(values_[index]) || is_literal(index))
+			{
+				return;
+			}
+
+			const auto node = flat.expressions[index].node;
+			ir::ast::expression::expression* literal;
+			if (const auto boolean = std::get_if<bool>(&values_[index]))
+			{
+				literal = arena_->make<ir::ast::expression::bool_literal>(node->range, *boolean);
+			}
+			else
+			{
+				const auto type = *numeric_type(node->eval_type);
+
+				auto negative = false;
+				std::variant<std::uint64_t, double> magnitude;
+				if (const auto integer = std::get_if<std::uint64_t>(&values_[index]))
+				{
+					negative = is_signed(type) && static_cast<std::int64_t>(*integer) < 0;
+					magnitude = negative ? std::uint64_t{ 0 } - *integer : *integer;
+				}
+				else
+				{
+					const auto floating = std::get<double>(values_[index]);
+					negative = std::signbit(floating);
+					magnitude = std::fabs(floating);
+				}
+
+				literal = arena_->make<ir::ast::expression::number_literal>(node->range, module_.constants.number(magnitude, type));
+				if (negative)
+				{
+					literal->eval_type = node->eval_type;
+					literal = arena_->make<ir::ast::expression::unary>(node->range, literal, lexer::lexeme_type::symbol_minus);
+				}
+			}
+			literal->eval_type = node->eval_type;
+			child = literal;
+			changed_ = true;
+		};
+
+		for (auto index = span.first; index <= span.root; ++index)
+		{
+			const auto& expression = flat.expressions[index];
+			if (!std::holds_alternative<std::monostate>(values_[index]))
+			{
+				continue; // replaced as a whole by its parent.
+			}
+
+			switch (expression.kind())
+			{
+				case ir::ast::node_kind::unary:
+				{
+					replace(expression.left, static_cast<ir::ast::expression::unary*>(expression.node)->right);
+					break;
+				}
+				case ir::ast::node_kind::binary:
+				{
+					const auto binary = static_cast<ir::ast::expression::binary*>(expression.node);
+					replace(expression.left, binary->left);
+					replace(expression.right, binary->right);
+					break;
+				}
+				case ir::ast::node_kind::call:
+				{
+					auto& arguments = static_cast<ir::ast::expression::call*>(expression.node)->arguments;
+					const auto flat_arguments = flat.call_arguments(expression);
+					for (std::size_t argument = 0; argument < flat_arguments.size(); ++argument)
+					{
+						replace(flat_arguments[argument], arguments[argument]);
+					}
+					break;
+				}
+				default:
+				{
+					break;
+				}
+			}
+		}
+
+		folded = values_[span.root];
+		replace(span.root, root);
+		return root;
+	}
+
+	void constant_folder::fold(ir::ast::statement::normal_block* block)
+	{
+		auto& body = block->body;
+		ir::ast::statement::statement_list kept;
+		auto pruned = false;
+
+		for (std::size_t index = 0; index < body.size(); ++index)
+		{
+			const auto statement = body[index];
+			auto dropped = false;
+			ir::ast::statement::normal_block* inlined = nullptr;
+
+			value folded;
+			switch (statement->kind)
+			{
+				case ir::ast::node_kind::assignment:
+				{
+					const auto assignment = static_cast<ir::ast::statement::assignment*>(statement);
+					assignment->from = fold(assignment->from, folded);
+
+					// Variables assigned once are bound where they are declared, before they can be read.
+					const auto var = assignment->to->as<ir::ast::expression::variable_ref>();
+					if (var && !std::holds_alternative<std::monostate>(folded) && var->var->type_ == assignment->from->eval_type)
+					{
+						const auto [first, last] = std::equal_range(assigned_.cbegin(), assigned_.cend(), var->var);
+						if (last - first == 1)
+						{
+							const auto position = std::lower_bound(bindings_.cbegin(), bindings_.cend(), var->var,
+								[](const auto& bound, const ir::ast::expression::variable* key) { return bound.first < key; });
+							bindings_.emplace(position, var->var, folded);
+						}
+					}
+					break;
+				}
+				case ir::ast::node_kind::ret:
+				{
+					const auto ret = static_cast<ir::ast::statement::ret*>(statement);
+					if (ret->value)
+					{
+						ret->value = fold(ret->value, folded);
+					}
+					break;
+				}
+				case ir::ast::node_kind::expression_:
+				{
+					const auto expression = static_cast<ir::ast::statement::expression_*>(statement);
+					expression->value = fold(expression->value, folded);
+					break;
+				}
+				case ir::ast::node_kind::normal_block:
+				{
+					fold(static_cast<ir::ast::statement::normal_block*>(statement));
+					break;
+				}
+				case ir::ast::node_kind::if_stat:
+				{
+					const auto if_stat = static_cast<ir::ast::statement::if_stat*>(statement);
+					if_stat->condition = fold(if_stat->condition, folded);
+					if (const auto condition = std::get_if<bool>(&folded))
+					{
+						inlined = *condition ? if_stat->main_body : if_stat->else_body;
+						dropped = true;
+						if (inlined)
+						{
+							fold(inlined);
+						}
+						break;
+					}
+
+					fold(if_stat->main_body);
+					if (if_stat->else_body)
+					{
+						fold(if_stat->else_body);
+					}
+					break;
+				}
+				case ir::ast::node_kind::while_loop:
+				{
+					const auto while_loop = static_cast<ir::ast::statement::while_loop*>(statement);
+					while_loop->condition = fold(while_loop->condition, folded);
+					if (const auto condition = std::get_if<bool>(&folded); condition && !*condition)
+					{
+						dropped = true;
+						break;
+					}
+					fold(while_loop->body);
+					break;
+				}
+				default:
+				{
+					break;
+				}
+			}
+
+			if (dropped && !pruned)
+			{
+				kept.insert(kept.end(), body.begin(), body.begin() + index);
+				pruned = true;
+			}
+
+			if (dropped)
+			{
+				if (inlined)
+				{
+					kept.insert(kept.end(), inlined->body.begin(), inlined->body.end());
+				}
+				changed_ = true;
+			}
+			else if (pruned)
+			{
+				kept.push_back(statement);
+			}
+		}
+
+		if (pruned)
+		{
+			body = std::move(kept);
+		}
+	}
+
+	void constant_folder::run_function(pass_context& context, ir::ast::statement::function_definition* function)
+	{
+		function_ = function;
+		arena_ = &context.arena();
+		changed_ = false;
+		assigned_.clear();
+		bindings_.clear();
+		values_.resize(function->flat_body->expressions.size());
+
+		assignment_collector collector{ assigned_ };
+		function->body->visit(&collector);
+		std::sort(assigned_.begin(), assigned_.end());
+
+		fold(function->body);
+		nodes_visited += function->flat_body->expressions.size();
+
+		if (!changed_)
+		{
+			return;
+		}
+
+		// Calls in dropped branches are no longer dependencies.
+		function->flat_body = arena_->make<ir::ast::flat_expressions>(function->body);
+		function->function_dependencies.clear();
+		for (const auto& expression : function->flat_body->expressions)
+		{
+			if (expression.kind() == ir::ast::node_kind::symbol_wrapper)
+			{
+				const auto symbol = static_cast<ir::ast::expression::symbol_wrapper*>(expression.node)->value;
+				function->function_dependencies.insert(static_cast<ir::ast::expression::resolved_symbol*>(symbol)->signature);
+			}
+		}
+	}
+
+	std::unique_ptr<pass> constant_folder::fork() const
+	{
+		return std::make_unique<constant_folder>(*this);
+	}
+
+	constant_folder::constant_folder(seam::types::module& module_) :
+		pass("constant_folder", pass_scope::function, analysis::resolved_symbols | analysis::flat_bodies | analysis::expression_types, 0,
+			all_analyses & ~analysis::call_graph),
+		module_(module_)
+	{}
+}
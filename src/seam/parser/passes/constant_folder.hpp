@@ -0,0 +1,61 @@
+#pragma once
+
+#include "pass.hpp"
+#include "../../ir/ast/expression.hpp"
+#include "../../ir/ast/flat_expressions.hpp"
+
+#include <cstdint>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace seam::parser::passes
+{
+	/**
+	 * Folds constant subexpressions of function bodies into literals, and drops
+	 * branches of if statements and while loops whose conditions are constant.
+	 *
+	 * Integers are folded at the width and signedness of their type, wrapping
+	 * like the generated code. Divisions by zero, overflowing signed divisions and
+	 * floating point results that are not finite are left to run. Variables bound
+	 * once to a constant are replaced by it where they are read.
+	 *
+	 * Changed bodies are flattened again and their function_dependencies taken
+	 * from what is left, so flat bodies and resolved symbols stay valid.
+	 */
+	struct constant_folder : pass
+	{
+		/**
+		 * Value of a constant expression: integers are kept sign extended (for signed types)
+		 * or zero extended to 64 bits, f32 values rounded to float.
+		 */
+		using value = std::variant<std::monostate, std::uint64_t, double, bool>;
+
+		seam::types::module& module_; // folded literals take their constants from the module's pool.
+		ir::ast::statement::function_definition* function_ = nullptr; // function being folded.
+		utils::arena* arena_ = nullptr; // arena folded literals are allocated in.
+		bool changed_ = false; // whether the body of the function changed.
+		std::vector<ir::ast::expression::variable*> assigned_; // variable of each assignment of the function, sorted.
+		std::vector<std::pair<ir::ast::expression::variable*, value>> bindings_; // variables bound to a constant, sorted by variable.
+		std::vector<value> values_; // value of each flat expression of the function, monostate if not constant.
+
+		void run_function(pass_context& context, ir::ast::statement::function_definition* function) override;
+		[[nodiscard]] std::unique_ptr<pass> fork() const override;
+
+		/**
+		 * Folds an expression referred to by a statement.
+		 *
+		 * @param root expression.
+		 * @param folded set to the value of the expression, monostate if not constant.
+		 * @returns the expression to refer to instead, root itself unless it folded to a literal.
+		 */
+		ir::ast::expression::expression* fold(ir::ast::expression::expression* root, value& folded);
+
+		/**
+		 * Folds the statements of a block, dropping or inlining branches with constant conditions.
+		 */
+		void fold(ir::ast::statement::normal_block* block);
+
+		explicit constant_folder(seam::types::module& module_);
+	};
+}
@@ -3,36 +3,67 @@
 #include "../../ir/ast/statement.hpp"
 #include "../../ir/ast/visitor.hpp"
 
+#include <cstddef>
 #include <sstream>
+#include <utility>
 
 namespace seam::parser::passes
 {
     using namespace ir::ast;
 
-    struct collector : visitor
+    struct collector
 	{
 		function_collector::function_map& function_map_;
+		std::vector<statement::function_definition*>& definitions_;
+		std::size_t& nodes_visited_;
 
-        bool visit(statement::extern_function_definition* node) override
+        bool visit(ir::ast::node* node)
         {
+            ++nodes_visited_;
+            return true;
+        }
+
+        bool visit(expression::expression* node)
+        {
+            ++nodes_visited_;
+            return false; // functions are only defined by statements.
+        }
+
+        bool visit(statement::extern_function_definition* node)
+        {
+            ++nodes_visited_;
             function_map_.emplace(node->signature->name, node->signature);
             return false;
         }
 
-        bool visit(statement::function_definition* node) override
+        bool visit(statement::function_definition* node)
 		{
+            ++nodes_visited_;
             function_map_.emplace(node->signature->name, node->signature);
+            definitions_.push_back(node);
             return true;
 		}
     	
-		explicit collector(function_collector::function_map& function_map_) :
-            function_map_(function_map_)
+		explicit collector(function_collector::function_map& function_map_, std::vector<statement::function_definition*>& definitions_,
+            std::size_t& nodes_visited_) :
+            function_map_(function_map_), definitions_(definitions_), nodes_visited_(nodes_visited_)
         {}
 	};
 
     void function_collector::run(node* node)
     {
-	    collector vst{ function_map_ };
+	    collector vst{ function_map_, definitions_, nodes_visited };
 	    node->visit(&vst);
     }
+
+    void function_collector::run_module(pass_context& context)
+    {
+        run(context.root);
+        context.module.functions = std::move(function_map_);
+        context.definitions = std::move(definitions_);
+    }
+
+    function_collector::function_collector() :
+        pass("function_collector", pass_scope::module, 0, analysis::function_table)
+    {}
 }
@@ -2,18 +2,31 @@
 
 #include "pass.hpp"
 #include "../../ir/ast/expression.hpp"
+#include "../../ir/ast/statement.hpp"
 
-#include <memory>
 #include <unordered_map>
-#include <string>
+#include <vector>
 
 namespace seam::parser::passes
 {
     struct function_collector final : pass
 	{
-		using function_map = std::unordered_map<std::string, std::shared_ptr<ir::ast::expression::function_signature>>;
+		using function_map = decltype(seam::types::module::functions);
 		function_map function_map_;
+		std::vector<ir::ast::statement::function_definition*> definitions_; // function definitions in source order.
 
-		void run(ir::ast::node* node) override;
+		/**
+		 * Collects the functions of a subtree, without touching the module.
+		 *
+		 * @param node root of the subtree.
+		 */
+		void run(ir::ast::node* node);
+
+		/**
+		 * Collects the functions of the module into module::functions and the definitions of the context.
+		 */
+		void run_module(pass_context& context) override;
+
+		function_collector();
 	};
 }
@@ -4,44 +4,170 @@
 #include "../../ir/ast/visitor.hpp"
 #include "../../ir/ast/expression.hpp"
 
-#include <memory>
+#include <cstddef>
 #include <sstream>
+#include <unordered_map>
+#include <utility>
 
 namespace seam::parser::passes
 {
     using namespace ir::ast;
 
-	struct resolver : visitor
+	struct resolver
 	{
 		const function_collector::function_map& function_map_;
+		seam::types::module& module_;
+		utils::arena* arena_; // resolved symbols are allocated in it.
+		std::vector<expression::function_signature*>* resolved_ = nullptr; // if set, receives every resolved signature.
+		std::vector<statement::function_definition*>* nested_ = nullptr; // if set, receives the definitions inside bodies.
+		std::size_t* nodes_visited_ = nullptr; // if set, counts the visited nodes.
+		statement::function_definition* function_ = nullptr; // innermost function being resolved.
 
-		bool visit(expression::symbol_wrapper* node) override
+		void count()
 		{
-			const auto& symbol_name = static_cast<expression::unresolved_symbol*>(node->value.get())->value;
+			if (nodes_visited_)
+			{
+				++*nodes_visited_;
+			}
+		}
+
+		bool visit(ir::ast::node* node)
+		{
+			count();
+			return true;
+		}
+
+		bool visit(statement::function_definition* node)
+		{
+			count();
+			if (function_ && nested_)
+			{
+				nested_->push_back(node);
+			}
+
+			const auto outer_function = function_;
+			function_ = node;
+			node->function_dependencies.clear();
+
+			node->signature->visit(this);
+			if (node->body)
+			{
+				node->body->visit(this);
+			}
+
+			function_ = outer_function;
+			return false;
+		}
+
+		bool visit(expression::symbol_wrapper* node)
+		{
+			count();
+			const auto symbol_name = static_cast<expression::unresolved_symbol*>(node->value)->value;
 			const auto& it = function_map_.find(symbol_name);
 			if (it == function_map_.cend())
 			{
 				std::stringstream error_message;
-				error_message << "cannot resolve symbol '" << symbol_name << '\'';
+				error_message << "cannot resolve symbol '" << module_.interner.spelling(symbol_name) << '\'';
 				throw utils::parser_exception{ node->range.start, error_message.str() };
 			}
-			node->value = std::make_unique<expression::resolved_symbol>(it->second);
+			node->value = arena_->make<expression::resolved_symbol>(it->second);
+			if (resolved_)
+			{
+				resolved_->push_back(it->second);
+			}
+			if (function_)
+			{
+				function_->function_dependencies.insert(it->second);
+			}
 			
 			return false;
 		}
 
-		resolver(const function_collector::function_map& function_map_) :
-			function_map_(function_map_)
+		resolver(const function_collector::function_map& function_map_, seam::types::module& module_) :
+			function_map_(function_map_), module_(module_), arena_(&module_.arena)
 		{}
 	};
 
-	void function_resolver::run(node* node)
+	void function_resolver::run_function(pass_context& context, statement::function_definition* function)
+	{
+		function_ = function;
+		function->function_dependencies.clear();
+	}
+
+	void function_resolver::visit_node(pass_context& context, node* node)
 	{
-		resolver vst{ function_map_ };
-		node->visit(&vst);
+		resolver vst{ function_map_, module_ };
+		vst.arena_ = &context.arena();
+		vst.function_ = function_;
+		vst.visit(static_cast<expression::symbol_wrapper*>(node));
 	}
 
-	function_resolver::function_resolver(const function_collector::function_map& function_map_) :
-		function_map_(function_map_)
+	void function_resolver::run_module(pass_context& context)
+	{
+		run_reachable(context.definitions, parse_body_);
+	}
+
+	std::unique_ptr<pass> function_resolver::fork() const
+	{
+		return scope == pass_scope::node ? std::make_unique<function_resolver>(*this) : nullptr;
+	}
+
+	void function_resolver::run_reachable(std::vector<statement::function_definition*>& definitions, const body_parser& parse_body)
+	{
+		// Definitions not reached yet, removed once queued.
+		std::unordered_map<expression::function_signature*, statement::function_definition*> unreached;
+		std::vector<statement::function_definition*> worklist;
+		for (const auto definition : definitions)
+		{
+			const auto& attributes = definition->signature->attributes;
+			if (attributes.find("constructor") != attributes.cend() || attributes.find("export") != attributes.cend())
+			{
+				worklist.push_back(definition);
+			}
+			else
+			{
+				unreached.emplace(definition->signature, definition);
+			}
+		}
+
+		std::vector<expression::function_signature*> resolved;
+		std::vector<statement::function_definition*> nested;
+		resolver vst{ function_map_, module_ };
+		vst.resolved_ = &resolved;
+		vst.nested_ = &nested;
+		vst.nodes_visited_ = &nodes_visited;
+
+		for (std::size_t index = 0; index < worklist.size(); ++index)
+		{
+			const auto definition = worklist[index];
+			if (!definition->body)
+			{
+				parse_body(definition);
+			}
+			definition->visit(&vst);
+
+			for (const auto signature : resolved)
+			{
+				if (const auto it = unreached.find(signature); it != unreached.cend())
+				{
+					worklist.push_back(it->second);
+					unreached.erase(it);
+				}
+			}
+			resolved.clear();
+		}
+
+		definitions.insert(definitions.cend(), nested.cbegin(), nested.cend());
+	}
+
+	function_resolver::function_resolver(const function_collector::function_map& function_map_, seam::types::module& module_) :
+		pass("function_resolver", pass_scope::node, analysis::function_table, analysis::resolved_symbols, all_analyses,
+			kind_flag(node_kind::symbol_wrapper)),
+		function_map_(function_map_), module_(module_)
+	{}
+
+	function_resolver::function_resolver(const function_collector::function_map& function_map_, seam::types::module& module_, body_parser parse_body) :
+		pass("function_resolver", pass_scope::module, analysis::function_table, analysis::resolved_symbols),
+		function_map_(function_map_), module_(module_), parse_body_(std::move(parse_body))
 	{}
 }
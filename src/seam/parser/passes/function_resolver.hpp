@@ -5,12 +5,43 @@
 
 namespace seam::parser::passes
 {
+	/**
+	 * Resolves the symbols of function bodies to the signatures they name.
+	 *
+	 * A node pass visiting the symbols of every function, or, with a body parser,
+	 * a module pass resolving only the functions reachable from the root functions.
+	 */
 	struct function_resolver : pass
 	{
 		const function_collector::function_map& function_map_;
+		seam::types::module& module_; // resolved symbols are allocated in the arena of the pass context, the module arena outside parallel rounds.
+		body_parser parse_body_;
+		ir::ast::statement::function_definition* function_ = nullptr; // function whose symbols are being visited.
 
-		void run(ir::ast::node* node) override;
+		void run_function(pass_context& context, ir::ast::statement::function_definition* function) override;
+		void visit_node(pass_context& context, ir::ast::node* node) override;
+		void run_module(pass_context& context) override;
 
-		explicit function_resolver(const function_collector::function_map& function_map_);
+		/**
+		 * Forks the node pass, the module pass parses bodies and stays on one thread.
+		 */
+		[[nodiscard]] std::unique_ptr<pass> fork() const override;
+
+		/**
+		 * Resolves only the functions reachable from the root (@constructor or @export)
+		 * functions, parsing skipped bodies as they are reached.
+		 *
+		 * @param definitions function definitions of the module, in source order, receives
+		 * the definitions found in parsed bodies.
+		 * @param parse_body parses a skipped body.
+		 */
+		void run_reachable(std::vector<ir::ast::statement::function_definition*>& definitions, const body_parser& parse_body);
+
+		explicit function_resolver(const function_collector::function_map& function_map_, seam::types::module& module_);
+
+		/**
+		 * @param parse_body parses skipped bodies, see run_reachable.
+		 */
+		explicit function_resolver(const function_collector::function_map& function_map_, seam::types::module& module_, body_parser parse_body);
 	};
 }
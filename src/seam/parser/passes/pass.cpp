@@ -1,21 +1,297 @@
 #include "pass.hpp"
 
+#include "body_flattener.hpp"
+#include "call_graph_builder.hpp"
+#include "constant_folder.hpp"
 #include "function_collector.hpp"
 #include "function_resolver.hpp"
+#include "pass_manager.hpp"
 #include "types.hpp"
+#include "../../ir/ast/visitor.hpp"
+#include "../../utils/exception.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace seam::parser::passes
 {
-    void pass::run_passes(ir::ast::node* root)
+    std::vector<pass_statistics> pass::run_passes(ir::ast::node* root, seam::types::module& module, const body_parser& parse_body)
+    {
+        pass_manager manager;
+        manager.add<function_collector>();
+        if (parse_body)
+        {
+            // Bodies are parsed as resolution reaches them, and flattened afterwards.
+            manager.add<function_resolver>(module.functions, module, parse_body);
+            manager.add<body_flattener>();
+        }
+        else
+        {
+            manager.add<body_flattener>();
+            manager.add<function_resolver>(module.functions, module);
+        }
+        manager.add<types>(module.types);
+        manager.add<constant_folder>(module);
+        manager.add<call_graph_builder>();
+
+        pass_context context{ module, root };
+        return manager.run(context);
+    }
+
+    namespace
+    {
+        // Moves every node of a subtree by the same distance.
+        struct position_shifter
+        {
+            std::int64_t shift;
+
+            void move(utils::position& position) const
+            {
+                position.offset = static_cast<std::uint32_t>(position.offset + shift);
+            }
+
+            bool visit(ir::ast::node* node)
+            {
+                move(node->range.start);
+                move(node->range.end);
+                return true;
+            }
+
+            bool visit(ir::ast::expression::function_signature* node)
+            {
+                return true; // signatures have no position of their own, their parameters do.
+            }
+
+            bool visit(ir::ast::statement::extern_function_definition* node)
+            {
+                node->signature->visit(this);
+                return visit(static_cast<ir::ast::node*>(node));
+            }
+
+            bool visit(ir::ast::statement::class_type_definition* node)
+            {
+                for (const auto field : node->fields)
+                {
+                    field->visit(this);
+                }
+                return visit(static_cast<ir::ast::node*>(node));
+            }
+
+            explicit position_shifter(const std::int64_t shift) :
+                shift(shift)
+            {}
+        };
+
+        using signature_set = std::unordered_set<ir::ast::expression::function_signature*>;
+        using rebind_list = std::vector<std::pair<ir::ast::expression::resolved_symbol*, ir::ast::expression::function_signature*>>;
+
+        // Finds the calls of a function to replaced functions and what they call now.
+        struct rebinder
+        {
+            const signature_set& replaced_;
+            const function_collector::function_map& functions_;
+            const seam::types::module& module_;
+            std::int64_t shift_; // distance the function moved by, for diagnostics.
+            rebind_list& rebinds_;
+
+            bool visit(ir::ast::expression::symbol_wrapper* node)
+            {
+                // Functions only depend on replaced functions once resolved.
+                const auto symbol = static_cast<ir::ast::expression::resolved_symbol*>(node->value);
+                if (replaced_.find(symbol->signature) == replaced_.cend())
+                {
+                    return false;
+                }
+
+                const auto it = functions_.find(symbol->signature->name);
+                if (it == functions_.cend())
+                {
+                    std::stringstream error_message;
+                    error_message << "cannot resolve symbol '" << module_.interner.spelling(symbol->signature->name) << '\'';
+                    throw utils::parser_exception{ { static_cast<std::uint32_t>(node->range.start.offset + shift_) }, error_message.str() };
+                }
+
+                rebinds_.emplace_back(symbol, it->second);
+                return false;
+            }
+
+            rebinder(const signature_set& replaced, const function_collector::function_map& functions, const seam::types::module& module,
+                const std::int64_t shift, rebind_list& rebinds) :
+                replaced_(replaced), functions_(functions), module_(module), shift_(shift), rebinds_(rebinds)
+            {}
+        };
+    }
+
+    namespace
+    {
+        // Signatures of the functions and methods a collector collected.
+        signature_set signatures_of(const function_collector& collector)
+        {
+            signature_set signatures;
+            for (const auto& [name, signature] : collector.function_map_)
+            {
+                signatures.insert(signature);
+            }
+            for (const auto definition : collector.definitions_)
+            {
+                signatures.insert(definition->signature);
+            }
+            return signatures;
+        }
+
+        // Whether a function definition, or a method of a class, calls one of the signatures.
+        bool calls_any(ir::ast::statement::restricted* statement, const signature_set& signatures)
+        {
+            if (const auto definition = statement->as<ir::ast::statement::function_definition>())
+            {
+                const auto& dependencies = definition->function_dependencies;
+                return std::any_of(dependencies.cbegin(), dependencies.cend(), [&](const auto signature) { return signatures.count(signature) != 0; });
+            }
+            if (const auto class_definition = statement->as<ir::ast::statement::class_type_definition>())
+            {
+                const auto& methods = class_definition->body->body;
+                return std::any_of(methods.cbegin(), methods.cend(), [&](const auto method) { return calls_any(method, signatures); });
+            }
+            return false;
+        }
+    }
+
+    std::vector<std::size_t> pass::find_callers(const seam::types::module& module, const std::size_t first, const std::size_t count)
+    {
+        const auto& body = module.body->body;
+
+        function_collector defined;
+        for (auto index = first; index < first + count; ++index)
+        {
+            defined.run(body[index]);
+        }
+        const auto signatures = signatures_of(defined);
+
+        std::vector<std::size_t> callers;
+        for (std::size_t index = 0; index < body.size(); ++index)
+        {
+            if ((index < first || index >= first + count) && calls_any(body[index], signatures))
+            {
+                callers.push_back(index);
+            }
+        }
+        return callers;
+    }
+
+    std::vector<pass_statistics> pass::run_incremental_passes(seam::types::module& module, const std::vector<statement_replacement>& replacements,
+        const std::size_t moved, const std::int64_t shift)
     {
-        // resolve symbols (types and functions)
-        function_collector function_collector_;
-		function_collector_.run(root);
+        auto& body = module.body->body;
+
+        // Functions defined by the replaced statements, including methods, and by the statements replacing them.
+        function_collector replaced_functions;
+        function_collector replacing_functions;
+        std::vector<bool> is_replaced(body.size());
+        for (const auto& replacement : replacements)
+        {
+            for (auto index = replacement.first; index < replacement.first + replacement.count; ++index)
+            {
+                replaced_functions.run(body[index]);
+                is_replaced[index] = true;
+            }
+            for (const auto statement : replacement.statements)
+            {
+                replacing_functions.run(statement);
+            }
+        }
+        const auto replaced = signatures_of(replaced_functions);
+
+        auto functions = module.functions;
+        for (auto it = functions.begin(); it != functions.end();)
+        {
+            it = replaced.find(it->second) != replaced.cend() ? functions.erase(it) : std::next(it);
+        }
+        functions.insert(replacing_functions.function_map_.cbegin(), replacing_functions.function_map_.cend());
+
+        pass_manager manager{ analysis::function_table };
+        manager.add<body_flattener>();
+        manager.add<function_resolver>(functions, module);
+        manager.add<types>(module.types);
+        manager.add<constant_folder>(module);
+
+        pass_context context{ module, nullptr, std::move(replacing_functions.definitions_) };
+        auto statistics = manager.run(context);
+
+        // The statements left in place that call a replaced function are bound again.
+        // Functions declared inside function bodies are not tracked.
+        rebind_list rebinds;
+        std::vector<std::pair<ir::ast::statement::function_definition*, std::size_t>> dependents; // with their first rebind.
+
+        const auto find_dependents = [&](ir::ast::statement::restricted* statement, const std::int64_t statement_shift, const auto& recurse) -> void
+        {
+            if (const auto definition = statement->as<ir::ast::statement::function_definition>())
+            {
+                if (calls_any(definition, replaced))
+                {
+                    dependents.emplace_back(definition, rebinds.size());
+                    rebinder vst{ replaced, functions, module, statement_shift, rebinds };
+                    definition->visit(&vst);
+                }
+            }
+            else if (const auto class_definition = statement->as<ir::ast::statement::class_type_definition>())
+            {
+                for (const auto method : class_definition->body->body)
+                {
+                    recurse(method, statement_shift, recurse);
+                }
+            }
+        };
+
+        for (std::size_t index = 0; index < body.size(); ++index)
+        {
+            if (!is_replaced[index])
+            {
+                find_dependents(body[index], index >= moved ? shift : 0, find_dependents);
+            }
+        }
+
+        // Every pass succeeded, update the module.
+        for (std::size_t dependent = 0; dependent < dependents.size(); ++dependent)
+        {
+            const auto [definition, first_rebind] = dependents[dependent];
+            const auto last_rebind = dependent + 1 < dependents.size() ? dependents[dependent + 1].second : rebinds.size();
+
+            auto& dependencies = definition->function_dependencies;
+            for (auto it = dependencies.begin(); it != dependencies.end();)
+            {
+                it = replaced.find(*it) != replaced.cend() ? dependencies.erase(it) : std::next(it);
+            }
+            for (auto rebind = first_rebind; rebind < last_rebind; ++rebind)
+            {
+                rebinds[rebind].first->signature = rebinds[rebind].second;
+                dependencies.insert(rebinds[rebind].second);
+            }
+        }
 
-        function_resolver function_resolver_{ function_collector_.function_map_ };
-		function_resolver_.run(root);
+        if (shift != 0)
+        {
+            position_shifter shifter{ shift };
+            for (auto index = moved; index < body.size(); ++index)
+            {
+                if (!is_replaced[index])
+                {
+                    body[index]->visit(&shifter);
+                }
+            }
+        }
 
-		types types_;
-		types_.run(root);
+        // Spliced in from the last run on, so the indices of the runs before it hold.
+        for (auto replacement = replacements.crbegin(); replacement != replacements.crend(); ++replacement)
+        {
+            const auto first = body.begin() + static_cast<std::ptrdiff_t>(replacement->first);
+            body.insert(body.erase(first, first + static_cast<std::ptrdiff_t>(replacement->count)), replacement->statements.cbegin(), replacement->statements.cend());
+        }
+        module.functions = std::move(functions);
+        module.calls.build(module.body);
+        return statistics;
     }
-}
\ No newline at end of file
+}
@@ -1,14 +1,185 @@
 #pragma once
 
 #include "../../ir/ast/node.hpp"
+#include "../../ir/ast/statement.hpp"
+#include "../../types/module.hpp"
+#include "../../utils/arena.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
 
 namespace seam::parser::passes
 {
+    /**
+     * What passes provide to and require from each other, see pass_manager.
+     */
+    enum analysis : std::uint32_t
+    {
+        function_table = 1 << 0, // module::functions, and pass_context::definitions.
+        flat_bodies = 1 << 1, // function_definition::flat_body of every function with a body.
+        resolved_symbols = 1 << 2, // symbols refer to the signatures they name, function_dependencies are filled.
+        variable_types = 1 << 3, // variables declared without a type have the type of the value assigned to them.
+        expression_types = 1 << 4, // expression::eval_type of every expression, except symbols naming functions.
+        call_graph = 1 << 5, // module::calls, built from function_dependencies.
+    };
+
+    using analysis_set = std::uint32_t; // analysis flags.
+    constexpr analysis_set all_analyses = ~analysis_set{ 0 };
+
+    using node_kind_set = std::uint32_t; // node_kind flags, see kind_flag.
+
+    constexpr node_kind_set kind_flag(const ir::ast::node_kind kind)
+    {
+        return node_kind_set{ 1 } << static_cast<unsigned>(kind);
+    }
+
+    /**
+     * How much of a module a pass works on at once.
+     */
+    enum class pass_scope : std::uint8_t
+    {
+        module, // the whole module.
+        function, // a function definition, every function is handed to it in turn.
+        node, // nodes of a function body in post-order, all node passes next to each other share a single walk.
+    };
+
+    /**
+     * What passes work on.
+     */
+    struct pass_context
+    {
+        seam::types::module& module;
+        ir::ast::node* root; // root of the module, nullptr when passes run over replacement statements.
+        std::vector<ir::ast::statement::function_definition*> definitions; // function definitions in source order, see analysis::function_table.
+        utils::arena* worker_arena = nullptr; // set for the workers of a parallel round, see arena.
+
+        /**
+         * Returns the arena passes allocate nodes in: the module arena, or the
+         * arena of the worker, handed to the module once the round is over.
+         */
+        [[nodiscard]] utils::arena& arena() const
+        {
+            return worker_arena ? *worker_arena : module.arena;
+        }
+    };
+
+    /**
+     * Time, nodes and allocations spent by a pass during a pass_manager::run.
+     */
+    struct pass_statistics
+    {
+        const char* name;
+        std::chrono::nanoseconds time{ 0 }; // wall time, summed over the workers of parallel rounds.
+        std::size_t nodes = 0; // nodes visited.
+        std::size_t allocations = 0; // heap allocations, only counted with a pass_manager::allocation_counter.
+        std::size_t arena_bytes = 0; // bytes allocated in the module arena.
+    };
+
+    /**
+     * A run of a module's top-level statements and the statements replacing it,
+     * see pass::run_incremental_passes.
+     */
+    struct statement_replacement
+    {
+        std::size_t first; // index of the first replaced statement.
+        std::size_t count; // number of replaced statements.
+        ir::ast::statement::restricted_list statements; // statements replacing them, parsed at their new positions.
+    };
+
     struct pass
     {
-        virtual void run(ir::ast::node* node) = 0;
+        const char* name;
+        pass_scope scope;
+        analysis_set required; // analyses that must be valid when the pass runs.
+        analysis_set provided; // analyses valid after the pass ran.
+        analysis_set preserved; // analyses the pass leaves valid, besides the ones it provides.
+        node_kind_set node_kinds; // kinds of the nodes handed to a node pass.
+        std::size_t nodes_visited = 0; // counted by module and function passes themselves.
+
+        explicit pass(const char* name, const pass_scope scope, const analysis_set required, const analysis_set provided,
+            const analysis_set preserved = all_analyses, const node_kind_set node_kinds = 0) :
+            name(name), scope(scope), required(required), provided(provided), preserved(preserved), node_kinds(node_kinds)
+        {}
+
         virtual ~pass() = default;
 
-        static void run_passes(ir::ast::node* root);
+        /**
+         * Runs a module pass.
+         */
+        virtual void run_module(pass_context& context) {}
+
+        /**
+         * Runs a function pass over a function with a body, or prepares a node pass
+         * to visit the nodes of one.
+         *
+         * @param function function definition.
+         */
+        virtual void run_function(pass_context& context, ir::ast::statement::function_definition* function) {}
+
+        /**
+         * Visits a node of the function last handed to run_function, after its children.
+         *
+         * @param node node of a kind in node_kinds.
+         */
+        virtual void visit_node(pass_context& context, ir::ast::node* node) {}
+
+        /**
+         * Copies a function or node pass for a worker of a parallel round. The copy
+         * only ever sees the functions handed to that worker, and must not write
+         * anything shared with the other workers besides those functions.
+         *
+         * @returns the copy, or nullptr if the pass must see every function on one thread.
+         */
+        [[nodiscard]] virtual std::unique_ptr<pass> fork() const { return nullptr; }
+
+        /**
+         * Parses the skipped body of a function definition, see parser::body_parsing.
+         */
+        using body_parser = std::function<void(ir::ast::statement::function_definition*)>;
+
+        /**
+         * Runs every pass over a parsed module.
+         *
+         * @param root root of the module.
+         * @param module module the root belongs to.
+         * @param parse_body if set, function bodies were skipped and are parsed as resolution
+         * reaches them from a root (@constructor or @export) function, the others stay unparsed.
+         * @returns statistics of every pass.
+         */
+        static std::vector<pass_statistics> run_passes(ir::ast::node* root, seam::types::module& module, const body_parser& parse_body = {});
+
+        /**
+         * Finds the top-level statements outside a run of statements that call a
+         * function defined in the run.
+         *
+         * @param module module whose body holds the statements.
+         * @param first index of the first statement of the run.
+         * @param count number of statements in the run.
+         * @returns indices of the calling statements, in source order.
+         */
+        static std::vector<std::size_t> find_callers(const seam::types::module& module, std::size_t first, std::size_t count);
+
+        /**
+         * Runs every pass over statements replacing runs of a module's top-level statements.
+         *
+         * The other statements keep their nodes, calls to replaced functions are bound to
+         * the functions replacing them. Their types are kept as well, so statements whose
+         * types may depend on a replaced function (see find_callers) must be replaced too.
+         *
+         * The module is left untouched if a pass fails.
+         *
+         * @param module module whose body holds the statements being replaced.
+         * @param replacements replaced runs in source order, not overlapping.
+         * @param moved index of the first statement following the edits of the source,
+         * it and the statements after it moved by shift.
+         * @param shift distance the source after the edits moved by.
+         * @returns statistics of the passes run over the replacements.
+         */
+        static std::vector<pass_statistics> run_incremental_passes(seam::types::module& module, const std::vector<statement_replacement>& replacements,
+            std::size_t moved, std::int64_t shift);
     };
 }
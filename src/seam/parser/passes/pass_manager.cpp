@@ -0,0 +1,362 @@
+#include "pass_manager.hpp"
+#include "../../ir/ast/flat_expressions.hpp"
+#include "../../ir/ast/visitor.hpp"
+#include "../../utils/work_stealing.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace seam::parser::passes
+{
+    std::size_t (*pass_manager::allocation_counter)() = nullptr;
+
+    namespace
+    {
+        constexpr auto node_kind_count = static_cast<std::size_t>(ir::ast::node::last_kind) + 1;
+
+        // Fewer functions per worker do not pay for starting its thread.
+        constexpr std::size_t min_functions_per_worker = 16;
+
+        // Kinds of expression::expression, function_signature and the parameters of its signature.
+        constexpr auto expression_kinds = []
+        {
+            node_kind_set kinds = 0;
+            for (auto kind = static_cast<std::size_t>(ir::ast::expression::expression::first_kind); kind <= static_cast<std::size_t>(ir::ast::node_kind::function_signature); ++kind)
+            {
+                kinds |= kind_flag(static_cast<ir::ast::node_kind>(kind));
+            }
+            return kinds;
+        }();
+
+        /**
+         * Measures what a pass spends while running a function.
+         *
+         * @param statistics statistics of the pass.
+         * @param context context of the pass, its arena is measured.
+         * @param function function to measure.
+         */
+        template <typename Function>
+        void measure(pass_statistics& statistics, const pass_context& context, Function&& function)
+        {
+            const auto allocations = pass_manager::allocation_counter ? pass_manager::allocation_counter() : 0;
+            const auto arena_bytes = context.arena().bytes_used();
+            const auto start = std::chrono::steady_clock::now();
+
+            function();
+
+            statistics.time += std::chrono::steady_clock::now() - start;
+            statistics.arena_bytes += context.arena().bytes_used() - arena_bytes;
+            if (pass_manager::allocation_counter)
+            {
+                statistics.allocations += pass_manager::allocation_counter() - allocations;
+            }
+        }
+
+        // Passes of a round over the function definitions, see pass_manager.
+        struct step
+        {
+            std::vector<std::size_t> passes; // a function pass, or node passes sharing a walk.
+            node_kind_set node_kinds = 0; // kinds any of the node passes visit.
+            std::array<std::vector<std::size_t>, node_kind_count> by_kind; // node passes by the kinds they visit.
+        };
+
+        // Hands the nodes of a function to the node passes of a step, after their children.
+        // Expressions are read from the flat encoding of the body if there is one, which
+        // keeps deep expression trees from recursing.
+        struct walker
+        {
+            const std::vector<std::unique_ptr<pass>>& passes_;
+            std::vector<pass_statistics>& statistics_;
+            pass_context& context_;
+            const step& step_;
+            ir::ast::statement::function_definition* function_;
+
+            bool visit(ir::ast::statement::function_definition* node)
+            {
+                return node == function_; // nested definitions are walked as functions of their own.
+            }
+
+            bool visit(ir::ast::expression::function_signature* node)
+            {
+                if (!(step_.node_kinds & expression_kinds))
+                {
+                    return false;
+                }
+
+                for (const auto parameter : node->parameters)
+                {
+                    leave(parameter);
+                }
+                leave(node);
+                return false;
+            }
+
+            bool visit(ir::ast::expression::expression* node)
+            {
+                if (!(step_.node_kinds & expression_kinds))
+                {
+                    return false;
+                }
+
+                const auto flat = function_->flat_body;
+                if (!flat)
+                {
+                    return true;
+                }
+
+                const auto span = flat->find(node);
+                for (auto index = span.first; index <= span.root; ++index)
+                {
+                    leave(flat->expressions[index].node);
+                }
+                return false;
+            }
+
+            void leave(ir::ast::node* node)
+            {
+                if (!(step_.node_kinds & kind_flag(node->kind)))
+                {
+                    return;
+                }
+
+                for (const auto index : step_.by_kind[static_cast<std::size_t>(node->kind)])
+                {
+                    passes_[index]->visit_node(context_, node);
+                    ++statistics_[index].nodes;
+                }
+            }
+        };
+
+        /**
+         * Measures a call of a pass, counting the nodes it reports visiting.
+         */
+        template <typename Function>
+        void measure_counted(const std::vector<std::unique_ptr<pass>>& passes, std::vector<pass_statistics>& statistics, const std::size_t index,
+            const pass_context& context, Function&& function)
+        {
+            const auto nodes_visited = passes[index]->nodes_visited;
+            measure(statistics[index], context, function);
+            statistics[index].nodes += passes[index]->nodes_visited - nodes_visited;
+        }
+
+        /**
+         * Runs the steps of a round over a function with a body.
+         */
+        void run_steps(const std::vector<step>& steps, const std::vector<std::unique_ptr<pass>>& passes, std::vector<pass_statistics>& statistics,
+            pass_context& context, ir::ast::statement::function_definition* function)
+        {
+            for (const auto& current_step : steps)
+            {
+                for (const auto index : current_step.passes)
+                {
+                    measure_counted(passes, statistics, index, context, [&] { passes[index]->run_function(context, function); });
+                }
+
+                if (current_step.node_kinds)
+                {
+                    // The walk is measured once, measuring every visit would cost more than
+                    // most of them. Its node passes are charged an equal share of it.
+                    pass_statistics walk{ nullptr };
+                    measure(walk, context, [&]
+                    {
+                        walker vst{ passes, statistics, context, current_step, function };
+                        function->visit(&vst);
+                    });
+
+                    const auto share = current_step.passes.size();
+                    const auto time_share = static_cast<std::chrono::nanoseconds::rep>(share);
+                    for (const auto index : current_step.passes)
+                    {
+                        // The first pass is also charged what does not divide evenly.
+                        const auto first = index == current_step.passes.front();
+                        statistics[index].time += walk.time / time_share + (first ? walk.time % time_share : std::chrono::nanoseconds{ 0 });
+                        statistics[index].allocations += walk.allocations / share + (first ? walk.allocations % share : 0);
+                        statistics[index].arena_bytes += walk.arena_bytes / share + (first ? walk.arena_bytes % share : 0);
+                    }
+                }
+            }
+        }
+
+        // What a worker of a parallel round works with.
+        struct worker
+        {
+            utils::arena arena;
+            std::vector<std::unique_ptr<pass>> passes; // forks of the passes of the round, by index.
+            std::vector<pass_statistics> statistics;
+            pass_context context;
+
+            explicit worker(seam::types::module& module, ir::ast::node* root) :
+                context{ module, root, {}, &arena }
+            {}
+        };
+
+        /**
+         * Spreads a round over worker threads, see pass_manager.
+         *
+         * @param passes passes of the manager.
+         * @param first first pass of the round.
+         * @param last pass following the round.
+         * @param steps steps of the round.
+         * @param statistics statistics of the manager, receives the sums of the workers.
+         * @param context context of the manager.
+         * @param worker_count number of workers.
+         * @returns false, running nothing, if a pass of the round cannot be forked.
+         */
+        bool run_parallel(const std::vector<std::unique_ptr<pass>>& passes, const std::size_t first, const std::size_t last,
+            const std::vector<step>& steps, std::vector<pass_statistics>& statistics, pass_context& context, const std::size_t worker_count)
+        {
+            std::vector<std::unique_ptr<worker>> workers;
+            workers.reserve(worker_count);
+            for (std::size_t index = 0; index < worker_count; ++index)
+            {
+                auto& current = *workers.emplace_back(std::make_unique<worker>(context.module, context.root));
+                current.passes.resize(passes.size());
+                for (auto pass_index = first; pass_index < last; ++pass_index)
+                {
+                    current.passes[pass_index] = passes[pass_index]->fork();
+                    if (!current.passes[pass_index])
+                    {
+                        return false;
+                    }
+                    current.passes[pass_index]->nodes_visited = 0;
+                }
+                for (const auto& added : statistics)
+                {
+                    current.statistics.push_back({ added.name });
+                }
+            }
+
+            const auto& definitions = context.definitions;
+            std::vector<std::exception_ptr> errors(definitions.size()); // by definition.
+            std::atomic<std::size_t> first_error{ definitions.size() };
+
+            utils::parallel_for(definitions.size(), worker_count, [&](const std::size_t worker_index, const std::size_t index)
+            {
+                // Functions after a failed one cannot change which error is reported.
+                const auto function = definitions[index];
+                if (index > first_error.load(std::memory_order_relaxed) || !function->body)
+                {
+                    return;
+                }
+
+                auto& current = *workers[worker_index];
+                try
+                {
+                    run_steps(steps, current.passes, current.statistics, current.context, function);
+                }
+                catch (...)
+                {
+                    errors[index] = std::current_exception();
+                    auto failed = first_error.load();
+                    while (index < failed && !first_error.compare_exchange_weak(failed, index))
+                    {
+                    }
+                }
+            });
+
+            for (auto& current : workers)
+            {
+                for (auto index = first; index < last; ++index)
+                {
+                    const auto& worker_statistics = current->statistics[index];
+                    statistics[index].time += worker_statistics.time;
+                    statistics[index].nodes += worker_statistics.nodes;
+                    statistics[index].allocations += worker_statistics.allocations;
+                    statistics[index].arena_bytes += worker_statistics.arena_bytes;
+                }
+                context.arena().adopt(current->arena);
+            }
+
+            for (const auto& error : errors)
+            {
+                if (error)
+                {
+                    std::rethrow_exception(error);
+                }
+            }
+            return true;
+        }
+    }
+
+    pass_manager::pass_manager(const analysis_set available, const std::size_t workers) :
+        available_(available), workers_(workers != 0 ? workers : std::max(std::thread::hardware_concurrency(), 1u))
+    {}
+
+    void pass_manager::add(std::unique_ptr<pass> added)
+    {
+        if (added->required & ~available_)
+        {
+            throw std::logic_error{ std::string{ "pass '" } + added->name + "' requires analyses no pass before it provides" };
+        }
+
+        available_ = (available_ & added->preserved) | added->provided;
+        passes_.push_back(std::move(added));
+    }
+
+    std::vector<pass_statistics> pass_manager::run(pass_context& context)
+    {
+        std::vector<pass_statistics> statistics;
+        statistics.reserve(passes_.size());
+        for (const auto& added : passes_)
+        {
+            statistics.push_back({ added->name });
+        }
+
+        for (std::size_t first = 0; first < passes_.size();)
+        {
+            if (passes_[first]->scope == pass_scope::module)
+            {
+                measure_counted(passes_, statistics, first, context, [&] { passes_[first]->run_module(context); });
+                ++first;
+                continue;
+            }
+
+            // A round over the functions, up to the next module pass.
+            std::vector<step> steps;
+            auto last = first;
+            for (; last < passes_.size() && passes_[last]->scope != pass_scope::module; ++last)
+            {
+                const auto& current = *passes_[last];
+                if (current.scope == pass_scope::function || steps.empty() || passes_[last - 1]->scope != pass_scope::node)
+                {
+                    steps.emplace_back();
+                }
+
+                auto& current_step = steps.back();
+                current_step.passes.push_back(last);
+                if (current.scope == pass_scope::node)
+                {
+                    current_step.node_kinds |= current.node_kinds;
+                    for (std::size_t kind = 0; kind < node_kind_count; ++kind)
+                    {
+                        if (current.node_kinds & kind_flag(static_cast<ir::ast::node_kind>(kind)))
+                        {
+                            current_step.by_kind[kind].push_back(last);
+                        }
+                    }
+                }
+            }
+
+            const auto worker_count = std::min(workers_, context.definitions.size() / min_functions_per_worker);
+            if (worker_count <= 1 || !run_parallel(passes_, first, last, steps, statistics, context, worker_count))
+            {
+                for (const auto function : context.definitions)
+                {
+                    if (function->body) // skipped and never reached otherwise, see body_parsing::lazy.
+                    {
+                        run_steps(steps, passes_, statistics, context, function);
+                    }
+                }
+            }
+            first = last;
+        }
+
+        return statistics;
+    }
+}
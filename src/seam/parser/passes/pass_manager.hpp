@@ -0,0 +1,84 @@
+#pragma once
+
+#include "pass.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace seam::parser::passes
+{
+    /**
+     * Runs passes over a module in the order they were added.
+     *
+     * Module passes run by themselves. Function and node passes added one after
+     * another are fused into a single round over the function definitions: every
+     * function is handed to each of them in turn before moving on to the next, and
+     * node passes next to each other share one post-order walk of its body, so an
+     * added analysis costs a visit of the nodes it is interested in rather than
+     * another walk of the whole module.
+     *
+     * In a walk a node is only visited after its children, so a node pass sees the
+     * analyses of the node passes before it for the subtree of the node and the
+     * nodes preceding it. Analyses of other functions are only complete once the
+     * round is over. Expressions of functions with a flat body (analysis::flat_bodies)
+     * are read from it rather than the trees.
+     *
+     * If every pass of a round can be forked (see pass::fork), the functions are
+     * spread over worker threads that steal work from each other. Should passes
+     * throw, the error of the function first in source order is rethrown once
+     * every worker is done.
+     */
+    class pass_manager
+    {
+        std::vector<std::unique_ptr<pass>> passes_; // in order.
+        analysis_set available_; // analyses valid after the last added pass.
+        std::size_t workers_; // threads a round may use.
+    public:
+        /**
+         * Counts the heap allocations the calling thread made so far, for
+         * pass_statistics::allocations. The compiler does not count them, tools
+         * replacing operator new can.
+         */
+        static std::size_t (*allocation_counter)();
+
+        /**
+         * @param available analyses already valid before the first pass.
+         * @param workers threads a round over the functions may use, 0 for every hardware thread.
+         */
+        explicit pass_manager(analysis_set available = 0, std::size_t workers = 0);
+
+        /**
+         * Adds a pass, run after the passes added before it.
+         *
+         * @param added pass to add.
+         * @throws std::logic_error if the pass requires an analysis that is not valid after the passes before it.
+         */
+        void add(std::unique_ptr<pass> added);
+
+        /**
+         * Constructs and adds a pass, see add.
+         *
+         * @param args arguments forwarded to the constructor of T.
+         * @returns the pass, owned by the manager.
+         */
+        template <typename T, typename... Args>
+        T& add(Args&&... args)
+        {
+            auto added = std::make_unique<T>(std::forward<Args>(args)...);
+            auto& result = *added;
+            add(std::move(added));
+            return result;
+        }
+
+        /**
+         * Runs the passes.
+         *
+         * @param context what the passes work on, definitions must be filled if
+         * the manager was created with analysis::function_table available.
+         * @returns statistics of every pass, in order.
+         */
+        std::vector<pass_statistics> run(pass_context& context);
+    };
+}
@@ -1,97 +1,355 @@
 #include "types.hpp"
 #include "../../ir/ast/visitor.hpp"
+#include "../../lexer/lexeme.hpp"
+#include "../../types/constant_pool.hpp"
 #include "../../utils/exception.hpp"
 
-#include <iostream>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <variant>
+#include <vector>
 
 namespace seam::parser::passes
 {
-	std::shared_ptr<ir::ast::type> get_dominant_type(const std::shared_ptr<ir::ast::type>& a, const std::shared_ptr<ir::ast::type>& b)
+	namespace
 	{
-		const auto built_in_type_a = std::get_if<ir::ast::type::built_in_type>(&a->value);
-		const auto built_in_type_b = std::get_if<ir::ast::type::built_in_type>(&b->value);
+		enum class dominance : std::uint8_t
+		{
+			none, // no implicit conversion between the types.
+			left,
+			right,
+		};
+
+		using built_in_type = ir::ast::type::built_in_type;
+		constexpr auto built_in_count = static_cast<std::size_t>(built_in_type::f64) + 1;
 
-		if (built_in_type_a && built_in_type_b)
+		// Which of two built-in types the other converts to, integers of the same
+		// signedness and floating point types convert to the wider one.
+		constexpr auto dominance_table = []
 		{
-			if (((*built_in_type_a >= ir::ast::type::built_in_type::i8 && *built_in_type_a <= ir::ast::type::built_in_type::i64)
-				&& (*built_in_type_b >= ir::ast::type::built_in_type::i8 && *built_in_type_b <= ir::ast::type::built_in_type::i64))
+			const auto family = [](const built_in_type type)
+			{
+				if (type >= built_in_type::i8 && type <= built_in_type::i64) return 1;
+				if (type >= built_in_type::u8 && type <= built_in_type::u64) return 2;
+				if (type >= built_in_type::f32 && type <= built_in_type::f64) return 3;
+				return 0;
+			};
 
-				|| ((*built_in_type_a >= ir::ast::type::built_in_type::u8 && *built_in_type_a <= ir::ast::type::built_in_type::u64)
-					&& (*built_in_type_b >= ir::ast::type::built_in_type::u8 && *built_in_type_b <= ir::ast::type::built_in_type::u64))
+			std::array<std::array<dominance, built_in_count>, built_in_count> table{};
+			for (std::size_t a = 0; a < built_in_count; ++a)
+			{
+				for (std::size_t b = 0; b < built_in_count; ++b)
+				{
+					const auto family_a = family(static_cast<built_in_type>(a));
+					if (family_a != 0 && family_a == family(static_cast<built_in_type>(b)))
+					{
+						table[a][b] = a >= b ? dominance::left : dominance::right;
+					}
+				}
+			}
+			return table;
+		}();
+	}
+
+	ir::ast::type* get_dominant_type(ir::ast::type* a, ir::ast::type* b)
+	{
+		const auto built_in_type_a = std::get_if<built_in_type>(&a->value);
+		const auto built_in_type_b = std::get_if<built_in_type>(&b->value);
+
+		if (!built_in_type_a || !built_in_type_b)
+		{
+			throw std::runtime_error("class types are not supported");
+		}
 
-				|| ((*built_in_type_a >= ir::ast::type::built_in_type::f32 && *built_in_type_a <= ir::ast::type::built_in_type::f64))
-					&& (*built_in_type_b >= ir::ast::type::built_in_type::f32 && *built_in_type_b <= ir::ast::type::built_in_type::f64))
+		switch (dominance_table[static_cast<std::size_t>(*built_in_type_a)][static_cast<std::size_t>(*built_in_type_b)])
+		{
+			case dominance::left:
+			{
+				return a;
+			}
+			case dominance::right:
 			{
-				return (built_in_type_a > built_in_type_b) ? a : b;
+				return b;
 			}
-			else
+			default:
 			{
 				throw std::runtime_error("can't determine dominant type, probably a type error");
 			}
 		}
-		else
+	}
+
+	namespace
+	{
+		// Walks the statements of a function body, typing each expression they refer to.
+		struct typer
 		{
-			throw std::runtime_error("class types are not supported");
+			types& pass_;
+
+			ir::ast::type* infer(ir::ast::expression::expression* root, ir::ast::type* expected) const
+			{
+				return pass_.infer(pass_.function_->flat_body->find(root), expected);
+			}
+
+			bool visit(ir::ast::node* node)
+			{
+				return true;
+			}
+
+			bool visit(ir::ast::expression::expression* node)
+			{
+				infer(node, nullptr);
+				return false;
+			}
+
+			bool visit(ir::ast::statement::assignment* node)
+			{
+				const auto var = node->to->as<ir::ast::expression::variable_ref>();
+				const auto declared = var && var->var->type_ == pass_.auto_type_;
+
+				const auto type = infer(node->from, var && !declared ? var->var->type_ : nullptr);
+				if (declared)
+				{
+					var->var->type_ = type;
+				}
+				infer(node->to, nullptr);
+				return false;
+			}
+
+			bool visit(ir::ast::statement::ret* node)
+			{
+				if (node->value)
+				{
+					infer(node->value, pass_.function_->signature->return_type);
+				}
+				return false;
+			}
+		};
+
+		bool is_comparison(const lexer::lexeme_type operation)
+		{
+			switch (operation)
+			{
+				case lexer::lexeme_type::symbol_eq:
+				case lexer::lexeme_type::symbol_neq:
+				case lexer::lexeme_type::symbol_lt:
+				case lexer::lexeme_type::symbol_lteq:
+				case lexer::lexeme_type::symbol_gt:
+				case lexer::lexeme_type::symbol_gteq:
+				{
+					return true;
+				}
+				default:
+				{
+					return false;
+				}
+			}
 		}
 	}
 
-	struct type_getter : ir::ast::visitor
+	ir::ast::type* types::infer(const ir::ast::flat_expressions::span span, ir::ast::type* expected)
 	{
-		std::shared_ptr<ir::ast::type> type;
+		const auto& flat = *function_->flat_body;
+		const auto type_of = [&](const std::uint32_t index) { return flat.expressions[index].node->eval_type; };
 
-		bool visit(ir::ast::expression::variable_ref* var) override
+		for (auto index = span.first; index <= span.root; ++index)
 		{
-			type = var->var->type_;
-			return false;
+			const auto& expression = flat.expressions[index];
+			const auto operation = expression.operation();
+
+			ir::ast::type* type = nullptr;
+			switch (expression.kind())
+			{
+				case ir::ast::node_kind::number_literal:
+				{
+					type = static_cast<ir::ast::expression::number_literal*>(expression.node)->constant->suffix_type;
+					break;
+				}
+				case ir::ast::node_kind::bool_literal:
+				{
+					type = bool_type_;
+					break;
+				}
+				case ir::ast::node_kind::string_literal:
+				{
+					type = string_type_;
+					break;
+				}
+				case ir::ast::node_kind::variable_ref:
+				{
+					type = static_cast<ir::ast::expression::variable_ref*>(expression.node)->var->type_;
+					break;
+				}
+				case ir::ast::node_kind::unary:
+				{
+					if (operation == lexer::lexeme_type::symbol_not)
+					{
+						settle(expression.left, nullptr);
+						type = bool_type_;
+					}
+					else
+					{
+						type = type_of(expression.left);
+					}
+					break;
+				}
+				case ir::ast::node_kind::binary:
+				{
+					if (operation == lexer::lexeme_type::symbol_and || operation == lexer::lexeme_type::symbol_or)
+					{
+						settle(expression.left, nullptr);
+						settle(expression.right, nullptr);
+						type = bool_type_;
+					}
+					else
+					{
+						type = unify(expression.left, expression.right);
+						if (is_comparison(operation))
+						{
+							// Literals compared with each other settle to one type, as if added.
+							expression.node->eval_type = nullptr;
+							if (!type)
+							{
+								settle(index, nullptr);
+							}
+							type = bool_type_;
+						}
+					}
+					break;
+				}
+				case ir::ast::node_kind::call:
+				{
+					const auto& function = flat.expressions[expression.left];
+					const ir::ast::expression::function_signature* signature = nullptr;
+					if (function.kind() == ir::ast::node_kind::symbol_wrapper)
+					{
+						const auto symbol = static_cast<ir::ast::expression::symbol_wrapper*>(function.node)->value;
+						signature = static_cast<ir::ast::expression::resolved_symbol*>(symbol)->signature;
+						type = signature->return_type;
+					}
+
+					const auto arguments = flat.call_arguments(expression);
+					for (std::size_t argument = 0; argument < arguments.size(); ++argument)
+					{
+						const auto parameter = signature && argument < signature->parameters.size() ? signature->parameters[argument]->var->type_ : nullptr;
+						settle(arguments[argument], parameter);
+					}
+					break;
+				}
+				default:
+				{
+					break; // symbols name functions, which have no type of their own.
+				}
+			}
+			expression.node->eval_type = type;
 		}
 
-		bool visit(ir::ast::expression::number_literal* num) override
+		settle(span.root, expected == auto_type_ ? nullptr : expected);
+		return type_of(span.root);
+	}
+
+	void types::settle(const std::uint32_t index, ir::ast::type* type)
+	{
+		const auto& expressions = function_->flat_body->expressions;
+		const auto is_untyped = [&](const std::uint32_t candidate)
+		{
+			const auto kind = expressions[candidate].kind();
+			return expressions[candidate].node->eval_type == nullptr &&
+				(kind == ir::ast::node_kind::number_literal || kind == ir::ast::node_kind::unary || kind == ir::ast::node_kind::binary);
+		};
+
+		if (!is_untyped(index))
 		{
-			return false;
+			return;
 		}
 
-		bool visit(ir::ast::expression::binary* binary) override
+		// Only literals, negations and arithmetic of untyped operands are untyped.
+		auto is_float = false;
+		untyped_.assign(1, { index, false });
+		for (std::size_t next = 0; next < untyped_.size(); ++next)
 		{
-			binary->left->visit(this);
-			const auto left_type = type;
+			const auto& expression = expressions[untyped_[next].index];
+			if (expression.kind() == ir::ast::node_kind::number_literal)
+			{
+				is_float |= std::holds_alternative<double>(static_cast<ir::ast::expression::number_literal*>(expression.node)->constant->value);
+				continue;
+			}
 
-			binary->right->visit(this);
-			const auto right_type = type;
+			if (is_untyped(expression.left))
+			{
+				const auto negated = expression.kind() == ir::ast::node_kind::unary
+					&& expression.operation() == lexer::lexeme_type::symbol_minus;
+				untyped_.push_back({ expression.left, negated });
+			}
+			if (expression.kind() == ir::ast::node_kind::binary && is_untyped(expression.right))
+			{
+				untyped_.push_back({ expression.right, false });
+			}
+		}
 
-			type = get_dominant_type(left_type, right_type);
+		if (!type)
+		{
+			type = context_.built_in(is_float ? ir::ast::type::built_in_type::f64 : ir::ast::type::built_in_type::i32);
+		}
+		else if (const auto optional = std::get_if<ir::ast::optional_descriptor>(&type->value))
+		{
+			type = optional->value_type; // the value is wrapped where it is assigned.
+		}
 
-			return false;
+		for (const auto [untyped, negated] : untyped_)
+		{
+			const auto node = expressions[untyped].node;
+			if (const auto literal = node->as<ir::ast::expression::number_literal>(); literal && !seam::types::fits(*literal->constant, type, negated))
+			{
+				std::stringstream error_message;
+				error_message << "number literal '" << literal->constant->spelling << "' does not fit the type it is used as";
+				throw utils::parser_exception{ node->range.start, error_message.str() };
+			}
+			node->eval_type = type;
 		}
-	};
+	}
 
-	std::shared_ptr<ir::ast::type> resolve_type(ir::ast::expression::expression* expr)
+	ir::ast::type* types::unify(const std::uint32_t left, const std::uint32_t right)
 	{
-		type_getter vst;
-		expr->visit(&vst);
-		return vst.type;
+		const auto& expressions = function_->flat_body->expressions;
+		const auto left_type = expressions[left].node->eval_type;
+		const auto right_type = expressions[right].node->eval_type;
+		if (left_type && right_type)
+		{
+			return left_type == right_type ? left_type : get_dominant_type(left_type, right_type);
+		}
+		if (!left_type && !right_type)
+		{
+			return nullptr; // settled together with the expression they are part of.
+		}
+
+		settle(left, right_type);
+		settle(right, left_type);
+		return left_type ? left_type : right_type;
 	}
 
-	struct visitor : ir::ast::visitor
+	void types::run_function(pass_context& context, ir::ast::statement::function_definition* function)
 	{
-		bool visit(ir::ast::statement::assignment* node) override
+		function_ = function;
+		for (const auto parameter : function->signature->parameters)
 		{
-			if (const auto var = dynamic_cast<ir::ast::expression::variable_ref*>(node->to.get()))
-			{
-				if (const auto built_in = std::get_if<ir::ast::type::built_in_type>(&var->var->type_->value))
-				{
-					if (*built_in == ir::ast::type::built_in_type::auto_)
-					{
-						var->var->type_ = resolve_type(node->from.get());
-					}
-				}
-			}
-			return false;
+			parameter->eval_type = parameter->var->type_;
 		}
-	};
 
-	void types::run(ir::ast::node* node)
+		typer vst{ *this };
+		function->body->visit(&vst);
+		nodes_visited += function->flat_body->expressions.size();
+	}
+
+	std::unique_ptr<pass> types::fork() const
 	{
-		visitor vst;
-		node->visit(&vst);
+		return std::make_unique<types>(*this);
 	}
+
+	types::types(seam::types::type_context& context_) :
+		pass("types", pass_scope::function, analysis::resolved_symbols | analysis::flat_bodies, analysis::variable_types | analysis::expression_types),
+		context_(context_), auto_type_(context_.built_in(ir::ast::type::built_in_type::auto_)),
+		bool_type_(context_.built_in(ir::ast::type::built_in_type::bool_)), string_type_(context_.built_in(ir::ast::type::built_in_type::string))
+	{}
 }
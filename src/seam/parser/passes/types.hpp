@@ -1,12 +1,65 @@
 #pragma once
 
 #include "pass.hpp"
+#include "../../ir/ast/flat_expressions.hpp"
 #include "../../ir/ast/node.hpp"
 
+#include <cstdint>
+#include <vector>
+
 namespace seam::parser::passes
 {
+	/**
+	 * Infers the type of every expression, operands first, and stamps it on
+	 * expression::eval_type. Each expression is read once from the flat body of
+	 * its function. Variables declared without a type take the type of the
+	 * value assigned to them.
+	 *
+	 * Number literals without a suffix take the type they are used as: that of
+	 * the other operand, the parameter, the variable assigned to or the return
+	 * type, i32 (f64 with a fraction or exponent) if there is none.
+	 */
 	struct types : pass
 	{
-		void run(ir::ast::node* node) override;
+		seam::types::type_context& context_;
+		ir::ast::type* auto_type_;
+		ir::ast::type* bool_type_;
+		ir::ast::type* string_type_;
+		ir::ast::statement::function_definition* function_ = nullptr; // function being typed.
+
+		struct untyped_expression
+		{
+			std::uint32_t index; // index in the flat body.
+			bool negated; // whether it is a literal negated by its parent, see seam::types::fits.
+		};
+		std::vector<untyped_expression> untyped_; // scratch space for the expressions settle types.
+
+		void run_function(pass_context& context, ir::ast::statement::function_definition* function) override;
+		[[nodiscard]] std::unique_ptr<pass> fork() const override;
+
+		/**
+		 * Types the expressions of a span.
+		 *
+		 * @param span span of the expression referred to by a statement.
+		 * @param expected type the statement uses the expression as, or nullptr.
+		 * @returns type of the expression, nullptr for function symbols.
+		 */
+		ir::ast::type* infer(ir::ast::flat_expressions::span span, ir::ast::type* expected);
+
+		/**
+		 * Gives an expression made of number literals without a suffix a type.
+		 *
+		 * @param index index of the expression in the flat body, nothing happens unless it has no type yet.
+		 * @param type type the expression is used as, or nullptr for the default.
+		 * @throws utils::parser_exception if a literal does not fit the type.
+		 */
+		void settle(std::uint32_t index, ir::ast::type* type);
+
+		/**
+		 * Returns the type two operands have in common, settling a literal operand to the other's type.
+		 */
+		ir::ast::type* unify(std::uint32_t left, std::uint32_t right);
+
+		explicit types(seam::types::type_context& context_);
 	};
 }
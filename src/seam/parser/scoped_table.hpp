@@ -0,0 +1,138 @@
+#pragma once
+
+#include "../utils/interner.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace seam::parser
+{
+	/**
+	 * Flat table of lexically scoped bindings.
+	 *
+	 * Bindings are kept on a single stack, scopes only remember where they
+	 * start, so entering an empty scope allocates nothing. Each symbol
+	 * indexes straight to its innermost binding, which in turn links to the
+	 * binding it shadows, making lookup independent of nesting depth.
+	 *
+	 * @tparam T pointer type of the bound values, nullptr means unbound.
+	 */
+	template <typename T>
+	class scoped_table
+	{
+		static constexpr auto unbound = std::numeric_limits<std::uint32_t>::max();
+
+		struct binding
+		{
+			utils::symbol_id name;
+			T value;
+			std::uint32_t shadowed; // index of the binding this one hides, or unbound.
+		};
+
+		std::vector<binding> bindings_;
+		std::vector<std::size_t> scope_starts_;
+		std::vector<std::uint32_t> innermost_; // indexed by symbol_id.
+		std::size_t hidden_first_ = 0; // bindings_[hidden_first_, hidden_last_) are hidden, see hide.
+		std::size_t hidden_last_ = 0;
+
+		std::uint32_t& innermost(const utils::symbol_id name)
+		{
+			const auto index = static_cast<std::uint32_t>(name);
+			if (index >= innermost_.size())
+			{
+				innermost_.resize(index + 1, unbound);
+			}
+			return innermost_[index];
+		}
+	public:
+		/**
+		 * Opens a new innermost scope.
+		 */
+		void push_scope()
+		{
+			scope_starts_.push_back(bindings_.size());
+		}
+
+		/**
+		 * Closes the innermost scope, dropping every binding made in it.
+		 */
+		void pop_scope()
+		{
+			const auto start = scope_starts_.back();
+			scope_starts_.pop_back();
+
+			while (bindings_.size() > start)
+			{
+				const auto& dropped = bindings_.back();
+				innermost_[static_cast<std::uint32_t>(dropped.name)] = dropped.shadowed;
+				bindings_.pop_back();
+			}
+		}
+
+		/**
+		 * Binds a name in the innermost scope, shadowing outer bindings.
+		 *
+		 * @param name name to bind.
+		 * @param value value to bind the name to.
+		 */
+		void bind(const utils::symbol_id name, T value)
+		{
+			auto& head = innermost(name);
+			bindings_.push_back({ name, value, head });
+			head = static_cast<std::uint32_t>(bindings_.size() - 1);
+		}
+
+		/**
+		 * Finds the innermost binding of a name that is not hidden.
+		 *
+		 * @param name name to look up.
+		 * @returns bound value, or nullptr if the name is not bound in any open scope.
+		 */
+		[[nodiscard]] T find(const utils::symbol_id name) const
+		{
+			const auto index = static_cast<std::uint32_t>(name);
+			if (index >= innermost_.size())
+			{
+				return nullptr;
+			}
+
+			auto binding = innermost_[index];
+			while (binding != unbound && binding >= hidden_first_ && binding < hidden_last_)
+			{
+				binding = bindings_[binding].shadowed;
+			}
+			return binding != unbound ? bindings_[binding].value : nullptr;
+		}
+
+		/**
+		 * Returns the number of bindings in the open scopes.
+		 */
+		[[nodiscard]] std::size_t size() const
+		{
+			return bindings_.size();
+		}
+
+		/**
+		 * Hides every binding but the first ones from find, as if the scopes were
+		 * looked at when only those were made. Bindings made afterwards are found
+		 * as usual, until show_all.
+		 *
+		 * @param visible number of bindings left visible, see size.
+		 */
+		void hide(const std::size_t visible)
+		{
+			hidden_first_ = visible;
+			hidden_last_ = bindings_.size();
+		}
+
+		/**
+		 * Makes the bindings hidden by hide visible again.
+		 */
+		void show_all()
+		{
+			hidden_first_ = hidden_last_ = 0;
+		}
+	};
+}
@@ -0,0 +1,200 @@
+#include "call_graph.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace seam::types
+{
+	void call_graph::build(const std::vector<ir::ast::statement::function_definition*>& definitions)
+	{
+		signatures_.clear();
+		definitions_.clear();
+		functions_.clear();
+		callees_.clear();
+		edges_.clear();
+
+		functions_.reserve(definitions.size());
+		for (const auto definition : definitions)
+		{
+			functions_.emplace(definition->signature, static_cast<function_index>(signatures_.size()));
+			signatures_.push_back(definition->signature);
+			definitions_.push_back(definition);
+		}
+
+		// Functions without a definition are numbered as they are first called, those
+		// first called by the same function by name, so the numbering does not depend
+		// on the order of function_dependencies.
+		std::vector<ir::ast::expression::function_signature*> undefined;
+		callee_offsets_.assign(1, 0);
+		for (const auto definition : definitions)
+		{
+			const auto first = callees_.size();
+			undefined.clear();
+			for (const auto dependency : definition->function_dependencies)
+			{
+				if (const auto it = functions_.find(dependency); it != functions_.cend())
+				{
+					callees_.push_back(it->second);
+				}
+				else
+				{
+					undefined.push_back(dependency);
+				}
+			}
+
+			std::sort(undefined.begin(), undefined.end(), [](const auto a, const auto b) { return a->mangled_name < b->mangled_name; });
+			for (const auto signature : undefined)
+			{
+				const auto callee = static_cast<function_index>(signatures_.size());
+				functions_.emplace(signature, callee);
+				signatures_.push_back(signature);
+				definitions_.push_back(nullptr);
+				callees_.push_back(callee);
+			}
+
+			std::sort(callees_.begin() + static_cast<std::ptrdiff_t>(first), callees_.end());
+			callee_offsets_.push_back(static_cast<std::uint32_t>(callees_.size()));
+		}
+		callee_offsets_.resize(signatures_.size() + 1, static_cast<std::uint32_t>(callees_.size()));
+
+		// Callers are bucketed by callee, each bucket ends up sorted as callers are visited in order.
+		caller_offsets_.assign(signatures_.size() + 1, 0);
+		for (const auto callee : callees_)
+		{
+			++caller_offsets_[callee + 1];
+		}
+		for (std::size_t function = 0; function < signatures_.size(); ++function)
+		{
+			caller_offsets_[function + 1] += caller_offsets_[function];
+		}
+
+		callers_.resize(callees_.size());
+		edges_.reserve(callees_.size());
+		auto next = caller_offsets_;
+		for (function_index caller = 0; caller < definitions.size(); ++caller)
+		{
+			for (const auto callee : callees(caller))
+			{
+				callers_[next[callee]++] = caller;
+				edges_.insert(std::uint64_t{ caller } << 32 | callee);
+			}
+		}
+
+		find_components();
+	}
+
+	void call_graph::build(const ir::ast::statement::restricted_block* body)
+	{
+		std::vector<ir::ast::statement::function_definition*> definitions;
+		if (body)
+		{
+			for (const auto statement : body->body)
+			{
+				if (const auto definition = statement->as<ir::ast::statement::function_definition>())
+				{
+					definitions.push_back(definition);
+				}
+				else if (const auto class_definition = statement->as<ir::ast::statement::class_type_definition>())
+				{
+					for (const auto method : class_definition->body->body)
+					{
+						if (const auto definition = method->as<ir::ast::statement::function_definition>())
+						{
+							definitions.push_back(definition);
+						}
+					}
+				}
+			}
+		}
+		build(definitions);
+	}
+
+	void call_graph::find_components()
+	{
+		const auto count = static_cast<function_index>(signatures_.size());
+
+		// Tarjan's algorithm, with the recursion kept in frames: a component is complete
+		// once its first function is left, after the components it calls.
+		struct frame
+		{
+			function_index function;
+			std::uint32_t next; // next edge in callees_.
+		};
+
+		std::vector<std::uint32_t> discovered(count, npos); // discovery order.
+		std::vector<std::uint32_t> lowest(count); // earliest discovered function reachable on the stack.
+		std::vector<bool> on_stack(count);
+		std::vector<function_index> stack;
+		std::vector<frame> frames;
+
+		components_.assign(count, npos);
+		component_offsets_.assign(1, 0);
+		bottom_up_.clear();
+		bottom_up_.reserve(count);
+
+		std::uint32_t discovery = 0;
+		const auto enter = [&](const function_index function)
+		{
+			discovered[function] = lowest[function] = discovery++;
+			stack.push_back(function);
+			on_stack[function] = true;
+			frames.push_back({ function, callee_offsets_[function] });
+		};
+
+		for (function_index root = 0; root < count; ++root)
+		{
+			if (discovered[root] != npos)
+			{
+				continue;
+			}
+
+			enter(root);
+			while (!frames.empty())
+			{
+				const auto function = frames.back().function;
+				if (frames.back().next < callee_offsets_[function + 1])
+				{
+					const auto callee = callees_[frames.back().next++];
+					if (discovered[callee] == npos)
+					{
+						enter(callee);
+					}
+					else if (on_stack[callee])
+					{
+						lowest[function] = std::min(lowest[function], discovered[callee]);
+					}
+					continue;
+				}
+
+				frames.pop_back();
+				if (!frames.empty())
+				{
+					const auto caller = frames.back().function;
+					lowest[caller] = std::min(lowest[caller], lowest[function]);
+				}
+
+				if (lowest[function] == discovered[function])
+				{
+					const auto component = static_cast<std::uint32_t>(component_offsets_.size() - 1);
+					function_index member;
+					do
+					{
+						member = stack.back();
+						stack.pop_back();
+						on_stack[member] = false;
+						components_[member] = component;
+						bottom_up_.push_back(member);
+					} while (member != function);
+					component_offsets_.push_back(static_cast<std::uint32_t>(bottom_up_.size()));
+				}
+			}
+		}
+
+		top_down_.assign(bottom_up_.crbegin(), bottom_up_.crend());
+	}
+
+	bool call_graph::is_recursive(const function_index function) const
+	{
+		return component_functions(components_[function]).size() > 1 || calls(function, function);
+	}
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "../ir/ast/expression.hpp"
+#include "../ir/ast/statement.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace seam::types
+{
+	/**
+	 * The functions of a module and the functions each of them calls, taken from
+	 * function_definition::function_dependencies.
+	 *
+	 * Functions are numbered, definitions first in source order, then the
+	 * functions they call that have no definition (extern functions) in the order
+	 * they are first called. Edges are stored once per direction in contiguous
+	 * arrays, and hashed for constant time queries of a single edge.
+	 *
+	 * Functions calling each other form a component (Tarjan's strongly connected
+	 * components), components are ordered bottom-up: every component comes after
+	 * the components it calls.
+	 */
+	class call_graph
+	{
+	public:
+		using function_index = std::uint32_t;
+
+		/**
+		 * A run of function indices.
+		 */
+		struct function_range
+		{
+			const function_index* first;
+			const function_index* last;
+
+			[[nodiscard]] const function_index* begin() const { return first; }
+			[[nodiscard]] const function_index* end() const { return last; }
+			[[nodiscard]] std::size_t size() const { return static_cast<std::size_t>(last - first); }
+		};
+
+		static constexpr function_index npos = ~function_index{ 0 };
+
+	private:
+		std::vector<ir::ast::expression::function_signature*> signatures_; // by function.
+		std::vector<ir::ast::statement::function_definition*> definitions_; // by function, nullptr for functions without a definition.
+		std::unordered_map<const ir::ast::expression::function_signature*, function_index> functions_; // by signature.
+
+		std::vector<std::uint32_t> callee_offsets_; // callees of function f are callees_[callee_offsets_[f], callee_offsets_[f + 1]).
+		std::vector<function_index> callees_;
+		std::vector<std::uint32_t> caller_offsets_; // callers of function f are callers_[caller_offsets_[f], caller_offsets_[f + 1]).
+		std::vector<function_index> callers_;
+		std::unordered_set<std::uint64_t> edges_; // caller << 32 | callee.
+
+		std::vector<std::uint32_t> components_; // component of each function.
+		std::vector<std::uint32_t> component_offsets_; // functions of component c are bottom_up_[component_offsets_[c], component_offsets_[c + 1]).
+		std::vector<function_index> bottom_up_; // functions grouped by component, components bottom-up.
+		std::vector<function_index> top_down_; // bottom_up_ reversed.
+
+		/**
+		 * Numbers the strongly connected components of the graph, without recursion.
+		 */
+		void find_components();
+	public:
+		/**
+		 * Builds the graph of function definitions, replacing the previous one.
+		 *
+		 * @param definitions function definitions in source order.
+		 */
+		void build(const std::vector<ir::ast::statement::function_definition*>& definitions);
+
+		/**
+		 * Builds the graph of the function definitions and methods of a module.
+		 *
+		 * @param body body of the module, may be nullptr.
+		 */
+		void build(const ir::ast::statement::restricted_block* body);
+
+		/**
+		 * Returns the index of a function.
+		 *
+		 * @param signature signature of the function.
+		 * @returns the index, npos if the function is neither defined nor called in the module.
+		 */
+		[[nodiscard]] function_index find(const ir::ast::expression::function_signature* signature) const
+		{
+			const auto it = functions_.find(signature);
+			return it != functions_.cend() ? it->second : npos;
+		}
+
+		/**
+		 * Returns whether a function calls another, in constant time.
+		 */
+		[[nodiscard]] bool calls(const function_index caller, const function_index callee) const
+		{
+			return edges_.count(std::uint64_t{ caller } << 32 | callee) != 0;
+		}
+
+		/**
+		 * Returns whether a function can call itself, directly or through others.
+		 */
+		[[nodiscard]] bool is_recursive(function_index function) const;
+
+		[[nodiscard]] std::size_t size() const { return signatures_.size(); }
+		[[nodiscard]] ir::ast::expression::function_signature* signature(const function_index function) const { return signatures_[function]; }
+		[[nodiscard]] ir::ast::statement::function_definition* definition(const function_index function) const { return definitions_[function]; }
+
+		[[nodiscard]] function_range callees(const function_index function) const
+		{
+			return { callees_.data() + callee_offsets_[function], callees_.data() + callee_offsets_[function + 1] };
+		}
+
+		[[nodiscard]] function_range callers(const function_index function) const
+		{
+			return { callers_.data() + caller_offsets_[function], callers_.data() + caller_offsets_[function + 1] };
+		}
+
+		[[nodiscard]] std::size_t component_count() const { return component_offsets_.empty() ? 0 : component_offsets_.size() - 1; }
+		[[nodiscard]] std::uint32_t component(const function_index function) const { return components_[function]; }
+
+		/**
+		 * Returns the functions of a component, components are numbered bottom-up.
+		 */
+		[[nodiscard]] function_range component_functions(const std::uint32_t component) const
+		{
+			return { bottom_up_.data() + component_offsets_[component], bottom_up_.data() + component_offsets_[component + 1] };
+		}
+
+		/**
+		 * Returns every function, callees before their callers unless they call each other.
+		 */
+		[[nodiscard]] const std::vector<function_index>& bottom_up() const { return bottom_up_; }
+
+		/**
+		 * Returns every function, callers before their callees unless they call each other.
+		 */
+		[[nodiscard]] const std::vector<function_index>& top_down() const { return top_down_; }
+	};
+}
@@ -0,0 +1,324 @@
+#include "constant_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace seam::types
+{
+	namespace
+	{
+		using built_in_type = ir::ast::type::built_in_type;
+
+		constexpr std::size_t max_digits = 128; // longer literals (underscores aside) are rejected.
+
+		/**
+		 * Looks up the built-in type a literal suffix names.
+		 *
+		 * @param suffix suffix of the literal.
+		 * @param type set to the type.
+		 * @returns whether the suffix names a numeric type.
+		 */
+		bool lookup_suffix(const std::string_view suffix, built_in_type& type)
+		{
+			static constexpr std::pair<std::string_view, built_in_type> suffixes[] = {
+				{ "i8", built_in_type::i8 }, { "i16", built_in_type::i16 }, { "i32", built_in_type::i32 }, { "i64", built_in_type::i64 },
+				{ "u8", built_in_type::u8 }, { "u16", built_in_type::u16 }, { "u32", built_in_type::u32 }, { "u64", built_in_type::u64 },
+				{ "f32", built_in_type::f32 }, { "f64", built_in_type::f64 },
+			};
+
+			for (const auto& [spelling, built_in] : suffixes)
+			{
+				if (spelling == suffix)
+				{
+					type = built_in;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/**
+		 * Returns the suffix naming a numeric built-in type.
+		 */
+		std::string_view suffix_of(const built_in_type type)
+		{
+			switch (type)
+			{
+				case built_in_type::i8: return "i8";
+				case built_in_type::i16: return "i16";
+				case built_in_type::i32: return "i32";
+				case built_in_type::i64: return "i64";
+				case built_in_type::u8: return "u8";
+				case built_in_type::u16: return "u16";
+				case built_in_type::u32: return "u32";
+				case built_in_type::u64: return "u64";
+				case built_in_type::f32: return "f32";
+				case built_in_type::f64: return "f64";
+				default: throw std::invalid_argument{ "number literals have a numeric type" };
+			}
+		}
+
+		/**
+		 * Returns the largest value an integer literal of a type may have.
+		 */
+		std::uint64_t max_integer(const built_in_type type)
+		{
+			switch (type)
+			{
+				case built_in_type::i8: return std::numeric_limits<std::int8_t>::max();
+				case built_in_type::i16: return std::numeric_limits<std::int16_t>::max();
+				case built_in_type::i32: return std::numeric_limits<std::int32_t>::max();
+				case built_in_type::i64: return std::numeric_limits<std::int64_t>::max();
+				case built_in_type::u8: return std::numeric_limits<std::uint8_t>::max();
+				case built_in_type::u16: return std::numeric_limits<std::uint16_t>::max();
+				case built_in_type::u32: return std::numeric_limits<std::uint32_t>::max();
+				default: return std::numeric_limits<std::uint64_t>::max();
+			}
+		}
+
+		[[noreturn]] void malformed(const std::string_view spelling, const char* reason)
+		{
+			throw std::invalid_argument{ std::string{ reason } + " in number literal '" + std::string{ spelling } + "'" };
+		}
+
+		/**
+		 * Decodes a number literal without allocating: the digits are copied to a
+		 * stack buffer without their separators and converted with std::from_chars.
+		 *
+		 * @param spelling spelling of the literal.
+		 * @param types context the suffix type is taken from.
+		 * @returns the decoded literal, spelling left empty.
+		 */
+		ir::ast::expression::number_constant decode(const std::string_view spelling, type_context& types)
+		{
+			auto base = 10;
+			std::size_t offset = 0;
+			if (spelling.size() > 1 && spelling[0] == '0' && (spelling[1] == 'x' || spelling[1] == 'b'))
+			{
+				base = spelling[1] == 'x' ? 16 : 2;
+				offset = 2;
+			}
+
+			const auto is_digit = [base](const char c)
+			{
+				switch (base)
+				{
+					case 16: return std::isxdigit(static_cast<unsigned char>(c)) != 0;
+					case 2: return c == '0' || c == '1';
+					default: return c >= '0' && c <= '9';
+				}
+			};
+
+			std::array<char, max_digits> digits;
+			std::size_t digit_count = 0;
+			auto digits_seen = false;
+			auto is_float = false;
+
+			const auto append = [&](const char c)
+			{
+				if (digit_count == digits.size())
+				{
+					malformed(spelling, "too many digits");
+				}
+				digits[digit_count++] = c;
+			};
+
+			for (; offset < spelling.size(); ++offset)
+			{
+				const auto c = spelling[offset];
+				if (is_digit(c))
+				{
+					append(c);
+					digits_seen = true;
+				}
+				else if (c == '_')
+				{
+					continue;
+				}
+				else if (c == '.' && base == 10 && !is_float)
+				{
+					append(c);
+					is_float = true;
+				}
+				else if ((c == 'e' || c == 'E') && base == 10 && digits_seen)
+				{
+					// An exponent needs digits, otherwise the e starts a (bad) suffix.
+					auto exponent = offset + 1;
+					if (exponent < spelling.size() && (spelling[exponent] == '+' || spelling[exponent] == '-'))
+					{
+						++exponent;
+					}
+					if (exponent == spelling.size() || !is_digit(spelling[exponent]))
+					{
+						break;
+					}
+
+					append('e');
+					if (exponent != offset + 1)
+					{
+						append(spelling[offset + 1]);
+					}
+					for (offset = exponent; offset < spelling.size() && (is_digit(spelling[offset]) || spelling[offset] == '_'); ++offset)
+					{
+						if (spelling[offset] != '_')
+						{
+							append(spelling[offset]);
+						}
+					}
+					is_float = true;
+					break;
+				}
+				else
+				{
+					break;
+				}
+			}
+
+			if (!digits_seen)
+			{
+				malformed(spelling, "missing digits");
+			}
+
+			ir::ast::expression::number_constant constant{ {}, {}, nullptr };
+
+			const auto suffix = spelling.substr(offset);
+			auto type = is_float ? built_in_type::f64 : built_in_type::u64;
+			if (!suffix.empty())
+			{
+				if (!lookup_suffix(suffix, type))
+				{
+					malformed(spelling, "unknown suffix");
+				}
+				constant.suffix_type = types.built_in(type);
+			}
+
+			const auto float_type = type == built_in_type::f32 || type == built_in_type::f64;
+			if (is_float && !float_type)
+			{
+				malformed(spelling, "integer suffix on floating point value");
+			}
+			if (float_type && base != 10)
+			{
+				malformed(spelling, "floating point suffix on non-decimal value");
+			}
+
+			const auto first = digits.data();
+			const auto last = digits.data() + digit_count;
+			if (float_type)
+			{
+				double value;
+				const auto [end, error] = std::from_chars(first, last, value);
+				if (error == std::errc::result_out_of_range ||
+					(type == built_in_type::f32 && std::isinf(static_cast<float>(value))))
+				{
+					malformed(spelling, "value out of range");
+				}
+				if (error != std::errc{} || end != last)
+				{
+					malformed(spelling, "bad digits");
+				}
+				constant.value = value;
+			}
+			else
+			{
+				std::uint64_t value;
+				const auto [end, error] = std::from_chars(first, last, value, base);
+				if (error == std::errc::result_out_of_range || (error == std::errc{} && value > max_integer(type)))
+				{
+					malformed(spelling, "value out of range");
+				}
+				if (error != std::errc{} || end != last)
+				{
+					malformed(spelling, "bad digits");
+				}
+				constant.value = value;
+			}
+			return constant;
+		}
+	}
+
+	bool fits(const ir::ast::expression::number_constant& constant, const ir::ast::type* type, const bool negated)
+	{
+		const auto built_in = std::get_if<built_in_type>(&type->value);
+		if (!built_in || *built_in < built_in_type::i8 || *built_in > built_in_type::f64)
+		{
+			return false;
+		}
+
+		if (*built_in == built_in_type::f32 || *built_in == built_in_type::f64)
+		{
+			return true;
+		}
+		const auto integer = std::get_if<std::uint64_t>(&constant.value);
+		if (!integer)
+		{
+			return false;
+		}
+
+		const auto is_signed = *built_in >= built_in_type::i8 && *built_in <= built_in_type::i64;
+		return *integer <= max_integer(*built_in) || (negated && is_signed && *integer - 1 == max_integer(*built_in));
+	}
+
+	const ir::ast::expression::number_constant* constant_pool::number(const std::string_view spelling)
+	{
+		{
+			std::shared_lock lock{ mutex_ };
+			if (const auto it = numbers_.find(spelling); it != numbers_.cend())
+			{
+				return it->second;
+			}
+		}
+
+		// Decode outside the lock, malformed literals throw before anything is stored.
+		auto decoded = decode(spelling, types_);
+
+		// Another thread may have decoded the literal meanwhile, keep the first.
+		std::unique_lock lock{ mutex_ };
+		if (const auto it = numbers_.find(spelling); it != numbers_.cend())
+		{
+			return it->second;
+		}
+
+		const auto copy = static_cast<char*>(storage_.allocate(spelling.size(), 1));
+		std::memcpy(copy, spelling.data(), spelling.size());
+		decoded.spelling = { copy, spelling.size() };
+
+		const auto constant = storage_.make<ir::ast::expression::number_constant>(decoded);
+		numbers_.emplace(constant->spelling, constant);
+		return constant;
+	}
+
+	const ir::ast::expression::number_constant* constant_pool::number(const std::variant<std::uint64_t, double>& value, const built_in_type type)
+	{
+		const auto suffix = suffix_of(type);
+
+		// The shortest spelling decoding to the value, which never needs more than a few dozen characters.
+		std::array<char, 64> spelling;
+		std::to_chars_result result;
+		if (const auto floating = std::get_if<double>(&value))
+		{
+			if (!std::isfinite(*floating) || std::signbit(*floating))
+			{
+				throw std::invalid_argument{ "value out of range in folded number literal" };
+			}
+			result = std::to_chars(spelling.data(), spelling.data() + spelling.size() - suffix.size(), *floating);
+		}
+		else
+		{
+			result = std::to_chars(spelling.data(), spelling.data() + spelling.size() - suffix.size(), std::get<std::uint64_t>(value));
+		}
+
+		const auto end = std::copy(suffix.cbegin(), suffix.cend(), result.ptr);
+		return number(std::string_view{ spelling.data(), static_cast<std::size_t>(end - spelling.data()) });
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "../ir/ast/expression.hpp"
+#include "../utils/arena.hpp"
+#include "type_context.hpp"
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+
+namespace seam::types
+{
+	/**
+	 * Holds the constants of a module, decoding every distinct literal spelling
+	 * exactly once, so identical literals share their constant.
+	 */
+	class constant_pool
+	{
+		type_context& types_; // types named by literal suffixes.
+		std::shared_mutex mutex_; // guards numbers_, shared for lookups.
+		utils::arena storage_; // every constant and its spelling, stable for the lifetime of the pool.
+		std::unordered_map<std::string_view, const ir::ast::expression::number_constant*> numbers_; // by spelling.
+	public:
+		explicit constant_pool(type_context& types) :
+			types_(types)
+		{}
+
+		constant_pool(const constant_pool&) = delete;
+		constant_pool& operator=(const constant_pool&) = delete;
+
+		/**
+		 * Returns the constant of a number literal, decoding it on first use.
+		 * Safe to call from several threads at once.
+		 *
+		 * Literals are decimal, hexadecimal (0x) or binary (0b) integers, or decimal
+		 * floating point numbers with a fraction and/or an exponent. Digits may be
+		 * separated by underscores, and a suffix (10u8, 1.5f32) gives the literal
+		 * a built-in type.
+		 *
+		 * @param spelling spelling of the literal, as lexed.
+		 * @returns the constant, the same for every call with the same spelling.
+		 * @throws std::invalid_argument if the literal is malformed or out of range of its type.
+		 */
+		const ir::ast::expression::number_constant* number(std::string_view spelling);
+
+		/**
+		 * Returns the constant of a number literal spelled with a value and a suffix
+		 * (8i32, 0.5f64), for literals made by passes rather than lexed.
+		 *
+		 * @param value value of the literal, negative values are negations of literals.
+		 * @param type numeric built-in type of the literal.
+		 * @returns the constant, the same as number returns for the spelling.
+		 * @throws std::invalid_argument if the value is not finite or does not fit the type.
+		 */
+		const ir::ast::expression::number_constant* number(const std::variant<std::uint64_t, double>& value, ir::ast::type::built_in_type type);
+	};
+
+	/**
+	 * Returns whether a number constant can be a value of a type, integers fit
+	 * integer types up to their largest value and every floating point type.
+	 *
+	 * @param constant constant of a number literal.
+	 * @param type type the literal is used as.
+	 * @param negated whether the literal is negated, signed integer types then fit one
+	 * more so their smallest value can be spelled (-2147483648 as an i32).
+	 */
+	bool fits(const ir::ast::expression::number_constant& constant, const ir::ast::type* type, bool negated = false);
+}
@@ -1,10 +1,16 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 
 #include "../ir/ast/statement.hpp"
+#include "../utils/arena.hpp"
+#include "../utils/interner.hpp"
+#include "call_graph.hpp"
+#include "constant_pool.hpp"
+#include "type_context.hpp"
 
 namespace seam::types
 {
@@ -13,7 +19,14 @@ namespace seam::types
 		std::string name;
 		std::vector<std::shared_ptr<module>> dependencies;
 
-		std::unique_ptr<ir::ast::statement::restricted_block> body;
+		utils::arena arena; // owns every ast node of the module.
+		utils::interner interner; // names used by the module.
+		type_context types; // types used by the module.
+		constant_pool constants{ types }; // constants of the literals of the module.
+		ir::ast::statement::restricted_block* body = nullptr;
+		std::unordered_map<utils::symbol_id, ir::ast::expression::function_signature*> functions; // functions of the module by name, filled by the passes.
+		call_graph calls; // functions of the module and the functions they call, built by the passes.
+		std::size_t parsed_bytes = 0; // arena bytes in use once the module was last parsed (or read) as a whole, see parser::reparse.
 
 		module(std::string name) :
 			name(std::move(name))
@@ -0,0 +1,1080 @@
+#include "module_cache.hpp"
+
+#include "../ir/ast/flat_expressions.hpp"
+#include "../utils/source_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Layout of a module cache, every integer in the byte order of the machine that
+// wrote it, every reference an index into one of the tables:
+//
+// header      magic, version, byte order mark, source hash, module name
+// symbols     spellings of the interner, in id order
+// types       built-in types, and optional types referring to their value type
+// variables   name and type of every variable
+// signatures  function signatures, referred to by definitions and resolved calls
+// functions   module::functions, as name and signature
+// body        statements in pre-order, their expressions in post-order, laid out as
+//             ir::ast::flat_expressions stores them
+
+namespace seam::types
+{
+	namespace
+	{
+		constexpr char magic[8] = { 'S', 'E', 'A', 'M', 'A', 'S', 'T', '\0' };
+		constexpr std::uint32_t byte_order_mark = 0x01020304; // reads differently on a machine of the other byte order.
+
+		enum class type_tag : std::uint8_t
+		{
+			built_in,
+			optional,
+		};
+
+		template <typename T>
+		void put(std::string& out, const T value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			const auto offset = out.size();
+			out.resize(offset + sizeof(T));
+			std::memcpy(&out[offset], &value, sizeof(T));
+		}
+
+		std::uint32_t checked_size(const std::size_t size)
+		{
+			if (size > std::numeric_limits<std::uint32_t>::max())
+			{
+				throw std::length_error{ "module too large to cache" };
+			}
+			return static_cast<std::uint32_t>(size);
+		}
+
+		void put_string(std::string& out, const std::string_view value)
+		{
+			put(out, checked_size(value.size()));
+			out.append(value);
+		}
+
+		/**
+		 * Serializes a module, indices are handed out to types, variables and
+		 * signatures as the nodes referring to them are written.
+		 */
+		class writer
+		{
+			const module& module_;
+
+			std::string nodes_;
+			std::vector<std::pair<ir::ast::expression::expression*, bool>> stack_; // expressions being written, and whether their children are queued.
+
+			// Sizes of the flat encoding of the function body being written, for the reader to reserve.
+			std::uint32_t body_expressions_ = 0;
+			std::uint32_t body_arguments_ = 0;
+			std::uint32_t body_roots_ = 0;
+
+			std::vector<ir::ast::type*> types_;
+			std::unordered_map<ir::ast::type*, std::uint32_t> type_indices_; // 0 is no type, the first type is 1.
+			std::vector<ir::ast::expression::variable*> variables_;
+			std::unordered_map<ir::ast::expression::variable*, std::uint32_t> variable_indices_;
+			std::vector<ir::ast::expression::function_signature*> signatures_;
+			std::unordered_map<ir::ast::expression::function_signature*, std::uint32_t> signature_indices_;
+
+			std::uint32_t index_of(ir::ast::type* type)
+			{
+				if (!type)
+				{
+					return 0;
+				}
+				if (const auto it = type_indices_.find(type); it != type_indices_.cend())
+				{
+					return it->second;
+				}
+
+				// Value types come first, so the reader creates types in order.
+				if (const auto optional = std::get_if<ir::ast::optional_descriptor>(&type->value))
+				{
+					index_of(optional->value_type);
+				}
+				else if (!std::holds_alternative<ir::ast::type::built_in_type>(type->value))
+				{
+					throw std::invalid_argument{ "class types cannot be cached" };
+				}
+
+				types_.push_back(type);
+				const auto index = checked_size(types_.size());
+				type_indices_.emplace(type, index);
+				return index;
+			}
+
+			std::uint32_t index_of(ir::ast::expression::variable* variable)
+			{
+				const auto [it, inserted] = variable_indices_.emplace(variable, checked_size(variables_.size()));
+				if (inserted)
+				{
+					variables_.push_back(variable);
+				}
+				return it->second;
+			}
+
+			std::uint32_t index_of(ir::ast::expression::function_signature* signature)
+			{
+				const auto [it, inserted] = signature_indices_.emplace(signature, checked_size(signatures_.size()));
+				if (inserted)
+				{
+					signatures_.push_back(signature);
+				}
+				return it->second;
+			}
+
+			void write_expression_node(ir::ast::expression::expression* node)
+			{
+				put(nodes_, node->kind);
+				put(nodes_, node->range);
+				put(nodes_, index_of(node->eval_type));
+
+				switch (node->kind)
+				{
+					case ir::ast::node_kind::unary:
+					{
+						put(nodes_, static_cast<std::uint32_t>(static_cast<ir::ast::expression::unary*>(node)->operation));
+						break;
+					}
+					case ir::ast::node_kind::binary:
+					{
+						put(nodes_, static_cast<std::uint32_t>(static_cast<ir::ast::expression::binary*>(node)->operation));
+						break;
+					}
+					case ir::ast::node_kind::variable_ref:
+					{
+						put(nodes_, index_of(static_cast<ir::ast::expression::variable_ref*>(node)->var));
+						break;
+					}
+					case ir::ast::node_kind::call:
+					{
+						put(nodes_, checked_size(static_cast<ir::ast::expression::call*>(node)->arguments.size()));
+						break;
+					}
+					case ir::ast::node_kind::symbol_wrapper:
+					{
+						const auto symbol = static_cast<ir::ast::expression::resolved_symbol*>(static_cast<ir::ast::expression::symbol_wrapper*>(node)->value);
+						put(nodes_, index_of(symbol->signature));
+						break;
+					}
+					case ir::ast::node_kind::bool_literal:
+					{
+						put(nodes_, static_cast<std::uint8_t>(static_cast<ir::ast::expression::bool_literal*>(node)->value));
+						break;
+					}
+					case ir::ast::node_kind::string_literal:
+					{
+						put_string(nodes_, static_cast<ir::ast::expression::string_literal*>(node)->value);
+						break;
+					}
+					case ir::ast::node_kind::number_literal:
+					{
+						put_string(nodes_, static_cast<ir::ast::expression::number_literal*>(node)->constant->spelling);
+						break;
+					}
+					default:
+					{
+						throw std::logic_error{ "unexpected node in expression" };
+					}
+				}
+			}
+
+			// Writes an expression in post-order, without recursing into the expression
+			// tree, which can be as deep as it is long.
+			void write_expression(ir::ast::expression::expression* root)
+			{
+				const auto count_offset = nodes_.size();
+				put(nodes_, std::uint32_t{ 0 });
+
+				std::uint32_t count = 0;
+				stack_.emplace_back(root, false);
+				while (!stack_.empty())
+				{
+					const auto [node, queued] = stack_.back();
+					if (queued)
+					{
+						stack_.pop_back();
+						write_expression_node(node);
+						++count;
+						++body_expressions_;
+						continue;
+					}
+
+					// Children are pushed last to first, so they are written first to last.
+					stack_.back().second = true;
+					switch (node->kind)
+					{
+						case ir::ast::node_kind::unary:
+						{
+							stack_.emplace_back(static_cast<ir::ast::expression::unary*>(node)->right, false);
+							break;
+						}
+						case ir::ast::node_kind::binary:
+						{
+							const auto binary = static_cast<ir::ast::expression::binary*>(node);
+							stack_.emplace_back(binary->right, false);
+							stack_.emplace_back(binary->left, false);
+							break;
+						}
+						case ir::ast::node_kind::call:
+						{
+							const auto call = static_cast<ir::ast::expression::call*>(node);
+							body_arguments_ += checked_size(call->arguments.size() + 1); // the count, then the arguments.
+							for (auto it = call->arguments.crbegin(); it != call->arguments.crend(); ++it)
+							{
+								stack_.emplace_back(*it, false);
+							}
+							stack_.emplace_back(call->function, false);
+							break;
+						}
+						default:
+						{
+							break;
+						}
+					}
+				}
+
+				std::memcpy(&nodes_[count_offset], &count, sizeof(count));
+				++body_roots_;
+			}
+
+			void write_statement(ir::ast::statement::statement* node)
+			{
+				put(nodes_, node->kind);
+				put(nodes_, node->range);
+
+				switch (node->kind)
+				{
+					case ir::ast::node_kind::normal_block:
+					{
+						const auto& body = static_cast<ir::ast::statement::normal_block*>(node)->body;
+						put(nodes_, checked_size(body.size()));
+						for (const auto statement : body)
+						{
+							write_statement(statement);
+						}
+						break;
+					}
+					case ir::ast::node_kind::restricted_block:
+					{
+						const auto& body = static_cast<ir::ast::statement::restricted_block*>(node)->body;
+						put(nodes_, checked_size(body.size()));
+						for (const auto statement : body)
+						{
+							write_statement(statement);
+						}
+						break;
+					}
+					case ir::ast::node_kind::expression_:
+					{
+						write_expression(static_cast<ir::ast::statement::expression_*>(node)->value);
+						break;
+					}
+					case ir::ast::node_kind::ret:
+					{
+						const auto value = static_cast<ir::ast::statement::ret*>(node)->value;
+						put(nodes_, static_cast<std::uint8_t>(value != nullptr));
+						if (value)
+						{
+							write_expression(value);
+						}
+						break;
+					}
+					case ir::ast::node_kind::assignment:
+					{
+						const auto assignment = static_cast<ir::ast::statement::assignment*>(node);
+						write_expression(assignment->from);
+						write_expression(assignment->to);
+						break;
+					}
+					case ir::ast::node_kind::if_stat:
+					{
+						const auto if_stat = static_cast<ir::ast::statement::if_stat*>(node);
+						write_expression(if_stat->condition);
+						write_statement(if_stat->main_body);
+						put(nodes_, static_cast<std::uint8_t>(if_stat->else_body != nullptr));
+						if (if_stat->else_body)
+						{
+							write_statement(if_stat->else_body);
+						}
+						break;
+					}
+					case ir::ast::node_kind::numerical_for_loop:
+					{
+						const auto loop = static_cast<ir::ast::statement::numerical_for_loop*>(node);
+						write_expression(loop->initial);
+						write_expression(loop->final);
+						write_expression(loop->step);
+						write_statement(loop->body);
+						break;
+					}
+					case ir::ast::node_kind::while_loop:
+					{
+						const auto loop = static_cast<ir::ast::statement::while_loop*>(node);
+						write_expression(loop->condition);
+						write_statement(loop->body);
+						break;
+					}
+					case ir::ast::node_kind::function_definition:
+					{
+						const auto definition = static_cast<ir::ast::statement::function_definition*>(node);
+						put(nodes_, index_of(definition->signature));
+						put(nodes_, static_cast<std::uint8_t>(definition->body != nullptr));
+						if (definition->body)
+						{
+							const auto sizes_offset = nodes_.size();
+							nodes_.append(3 * sizeof(std::uint32_t), '\0');
+
+							body_expressions_ = body_arguments_ = body_roots_ = 0;
+							write_statement(definition->body);
+
+							const std::uint32_t sizes[] = { body_expressions_, body_arguments_, body_roots_ };
+							std::memcpy(&nodes_[sizes_offset], sizes, sizeof(sizes));
+						}
+
+						// Sorted, so caches of the same module are identical.
+						std::vector<std::uint32_t> dependencies;
+						for (const auto dependency : definition->function_dependencies)
+						{
+							dependencies.push_back(index_of(dependency));
+						}
+						std::sort(dependencies.begin(), dependencies.end());
+
+						put(nodes_, checked_size(dependencies.size()));
+						for (const auto dependency : dependencies)
+						{
+							put(nodes_, dependency);
+						}
+						break;
+					}
+					case ir::ast::node_kind::extern_function_definition:
+					{
+						put(nodes_, index_of(static_cast<ir::ast::statement::extern_function_definition*>(node)->signature));
+						break;
+					}
+					case ir::ast::node_kind::alias_type_definition:
+					{
+						const auto alias = static_cast<ir::ast::statement::alias_type_definition*>(node);
+						put(nodes_, alias->name);
+						put(nodes_, index_of(alias->target_type));
+						break;
+					}
+					case ir::ast::node_kind::class_type_definition:
+					{
+						const auto definition = static_cast<ir::ast::statement::class_type_definition*>(node);
+						put(nodes_, definition->name);
+						put(nodes_, checked_size(definition->fields.size()));
+						for (const auto field : definition->fields)
+						{
+							put(nodes_, field->range);
+							put(nodes_, index_of(field->var));
+						}
+						write_statement(definition->body);
+						break;
+					}
+					default:
+					{
+						throw std::logic_error{ "unexpected node in statement" };
+					}
+				}
+			}
+		public:
+			explicit writer(const module& module) :
+				module_(module)
+			{}
+
+			/**
+			 * Serializes the module.
+			 *
+			 * @param source_hash hash of the source of the module.
+			 * @returns contents of the cache file.
+			 */
+			std::string write(const std::uint64_t source_hash)
+			{
+				put(nodes_, static_cast<std::uint8_t>(module_.body != nullptr));
+				if (module_.body)
+				{
+					write_statement(module_.body);
+				}
+
+				std::vector<std::pair<utils::symbol_id, ir::ast::expression::function_signature*>> functions{ module_.functions.cbegin(), module_.functions.cend() };
+				std::sort(functions.begin(), functions.end());
+
+				std::string functions_out;
+				put(functions_out, checked_size(functions.size()));
+				for (const auto& [name, signature] : functions)
+				{
+					put(functions_out, name);
+					put(functions_out, index_of(signature));
+				}
+
+				// Signatures add variables and types, variables add types.
+				std::string signatures_out;
+				put(signatures_out, checked_size(signatures_.size()));
+				for (const auto signature : signatures_)
+				{
+					put(signatures_out, signature->name);
+					put(signatures_out, index_of(signature->return_type));
+					put(signatures_out, signature->range);
+					put(signatures_out, static_cast<std::uint8_t>(signature->is_extern));
+					put(signatures_out, checked_size(signature->parameters.size()));
+					for (const auto parameter : signature->parameters)
+					{
+						put(signatures_out, parameter->range);
+						put(signatures_out, index_of(parameter->var));
+					}
+
+					std::vector<std::string_view> attributes{ signature->attributes.cbegin(), signature->attributes.cend() };
+					std::sort(attributes.begin(), attributes.end());
+					put(signatures_out, checked_size(attributes.size()));
+					for (const auto attribute : attributes)
+					{
+						put_string(signatures_out, attribute);
+					}
+				}
+
+				std::string variables_out;
+				put(variables_out, checked_size(variables_.size()));
+				for (const auto variable : variables_)
+				{
+					put(variables_out, variable->name);
+					put(variables_out, index_of(variable->type_));
+				}
+
+				std::string out{ magic, sizeof(magic) };
+				put(out, module_cache_version);
+				put(out, byte_order_mark);
+				put(out, source_hash);
+				put_string(out, module_.name);
+
+				put(out, checked_size(module_.interner.size()));
+				for (std::size_t id = 0; id < module_.interner.size(); ++id)
+				{
+					put_string(out, module_.interner.spelling(static_cast<utils::symbol_id>(id)));
+				}
+
+				put(out, checked_size(types_.size()));
+				for (const auto type : types_)
+				{
+					if (const auto optional = std::get_if<ir::ast::optional_descriptor>(&type->value))
+					{
+						put(out, type_tag::optional);
+						put(out, index_of(optional->value_type));
+					}
+					else
+					{
+						put(out, type_tag::built_in);
+						put(out, static_cast<std::uint32_t>(std::get<ir::ast::type::built_in_type>(type->value)));
+					}
+				}
+
+				out.append(variables_out);
+				out.append(signatures_out);
+				out.append(functions_out);
+				out.append(nodes_);
+				return out;
+			}
+		};
+
+		/**
+		 * Rebuilds a module from the contents of a cache file, checking every size
+		 * and index against the tables read so far.
+		 */
+		class reader
+		{
+			std::string_view data_;
+			std::size_t offset_ = 0;
+			module& module_;
+
+			std::vector<ir::ast::type*> types_;
+			std::vector<ir::ast::expression::variable*> variables_;
+			std::vector<ir::ast::expression::function_signature*> signatures_;
+
+			struct operand
+			{
+				ir::ast::expression::expression* node;
+				std::uint32_t index; // index of the expression in flat_.
+			};
+
+			std::vector<operand> operands_; // expressions whose parent is not read yet.
+
+			// Expressions of the function body being read, in the post-order they are
+			// stored in, so the flat encoding comes without flattening the body again.
+			std::vector<ir::ast::flat_expression> flat_;
+			std::vector<std::uint32_t> flat_arguments_;
+			std::vector<std::pair<const ir::ast::expression::expression*, ir::ast::flat_expressions::span>> flat_roots_;
+
+			[[noreturn]] static void malformed()
+			{
+				throw std::runtime_error{ "malformed module cache" };
+			}
+
+			template <typename T>
+			T get()
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				if (data_.size() - offset_ < sizeof(T))
+				{
+					malformed();
+				}
+
+				T value;
+				std::memcpy(&value, data_.data() + offset_, sizeof(T));
+				offset_ += sizeof(T);
+				return value;
+			}
+
+			std::string_view get_string()
+			{
+				const auto size = get<std::uint32_t>();
+				if (data_.size() - offset_ < size)
+				{
+					malformed();
+				}
+
+				const auto value = data_.substr(offset_, size);
+				offset_ += size;
+				return value;
+			}
+
+			template <typename T>
+			T entry(const std::uint32_t index, const std::vector<T>& table)
+			{
+				if (index >= table.size())
+				{
+					malformed();
+				}
+				return table[index];
+			}
+
+			ir::ast::node_kind get_kind()
+			{
+				const auto kind = get<std::uint8_t>();
+				if (kind > static_cast<std::uint8_t>(ir::ast::node_kind::class_type_definition))
+				{
+					malformed();
+				}
+				return static_cast<ir::ast::node_kind>(kind);
+			}
+
+			utils::symbol_id get_symbol()
+			{
+				const auto id = get<utils::symbol_id>();
+				if (static_cast<std::uint32_t>(id) >= module_.interner.size())
+				{
+					malformed();
+				}
+				return id;
+			}
+
+			ir::ast::type* get_type()
+			{
+				const auto index = get<std::uint32_t>();
+				return index == 0 ? nullptr : entry(index - 1, types_);
+			}
+
+			ir::ast::expression::variable* get_variable()
+			{
+				return entry(get<std::uint32_t>(), variables_);
+			}
+
+			ir::ast::expression::function_signature* get_signature()
+			{
+				return entry(get<std::uint32_t>(), signatures_);
+			}
+
+			template <typename T, typename... Args>
+			T* make(Args&&... args)
+			{
+				return module_.arena.make<T>(std::forward<Args>(args)...);
+			}
+
+			operand pop_operand()
+			{
+				if (operands_.empty())
+				{
+					malformed();
+				}
+
+				const auto operand = operands_.back();
+				operands_.pop_back();
+				return operand;
+			}
+
+			ir::ast::expression::expression* read_expression()
+			{
+				const auto first = static_cast<std::uint32_t>(flat_.size());
+				const auto count = get<std::uint32_t>();
+				for (std::uint32_t index = 0; index < count; ++index)
+				{
+					const auto kind = get_kind();
+					const auto range = get<utils::position_range>();
+					const auto eval_type = get_type();
+
+					ir::ast::expression::expression* node;
+					ir::ast::flat_expression flat{ nullptr, 0, static_cast<std::uint32_t>(kind), 0, 0 };
+					switch (kind)
+					{
+						case ir::ast::node_kind::unary:
+						{
+							const auto operation = static_cast<lexer::lexeme_type>(get<std::uint32_t>());
+							const auto right = pop_operand();
+							node = make<ir::ast::expression::unary>(range, right.node, operation);
+							flat.left = right.index;
+							flat.operation_ = static_cast<std::uint32_t>(operation);
+							break;
+						}
+						case ir::ast::node_kind::binary:
+						{
+							const auto operation = static_cast<lexer::lexeme_type>(get<std::uint32_t>());
+							const auto right = pop_operand();
+							const auto left = pop_operand();
+							node = make<ir::ast::expression::binary>(range, left.node, right.node, operation);
+							flat.left = left.index;
+							flat.right = right.index;
+							flat.operation_ = static_cast<std::uint32_t>(operation);
+							break;
+						}
+						case ir::ast::node_kind::variable_ref:
+						{
+							node = make<ir::ast::expression::variable_ref>(range, get_variable());
+							break;
+						}
+						case ir::ast::node_kind::call:
+						{
+							const auto argument_count = get<std::uint32_t>();
+							if (argument_count >= operands_.size() || flat_arguments_.size() > ir::ast::flat_expression::max_index)
+							{
+								malformed();
+							}
+
+							const auto first_argument = operands_.cend() - argument_count;
+							ir::ast::expression::expression_list arguments;
+							arguments.reserve(argument_count);
+							flat.right = static_cast<std::uint32_t>(flat_arguments_.size());
+							flat_arguments_.push_back(argument_count);
+							for (auto it = first_argument; it != operands_.cend(); ++it)
+							{
+								arguments.push_back(it->node);
+								flat_arguments_.push_back(it->index);
+							}
+							operands_.erase(first_argument, operands_.cend());
+
+							const auto function = pop_operand();
+							node = make<ir::ast::expression::call>(range, function.node, std::move(arguments));
+							flat.left = function.index;
+							break;
+						}
+						case ir::ast::node_kind::symbol_wrapper:
+						{
+							node = make<ir::ast::expression::symbol_wrapper>(range, make<ir::ast::expression::resolved_symbol>(get_signature()));
+							break;
+						}
+						case ir::ast::node_kind::bool_literal:
+						{
+							node = make<ir::ast::expression::bool_literal>(range, get<std::uint8_t>() != 0);
+							break;
+						}
+						case ir::ast::node_kind::string_literal:
+						{
+							node = make<ir::ast::expression::string_literal>(range, std::string{ get_string() });
+							break;
+						}
+						case ir::ast::node_kind::number_literal:
+						{
+							const ir::ast::expression::number_constant* constant = nullptr;
+							try
+							{
+								constant = module_.constants.number(get_string());
+							}
+							catch (const std::invalid_argument&)
+							{
+								malformed();
+							}
+							node = make<ir::ast::expression::number_literal>(range, constant);
+							break;
+						}
+						default:
+						{
+							malformed();
+						}
+					}
+
+					if (flat_.size() > ir::ast::flat_expression::max_index)
+					{
+						malformed();
+					}
+
+					node->eval_type = eval_type;
+					flat.node = node;
+					operands_.push_back({ node, static_cast<std::uint32_t>(flat_.size()) });
+					flat_.push_back(flat);
+				}
+
+				if (operands_.size() != 1)
+				{
+					malformed();
+				}
+
+				const auto root = pop_operand().node;
+				flat_roots_.emplace_back(root, ir::ast::flat_expressions::span{ first, static_cast<std::uint32_t>(flat_.size() - 1) });
+				return root;
+			}
+
+			void reserve_flat_body()
+			{
+				constexpr auto min_expression_size = sizeof(ir::ast::node_kind) + sizeof(utils::position_range) + sizeof(std::uint32_t);
+
+				const auto expression_count = get<std::uint32_t>();
+				const auto argument_count = get<std::uint32_t>();
+				const auto root_count = get<std::uint32_t>();
+				if ((data_.size() - offset_) / min_expression_size < expression_count || argument_count > expression_count || root_count > expression_count)
+				{
+					malformed();
+				}
+
+				flat_.clear();
+				flat_arguments_.clear();
+				flat_roots_.clear();
+				flat_.reserve(expression_count);
+				flat_arguments_.reserve(argument_count);
+				flat_roots_.reserve(root_count);
+			}
+
+			template <typename T>
+			T* read_statement_as()
+			{
+				if (const auto statement = read_statement()->as<T>())
+				{
+					return statement;
+				}
+				malformed();
+			}
+
+			ir::ast::statement::statement* read_statement()
+			{
+				const auto kind = get_kind();
+				const auto range = get<utils::position_range>();
+
+				switch (kind)
+				{
+					case ir::ast::node_kind::normal_block:
+					{
+						const auto block = make<ir::ast::statement::normal_block>(range);
+						const auto count = get<std::uint32_t>();
+						for (std::uint32_t index = 0; index < count; ++index)
+						{
+							block->body.push_back(read_statement());
+						}
+						return block;
+					}
+					case ir::ast::node_kind::restricted_block:
+					{
+						const auto block = make<ir::ast::statement::restricted_block>(range);
+						const auto count = get<std::uint32_t>();
+						for (std::uint32_t index = 0; index < count; ++index)
+						{
+							block->body.push_back(read_statement_as<ir::ast::statement::restricted>());
+						}
+						return block;
+					}
+					case ir::ast::node_kind::expression_:
+					{
+						return make<ir::ast::statement::expression_>(range, read_expression());
+					}
+					case ir::ast::node_kind::ret:
+					{
+						return make<ir::ast::statement::ret>(range, get<std::uint8_t>() ? read_expression() : nullptr);
+					}
+					case ir::ast::node_kind::assignment:
+					{
+						const auto from = read_expression();
+						const auto to = read_expression();
+						return make<ir::ast::statement::assignment>(range, to, from);
+					}
+					case ir::ast::node_kind::if_stat:
+					{
+						const auto condition = read_expression();
+						const auto main_body = read_statement_as<ir::ast::statement::normal_block>();
+						const auto else_body = get<std::uint8_t>() ? read_statement_as<ir::ast::statement::normal_block>() : nullptr;
+						return make<ir::ast::statement::if_stat>(range, condition, main_body, else_body);
+					}
+					case ir::ast::node_kind::numerical_for_loop:
+					{
+						const auto initial = read_expression()->as<ir::ast::expression::number_literal>();
+						const auto final = read_expression()->as<ir::ast::expression::number_literal>();
+						const auto step = read_expression()->as<ir::ast::expression::number_literal>();
+						if (!initial || !final || !step)
+						{
+							malformed();
+						}
+						return make<ir::ast::statement::numerical_for_loop>(range, initial, final, step,
+							read_statement_as<ir::ast::statement::normal_block>());
+					}
+					case ir::ast::node_kind::while_loop:
+					{
+						const auto condition = read_expression();
+						return make<ir::ast::statement::while_loop>(range, condition, read_statement_as<ir::ast::statement::normal_block>());
+					}
+					case ir::ast::node_kind::function_definition:
+					{
+						const auto signature = get_signature();
+
+						ir::ast::statement::normal_block* body = nullptr;
+						if (get<std::uint8_t>())
+						{
+							reserve_flat_body();
+							body = read_statement_as<ir::ast::statement::normal_block>();
+						}
+						const auto definition = make<ir::ast::statement::function_definition>(range, signature, body);
+
+						const auto count = get<std::uint32_t>();
+						for (std::uint32_t index = 0; index < count; ++index)
+						{
+							definition->function_dependencies.insert(get_signature());
+						}
+
+						if (body)
+						{
+							definition->flat_body = make<ir::ast::flat_expressions>(std::move(flat_), std::move(flat_arguments_), std::move(flat_roots_));
+
+							// Typed as the types pass types them, parameters are not written as expressions.
+							for (const auto parameter : signature->parameters)
+							{
+								parameter->eval_type = parameter->var->type_;
+							}
+						}
+						return definition;
+					}
+					case ir::ast::node_kind::extern_function_definition:
+					{
+						return make<ir::ast::statement::extern_function_definition>(range, get_signature());
+					}
+					case ir::ast::node_kind::alias_type_definition:
+					{
+						const auto name = get_symbol();
+						return make<ir::ast::statement::alias_type_definition>(range, name, get_type());
+					}
+					case ir::ast::node_kind::class_type_definition:
+					{
+						const auto name = get_symbol();
+						ir::ast::expression::parameter_list fields;
+						const auto count = get<std::uint32_t>();
+						for (std::uint32_t index = 0; index < count; ++index)
+						{
+							const auto field_range = get<utils::position_range>();
+							fields.push_back(make<ir::ast::expression::variable_ref>(field_range, get_variable()));
+						}
+						return make<ir::ast::statement::class_type_definition>(range, name, std::move(fields),
+							read_statement_as<ir::ast::statement::restricted_block>());
+					}
+					default:
+					{
+						malformed();
+					}
+				}
+			}
+		public:
+			/**
+			 * @param data contents of the cache file, past the header.
+			 * @param module module to read into, empty but for its name.
+			 */
+			explicit reader(const std::string_view data, module& module) :
+				data_(data), module_(module)
+			{}
+
+			void read()
+			{
+				const auto symbol_count = get<std::uint32_t>();
+				for (std::uint32_t id = 0; id < symbol_count; ++id)
+				{
+					if (static_cast<std::uint32_t>(module_.interner.intern(get_string())) != id)
+					{
+						malformed();
+					}
+				}
+
+				const auto type_count = get<std::uint32_t>();
+				for (std::uint32_t index = 0; index < type_count; ++index)
+				{
+					switch (get<type_tag>())
+					{
+						case type_tag::built_in:
+						{
+							const auto built_in = get<std::uint32_t>();
+							if (built_in > static_cast<std::uint32_t>(ir::ast::type::built_in_type::f64))
+							{
+								malformed();
+							}
+							types_.push_back(module_.types.built_in(static_cast<ir::ast::type::built_in_type>(built_in)));
+							break;
+						}
+						case type_tag::optional:
+						{
+							const auto value_type = get_type();
+							if (!value_type)
+							{
+								malformed();
+							}
+							types_.push_back(module_.types.optional(value_type));
+							break;
+						}
+						default:
+						{
+							malformed();
+						}
+					}
+				}
+
+				const auto variable_count = get<std::uint32_t>();
+				for (std::uint32_t index = 0; index < variable_count; ++index)
+				{
+					const auto name = get_symbol();
+					variables_.push_back(make<ir::ast::expression::variable>(name, get_type()));
+				}
+
+				const auto signature_count = get<std::uint32_t>();
+				for (std::uint32_t index = 0; index < signature_count; ++index)
+				{
+					const auto name = get_symbol();
+					const auto return_type = get_type();
+					const auto range = get<utils::position_range>();
+					const auto is_extern = get<std::uint8_t>() != 0;
+
+					ir::ast::expression::parameter_list parameters;
+					const auto parameter_count = get<std::uint32_t>();
+					for (std::uint32_t parameter = 0; parameter < parameter_count; ++parameter)
+					{
+						const auto parameter_range = get<utils::position_range>();
+						parameters.push_back(make<ir::ast::expression::variable_ref>(parameter_range, get_variable()));
+					}
+
+					ir::ast::expression::attribute_list attributes;
+					const auto attribute_count = get<std::uint32_t>();
+					for (std::uint32_t attribute = 0; attribute < attribute_count; ++attribute)
+					{
+						attributes.emplace(get_string());
+					}
+
+					const auto signature = make<ir::ast::expression::function_signature>(module_.name, name, module_.interner.spelling(name),
+						return_type, std::move(parameters), std::move(attributes));
+					signature->range = range;
+					signature->is_extern = is_extern;
+					signatures_.push_back(signature);
+				}
+
+				const auto function_count = get<std::uint32_t>();
+				for (std::uint32_t index = 0; index < function_count; ++index)
+				{
+					const auto name = get_symbol();
+					module_.functions.emplace(name, get_signature());
+				}
+
+				if (get<std::uint8_t>())
+				{
+					module_.body = read_statement_as<ir::ast::statement::restricted_block>();
+				}
+
+				if (offset_ != data_.size())
+				{
+					malformed();
+				}
+
+				// The graph is rebuilt from the dependencies rather than stored.
+				module_.calls.build(module_.body);
+			}
+		};
+	}
+
+	std::uint64_t hash_source(const std::string_view source)
+	{
+		auto hash = std::uint64_t{ 14695981039346656037u };
+		for (const auto character : source)
+		{
+			hash ^= static_cast<unsigned char>(character);
+			hash *= 1099511628211u;
+		}
+		return hash;
+	}
+
+	void write_module(const module& module, const std::uint64_t source_hash, const std::string& path)
+	{
+		const auto contents = writer{ module }.write(source_hash);
+
+		const auto temporary = path + ".tmp";
+		{
+			std::ofstream out{ temporary, std::ios::binary | std::ios::trunc };
+			out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+			if (!out)
+			{
+				throw std::runtime_error{ "cannot write module cache " + temporary };
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporary, path, error);
+		if (error)
+		{
+			std::filesystem::remove(temporary, error);
+			throw std::runtime_error{ "cannot write module cache " + path };
+		}
+	}
+
+	std::shared_ptr<module> read_module(const std::string& path, const std::uint64_t source_hash)
+	{
+		std::error_code error;
+		if (!std::filesystem::is_regular_file(path, error))
+		{
+			return nullptr;
+		}
+
+		const utils::source_file file{ path };
+		const auto contents = file.contents();
+
+		constexpr auto header_size = sizeof(magic) + sizeof(module_cache_version) + sizeof(byte_order_mark) + sizeof(source_hash);
+		if (contents.size() < header_size || std::memcmp(contents.data(), magic, sizeof(magic)) != 0)
+		{
+			throw std::runtime_error{ path + " is not a module cache" };
+		}
+
+		std::uint32_t version;
+		std::uint32_t order;
+		std::uint64_t hash;
+		std::memcpy(&version, contents.data() + sizeof(magic), sizeof(version));
+		std::memcpy(&order, contents.data() + sizeof(magic) + sizeof(version), sizeof(order));
+		std::memcpy(&hash, contents.data() + sizeof(magic) + sizeof(version) + sizeof(order), sizeof(hash));
+		if (version != module_cache_version || order != byte_order_mark || hash != source_hash)
+		{
+			return nullptr;
+		}
+
+		auto rest = contents.substr(header_size);
+		std::uint32_t name_size;
+		if (rest.size() < sizeof(name_size))
+		{
+			throw std::runtime_error{ "malformed module cache" };
+		}
+		std::memcpy(&name_size, rest.data(), sizeof(name_size));
+		rest.remove_prefix(sizeof(name_size));
+		if (rest.size() < name_size)
+		{
+			throw std::runtime_error{ "malformed module cache" };
+		}
+
+		const auto result = std::make_shared<module>(std::string{ rest.substr(0, name_size) });
+		reader{ rest.substr(name_size), *result }.read();
+		result->parsed_bytes = result->arena.bytes_used();
+		return result;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "module.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace seam::types
+{
+	/**
+	 * Version of the module cache format, caches of other versions are ignored.
+	 */
+	constexpr std::uint32_t module_cache_version = 5;
+
+	/**
+	 * Hashes a source, identifying the source a cached module was parsed from.
+	 *
+	 * @param source source of the module.
+	 * @returns 64-bit FNV-1a hash of the source.
+	 */
+	std::uint64_t hash_source(std::string_view source);
+
+	/**
+	 * Writes a module the passes ran over to a cache file.
+	 *
+	 * The format is position independent: nodes, names, types, variables and the
+	 * signatures calls resolved to refer to each other by index. The file is
+	 * written next to the path and renamed over it, so readers never see a
+	 * partially written cache.
+	 *
+	 * @note bodies skipped by lazy parsing are written as skipped, and can no
+	 * longer be parsed once the module is read back.
+	 * @param module module to write.
+	 * @param source_hash hash of the source of the module, see hash_source.
+	 * @param path path of the cache file.
+	 * @throws std::runtime_error if the file cannot be written.
+	 */
+	void write_module(const module& module, std::uint64_t source_hash, const std::string& path);
+
+	/**
+	 * Reads a module from a cache file, in place of lexing, parsing and
+	 * running the passes over its source.
+	 *
+	 * The file is memory mapped and the nodes are rebuilt in the module arena
+	 * in a single pass over it, resolved calls included.
+	 *
+	 * @param path path of the cache file.
+	 * @param source_hash hash of the current source of the module, see hash_source.
+	 * @returns the module, or nullptr if there is no cache, or it is of another
+	 * version or another source.
+	 * @throws std::runtime_error if the cache is malformed.
+	 */
+	std::shared_ptr<module> read_module(const std::string& path, std::uint64_t source_hash);
+}
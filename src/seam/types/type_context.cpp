@@ -0,0 +1,34 @@
+#include "type_context.hpp"
+
+#include <mutex>
+
+namespace seam::types
+{
+	type_context::type_context()
+	{
+		for (std::size_t index = 0; index < built_in_count; ++index)
+		{
+			built_in_types_[index] = storage_.make<ir::ast::type>(static_cast<ir::ast::type::built_in_type>(index));
+		}
+	}
+
+	ir::ast::type* type_context::optional(ir::ast::type* value_type)
+	{
+		{
+			std::shared_lock lock{ mutex_ };
+			if (const auto it = optional_types_.find(value_type); it != optional_types_.cend())
+			{
+				return it->second;
+			}
+		}
+
+		// Another thread may have created the type meanwhile, emplace keeps the first.
+		std::unique_lock lock{ mutex_ };
+		const auto [it, inserted] = optional_types_.emplace(value_type, nullptr);
+		if (inserted)
+		{
+			it->second = storage_.make<ir::ast::type>(ir::ast::optional_descriptor{ value_type });
+		}
+		return it->second;
+	}
+}
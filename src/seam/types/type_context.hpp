@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../ir/ast/type.hpp"
+#include "../utils/arena.hpp"
+
+#include <array>
+#include <cstddef>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace seam::types
+{
+	/**
+	 * Creates the types of a module, every distinct type exactly once, so types
+	 * are trivially copyable pointers that are equal exactly when the types are.
+	 */
+	class type_context
+	{
+		static constexpr std::size_t built_in_count = static_cast<std::size_t>(ir::ast::type::built_in_type::f64) + 1;
+
+		std::shared_mutex mutex_; // guards optional types, shared for lookups.
+		utils::arena storage_; // every type, stable for the lifetime of the context.
+		std::array<ir::ast::type*, built_in_count> built_in_types_{}; // indexed by built_in_type.
+		std::unordered_map<ir::ast::type*, ir::ast::type*> optional_types_; // by value type.
+	public:
+		type_context();
+
+		type_context(const type_context&) = delete;
+		type_context& operator=(const type_context&) = delete;
+
+		/**
+		 * Returns a built-in type.
+		 *
+		 * @param built_in which built-in type.
+		 * @returns the type, the same for every call with the same built-in type.
+		 */
+		[[nodiscard]] ir::ast::type* built_in(const ir::ast::type::built_in_type built_in) const
+		{
+			return built_in_types_[static_cast<std::size_t>(built_in)];
+		}
+
+		/**
+		 * Returns the optional type of a type, safe to call from several threads at once.
+		 *
+		 * @param value_type type of the value when present.
+		 * @returns the type, the same for every call with the same value type.
+		 */
+		ir::ast::type* optional(ir::ast::type* value_type);
+	};
+}
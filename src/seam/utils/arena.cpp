@@ -0,0 +1,83 @@
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace seam::utils
+{
+	void* arena::allocate_slow(const std::size_t size, const std::size_t alignment)
+	{
+		// Oversized allocations get a block of their own, the header keeps
+		// blocks aligned for anything up to alignof(std::max_align_t).
+		const auto block_size = std::max(next_block_size_, size + alignment);
+		const auto memory = static_cast<block*>(std::malloc(sizeof(block) + block_size));
+		if (!memory)
+		{
+			throw std::bad_alloc{};
+		}
+
+		memory->previous = blocks_;
+		memory->size = block_size;
+		blocks_ = memory;
+		bytes_reserved_ += block_size;
+
+		current_ = reinterpret_cast<std::byte*>(memory + 1);
+		end_ = current_ + block_size;
+		next_block_size_ = std::min(next_block_size_ * 2, max_block_size);
+
+		return allocate(size, alignment);
+	}
+
+	void arena::release()
+	{
+		for (auto entry = destructors_; entry; entry = entry->previous)
+		{
+			entry->destroy(entry->object);
+		}
+		destructors_ = nullptr;
+
+		while (blocks_)
+		{
+			std::free(std::exchange(blocks_, blocks_->previous));
+		}
+
+		current_ = end_ = nullptr;
+		bytes_used_ = bytes_reserved_ = 0;
+	}
+
+	void arena::adopt(arena& other)
+	{
+		// Adopted objects are destroyed (and their blocks freed) before our own,
+		// allocation keeps going in our current block.
+		if (other.destructors_)
+		{
+			auto oldest = other.destructors_;
+			while (oldest->previous)
+			{
+				oldest = oldest->previous;
+			}
+			oldest->previous = destructors_;
+			destructors_ = std::exchange(other.destructors_, nullptr);
+		}
+
+		if (other.blocks_)
+		{
+			auto oldest = other.blocks_;
+			while (oldest->previous)
+			{
+				oldest = oldest->previous;
+			}
+			oldest->previous = blocks_;
+			blocks_ = std::exchange(other.blocks_, nullptr);
+		}
+
+		bytes_used_ += std::exchange(other.bytes_used_, 0);
+		bytes_reserved_ += std::exchange(other.bytes_reserved_, 0);
+		other.current_ = other.end_ = nullptr;
+	}
+
+	arena::~arena()
+	{
+		release();
+	}
+}
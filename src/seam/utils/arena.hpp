@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace seam::utils
+{
+	/**
+	 * Bump-pointer allocator, everything allocated from an arena is
+	 * released together when the arena is destroyed.
+	 *
+	 * Trivially destructible objects cost nothing to release. Other objects
+	 * have their destructors recorded and run, newest first, on release.
+	 */
+	class arena
+	{
+		struct block
+		{
+			block* previous;
+			std::size_t size; // usable bytes following the header.
+		};
+
+		struct destructor
+		{
+			void (*destroy)(void* object);
+			void* object;
+			destructor* previous;
+		};
+
+		std::byte* current_ = nullptr;
+		std::byte* end_ = nullptr;
+		block* blocks_ = nullptr;
+		destructor* destructors_ = nullptr;
+
+		std::size_t next_block_size_;
+		std::size_t bytes_used_ = 0;
+		std::size_t bytes_reserved_ = 0;
+
+		void* allocate_slow(std::size_t size, std::size_t alignment);
+	public:
+		static constexpr std::size_t default_block_size = 64 * 1024;
+		static constexpr std::size_t max_block_size = 4 * 1024 * 1024;
+
+		/**
+		 * Initialises an empty arena, no memory is reserved until the first allocation.
+		 *
+		 * @param block_size size of the first block, later blocks grow up to max_block_size.
+		 */
+		explicit arena(std::size_t block_size = default_block_size) :
+			next_block_size_(block_size)
+		{}
+
+		~arena();
+
+		arena(const arena&) = delete;
+		arena& operator=(const arena&) = delete;
+
+		/**
+		 * Allocates uninitialised memory.
+		 *
+		 * @param size number of bytes to allocate.
+		 * @param alignment alignment of the memory, must be a power of two.
+		 * @returns pointer to the memory, valid until the arena is released.
+		 * @throws std::bad_alloc if a new block cannot be allocated.
+		 */
+		void* allocate(const std::size_t size, const std::size_t alignment)
+		{
+			const auto address = reinterpret_cast<std::uintptr_t>(current_);
+			const auto padding = (alignment - address % alignment) % alignment;
+			if (static_cast<std::size_t>(end_ - current_) < size + padding)
+			{
+				return allocate_slow(size, alignment);
+			}
+
+			const auto result = current_ + padding;
+			current_ = result + size;
+			bytes_used_ += size + padding;
+			return result;
+		}
+
+		/**
+		 * Constructs an object in the arena.
+		 *
+		 * @param args arguments forwarded to the constructor of T.
+		 * @returns non-owning pointer to the object, valid until the arena is released.
+		 */
+		template <typename T, typename... Args>
+		T* make(Args&&... args)
+		{
+			const auto object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			if constexpr (!std::is_trivially_destructible_v<T>)
+			{
+				const auto entry = static_cast<destructor*>(allocate(sizeof(destructor), alignof(destructor)));
+				entry->destroy = [](void* value) { static_cast<T*>(value)->~T(); };
+				entry->object = object;
+				entry->previous = destructors_;
+				destructors_ = entry;
+			}
+			return object;
+		}
+
+		/**
+		 * Runs recorded destructors and frees every block, the arena can be reused afterwards.
+		 */
+		void release();
+
+		/**
+		 * Takes ownership of everything allocated from another arena, objects stay
+		 * where they are and are released together with this arena.
+		 *
+		 * @param other arena to take over, left empty.
+		 */
+		void adopt(arena& other);
+
+		/**
+		 * Returns the number of bytes handed out, including alignment padding.
+		 */
+		[[nodiscard]] std::size_t bytes_used() const { return bytes_used_; }
+
+		/**
+		 * Returns the number of bytes reserved from the system.
+		 */
+		[[nodiscard]] std::size_t bytes_reserved() const { return bytes_reserved_; }
+	};
+}
@@ -0,0 +1,50 @@
+#include "interner.hpp"
+
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+namespace seam::utils
+{
+	symbol_id interner::intern(const std::string_view spelling)
+	{
+		if (const auto it = ids_.find(spelling); it != ids_.cend())
+		{
+			return it->second;
+		}
+
+		if (spellings_.size() > std::numeric_limits<std::uint32_t>::max())
+		{
+			throw std::length_error{ "too many distinct symbols" };
+		}
+
+		std::string_view stored;
+		if (!spelling.empty())
+		{
+			const auto copy = static_cast<char*>(storage_.allocate(spelling.size(), 1));
+			std::memcpy(copy, spelling.data(), spelling.size());
+			stored = { copy, spelling.size() };
+		}
+
+		const auto id = static_cast<symbol_id>(spellings_.size());
+		spellings_.push_back(stored);
+		ids_.emplace(stored, id);
+		return id;
+	}
+
+	symbol_id interner::intern_concurrently(const std::string_view spelling)
+	{
+		{
+			std::shared_lock lock{ mutex_ };
+			if (const auto it = ids_.find(spelling); it != ids_.cend())
+			{
+				return it->second;
+			}
+		}
+
+		// intern looks the spelling up again, another thread may have inserted it meanwhile.
+		std::unique_lock lock{ mutex_ };
+		return intern(spelling);
+	}
+}
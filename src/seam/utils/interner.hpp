@@ -0,0 +1,62 @@
+#pragma once
+
+#include "arena.hpp"
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace seam::utils
+{
+	/**
+	 * Identifier of an interned string, equal ids mean equal spellings.
+	 */
+	enum class symbol_id : std::uint32_t {};
+
+	/**
+	 * Maps identifiers, type names and function names to dense 32-bit ids,
+	 * so name lookups hash and compare integers rather than strings.
+	 */
+	class interner
+	{
+		std::shared_mutex mutex_; // guards intern_concurrently, shared for lookups.
+		arena storage_; // copies of every spelling, stable for the lifetime of the interner.
+		std::vector<std::string_view> spellings_; // indexed by symbol_id.
+		std::unordered_map<std::string_view, symbol_id> ids_;
+	public:
+		/**
+		 * Interns a string.
+		 *
+		 * @param spelling string to intern, copied on first use.
+		 * @returns id of the string, the same for every call with an equal string.
+		 */
+		symbol_id intern(std::string_view spelling);
+
+		/**
+		 * Interns a string, safe to call from several threads at once.
+		 *
+		 * @note must not run concurrently with intern or spelling, which stay lock free.
+		 * @param spelling string to intern, copied on first use.
+		 * @returns id of the string, the same for every call with an equal string.
+		 */
+		symbol_id intern_concurrently(std::string_view spelling);
+
+		/**
+		 * Returns the string an id was interned from.
+		 *
+		 * @param id id returned by intern.
+		 * @returns spelling of the id, valid for the lifetime of the interner.
+		 */
+		[[nodiscard]] std::string_view spelling(const symbol_id id) const
+		{
+			return spellings_[static_cast<std::uint32_t>(id)];
+		}
+
+		/**
+		 * Returns the number of distinct strings interned.
+		 */
+		[[nodiscard]] std::size_t size() const { return spellings_.size(); }
+	};
+}
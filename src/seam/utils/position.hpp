@@ -1,16 +1,17 @@
 #pragma once
 
-#include <cstddef>
+#include <cstdint>
 
 namespace seam::utils
 {
 	/**
-	 * Container for line and column position.
+	 * Byte offset into a source file.
+	 *
+	 * @note line and column are only computed for diagnostics, see lexer::line_index.
 	 */
 	struct position
 	{
-		std::size_t line; // line position
-		std::size_t column; // column position
+		std::uint32_t offset; // offset from start of source
 	};
 
 	/**
@@ -21,4 +22,4 @@ namespace seam::utils
 		position start; // start position
 		position end; // end position
 	};
-}
\ No newline at end of file
+}
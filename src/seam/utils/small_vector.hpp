@@ -0,0 +1,264 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace seam::utils
+{
+	/**
+	 * Vector keeping its first N elements inline, in the object itself, and only
+	 * allocating once it grows past them.
+	 *
+	 * Elements must be trivially copyable (ast lists hold pointers to arena nodes),
+	 * so growing, moving and erasing are plain memory copies.
+	 */
+	template <typename T, std::size_t N>
+	class small_vector
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "small_vector elements must be trivially copyable");
+		static_assert(N > 0 && N <= std::numeric_limits<std::uint32_t>::max(), "small_vector needs inline capacity");
+
+		T* data_;
+		std::uint32_t size_ = 0;
+		std::uint32_t capacity_ = N;
+		T inline_[N];
+
+		[[nodiscard]] bool is_inline() const { return data_ == inline_; }
+
+		/**
+		 * Moves the elements to a buffer with room for at least a number of elements.
+		 *
+		 * @param required number of elements the buffer needs room for.
+		 */
+		void grow(const std::size_t required)
+		{
+			if (required > std::numeric_limits<std::uint32_t>::max())
+			{
+				throw std::length_error{ "small_vector too long" };
+			}
+
+			const auto capacity = std::max<std::size_t>(required, std::min<std::size_t>(std::size_t{ capacity_ } * 2, std::numeric_limits<std::uint32_t>::max()));
+			const auto data = static_cast<T*>(::operator new(capacity * sizeof(T)));
+			std::memcpy(data, data_, size_ * sizeof(T));
+			if (!is_inline())
+			{
+				::operator delete(data_);
+			}
+
+			data_ = data;
+			capacity_ = static_cast<std::uint32_t>(capacity);
+		}
+
+		/**
+		 * Takes the elements of another vector, stealing its buffer if it allocated one.
+		 */
+		void take(small_vector& other) noexcept
+		{
+			if (other.is_inline())
+			{
+				std::memcpy(inline_, other.inline_, other.size_ * sizeof(T));
+				data_ = inline_;
+				capacity_ = N;
+			}
+			else
+			{
+				data_ = other.data_;
+				capacity_ = other.capacity_;
+				other.data_ = other.inline_;
+				other.capacity_ = N;
+			}
+			size_ = other.size_;
+			other.size_ = 0;
+		}
+
+		void release()
+		{
+			if (!is_inline())
+			{
+				::operator delete(data_);
+			}
+		}
+	public:
+		using value_type = T;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+		using reference = T&;
+		using const_reference = const T&;
+		using pointer = T*;
+		using const_pointer = const T*;
+		using iterator = T*;
+		using const_iterator = const T*;
+		using reverse_iterator = std::reverse_iterator<iterator>;
+		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+		static constexpr std::size_t inline_capacity = N;
+
+		small_vector() noexcept :
+			data_(inline_)
+		{}
+
+		template <typename Iterator, typename = typename std::iterator_traits<Iterator>::iterator_category>
+		small_vector(Iterator first, Iterator last) :
+			small_vector()
+		{
+			insert(end(), first, last);
+		}
+
+		small_vector(const small_vector& other) :
+			small_vector(other.begin(), other.end())
+		{}
+
+		small_vector(small_vector&& other) noexcept :
+			data_(inline_)
+		{
+			take(other);
+		}
+
+		~small_vector()
+		{
+			release();
+		}
+
+		small_vector& operator=(const small_vector& other)
+		{
+			if (this != &other)
+			{
+				clear();
+				insert(end(), other.begin(), other.end());
+			}
+			return *this;
+		}
+
+		small_vector& operator=(small_vector&& other) noexcept
+		{
+			if (this != &other)
+			{
+				release();
+				take(other);
+			}
+			return *this;
+		}
+
+		[[nodiscard]] iterator begin() { return data_; }
+		[[nodiscard]] iterator end() { return data_ + size_; }
+		[[nodiscard]] const_iterator begin() const { return data_; }
+		[[nodiscard]] const_iterator end() const { return data_ + size_; }
+		[[nodiscard]] const_iterator cbegin() const { return data_; }
+		[[nodiscard]] const_iterator cend() const { return data_ + size_; }
+		[[nodiscard]] reverse_iterator rbegin() { return reverse_iterator{ end() }; }
+		[[nodiscard]] reverse_iterator rend() { return reverse_iterator{ begin() }; }
+		[[nodiscard]] const_reverse_iterator crbegin() const { return const_reverse_iterator{ cend() }; }
+		[[nodiscard]] const_reverse_iterator crend() const { return const_reverse_iterator{ cbegin() }; }
+
+		[[nodiscard]] std::size_t size() const { return size_; }
+		[[nodiscard]] bool empty() const { return size_ == 0; }
+
+		/**
+		 * Returns the number of elements the vector holds without allocating (again).
+		 */
+		[[nodiscard]] std::size_t capacity() const { return capacity_; }
+
+		[[nodiscard]] T* data() { return data_; }
+		[[nodiscard]] const T* data() const { return data_; }
+
+		[[nodiscard]] T& operator[](const std::size_t index) { return data_[index]; }
+		[[nodiscard]] const T& operator[](const std::size_t index) const { return data_[index]; }
+		[[nodiscard]] T& front() { return data_[0]; }
+		[[nodiscard]] const T& front() const { return data_[0]; }
+		[[nodiscard]] T& back() { return data_[size_ - 1]; }
+		[[nodiscard]] const T& back() const { return data_[size_ - 1]; }
+
+		/**
+		 * Makes room for a number of elements, allocating at most once.
+		 *
+		 * @param capacity number of elements.
+		 */
+		void reserve(const std::size_t capacity)
+		{
+			if (capacity > capacity_)
+			{
+				grow(capacity);
+			}
+		}
+
+		void push_back(const T& value)
+		{
+			if (size_ == capacity_)
+			{
+				const auto copy = value; // value may be an element of this vector.
+				grow(std::size_t{ size_ } + 1);
+				data_[size_++] = copy;
+				return;
+			}
+			data_[size_++] = value;
+		}
+
+		template <typename... Args>
+		T& emplace_back(Args&&... args)
+		{
+			push_back(T(std::forward<Args>(args)...));
+			return back();
+		}
+
+		void pop_back()
+		{
+			--size_;
+		}
+
+		void clear()
+		{
+			size_ = 0;
+		}
+
+		/**
+		 * Inserts a range of elements, which must not be part of this vector.
+		 *
+		 * @param position element to insert the range before.
+		 * @param first first element of the range.
+		 * @param last end of the range.
+		 * @returns iterator to the first inserted element.
+		 */
+		template <typename Iterator>
+		iterator insert(const_iterator position, Iterator first, Iterator last)
+		{
+			const auto index = static_cast<std::size_t>(position - cbegin());
+			const auto count = static_cast<std::size_t>(std::distance(first, last));
+			reserve(std::size_t{ size_ } + count);
+
+			const auto at = data_ + index;
+			std::memmove(at + count, at, (size_ - index) * sizeof(T));
+			std::copy(first, last, at);
+			size_ += static_cast<std::uint32_t>(count);
+			return at;
+		}
+
+		/**
+		 * Erases a range of elements.
+		 *
+		 * @param first first element to erase.
+		 * @param last end of the elements to erase.
+		 * @returns iterator to the element following the erased ones.
+		 */
+		iterator erase(const_iterator first, const_iterator last)
+		{
+			const auto at = data_ + (first - cbegin());
+			const auto count = static_cast<std::size_t>(last - first);
+			std::memmove(at, at + count, static_cast<std::size_t>(cend() - last) * sizeof(T));
+			size_ -= static_cast<std::uint32_t>(count);
+			return at;
+		}
+
+		iterator erase(const_iterator position)
+		{
+			return erase(position, position + 1);
+		}
+	};
+}
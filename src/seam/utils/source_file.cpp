@@ -0,0 +1,219 @@
+#include "source_file.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace seam::utils
+{
+	namespace
+	{
+		constexpr std::size_t read_chunk_size = 64 * 1024;
+
+#if defined(_WIN32)
+		[[noreturn]] void throw_error(const std::string& path, const char* action)
+		{
+			throw std::runtime_error{ "failed to " + std::string{ action } + " '" + path + "' (error " + std::to_string(GetLastError()) + ")" };
+		}
+
+		std::string read_all(const HANDLE handle, const std::string& path)
+		{
+			std::string buffer;
+			DWORD bytes_read = 0;
+			do
+			{
+				const auto size = buffer.size();
+				buffer.resize(size + read_chunk_size);
+				if (!ReadFile(handle, buffer.data() + size, static_cast<DWORD>(read_chunk_size), &bytes_read, nullptr))
+				{
+					// A closed pipe is the end of input, not an error.
+					if (GetLastError() != ERROR_BROKEN_PIPE)
+					{
+						throw_error(path, "read");
+					}
+					bytes_read = 0;
+				}
+				buffer.resize(size + bytes_read);
+			} while (bytes_read != 0);
+			return buffer;
+		}
+#else
+		[[noreturn]] void throw_error(const std::string& path, const char* action)
+		{
+			throw std::runtime_error{ "failed to " + std::string{ action } + " '" + path + "': " + std::strerror(errno) };
+		}
+
+		std::string read_all(const int descriptor, const std::string& path)
+		{
+			std::string buffer;
+			for (;;)
+			{
+				const auto size = buffer.size();
+				buffer.resize(size + read_chunk_size);
+
+				const auto bytes_read = ::read(descriptor, buffer.data() + size, read_chunk_size);
+				if (bytes_read < 0)
+				{
+					if (errno == EINTR)
+					{
+						buffer.resize(size);
+						continue;
+					}
+					throw_error(path, "read");
+				}
+
+				buffer.resize(size + static_cast<std::size_t>(bytes_read));
+				if (bytes_read == 0)
+				{
+					return buffer;
+				}
+			}
+		}
+#endif
+	}
+
+	source_file::source_file(std::string path) : path_(std::move(path))
+	{
+		const auto is_stdin = path_ == "-";
+
+#if defined(_WIN32)
+		const auto handle = is_stdin
+			? GetStdHandle(STD_INPUT_HANDLE)
+			: CreateFileA(path_.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (handle == INVALID_HANDLE_VALUE)
+		{
+			throw_error(path_, "open");
+		}
+
+		LARGE_INTEGER size{};
+		if (GetFileType(handle) == FILE_TYPE_DISK && GetFileSizeEx(handle, &size) && size.QuadPart > 0)
+		{
+			if (const auto mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr))
+			{
+				mapping_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				mapping_size_ = mapping_ ? static_cast<std::size_t>(size.QuadPart) : 0;
+				CloseHandle(mapping); // The view keeps the mapping alive.
+			}
+		}
+
+		if (!mapping_)
+		{
+			try
+			{
+				buffer_ = read_all(handle, path_);
+			}
+			catch (...)
+			{
+				if (!is_stdin)
+				{
+					CloseHandle(handle);
+				}
+				throw;
+			}
+		}
+
+		if (!is_stdin)
+		{
+			CloseHandle(handle);
+		}
+#else
+		const auto descriptor = is_stdin ? STDIN_FILENO : ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+		if (descriptor < 0)
+		{
+			throw_error(path_, "open");
+		}
+
+		struct stat status{};
+		if (::fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0)
+		{
+			const auto size = static_cast<std::size_t>(status.st_size);
+			if (const auto mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0); mapping != MAP_FAILED)
+			{
+				// The lexer reads the whole file front to back.
+				::madvise(mapping, size, MADV_SEQUENTIAL);
+				mapping_ = static_cast<const char*>(mapping);
+				mapping_size_ = size;
+			}
+		}
+
+		if (!mapping_)
+		{
+			try
+			{
+				buffer_ = read_all(descriptor, path_);
+			}
+			catch (...)
+			{
+				if (!is_stdin)
+				{
+					::close(descriptor);
+				}
+				throw;
+			}
+		}
+
+		if (!is_stdin)
+		{
+			::close(descriptor); // The mapping stays valid after the descriptor is closed.
+		}
+#endif
+
+		contents_ = mapping_ ? std::string_view{ mapping_, mapping_size_ } : std::string_view{ buffer_ };
+	}
+
+	source_file::~source_file()
+	{
+		unmap();
+	}
+
+	source_file::source_file(source_file&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	source_file& source_file::operator=(source_file&& other) noexcept
+	{
+		if (this != &other)
+		{
+			unmap();
+
+			path_ = std::move(other.path_);
+			mapping_ = std::exchange(other.mapping_, nullptr);
+			mapping_size_ = std::exchange(other.mapping_size_, 0);
+			buffer_ = std::move(other.buffer_);
+
+			// A moved buffer may have been stored inline, so its view is rebuilt.
+			contents_ = mapping_ ? std::string_view{ mapping_, mapping_size_ } : std::string_view{ buffer_ };
+			other.contents_ = {};
+		}
+		return *this;
+	}
+
+	void source_file::unmap()
+	{
+		if (!mapping_)
+		{
+			return;
+		}
+
+#if defined(_WIN32)
+		UnmapViewOfFile(mapping_);
+#else
+		::munmap(const_cast<char*>(mapping_), mapping_size_);
+#endif
+		mapping_ = nullptr;
+		mapping_size_ = 0;
+	}
+}
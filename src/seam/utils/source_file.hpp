@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace seam::utils
+{
+	/**
+	 * Read-only contents of a source file.
+	 *
+	 * Regular files are memory mapped, so views into the contents point
+	 * straight at the page cache. Anything that cannot be mapped (pipes,
+	 * terminals, empty files) is read into a buffer instead.
+	 */
+	class source_file
+	{
+		std::string path_;
+
+		const char* mapping_ = nullptr; // start of the mapping, nullptr if the contents were read.
+		std::size_t mapping_size_ = 0;
+
+		std::string buffer_; // contents if the file could not be mapped.
+		std::string_view contents_;
+
+		void unmap();
+	public:
+		/**
+		 * Opens and maps (or reads) a source file.
+		 *
+		 * @param path path of the file, "-" reads standard input.
+		 * @throws std::runtime_error if the file cannot be opened or read.
+		 */
+		explicit source_file(std::string path);
+
+		~source_file();
+
+		source_file(const source_file&) = delete;
+		source_file& operator=(const source_file&) = delete;
+
+		source_file(source_file&& other) noexcept;
+		source_file& operator=(source_file&& other) noexcept;
+
+		/**
+		 * Returns the path the file was opened with.
+		 */
+		[[nodiscard]] const std::string& path() const { return path_; }
+
+		/**
+		 * Returns the file contents, valid for the lifetime of this object.
+		 */
+		[[nodiscard]] std::string_view contents() const { return contents_; }
+
+		/**
+		 * Returns whether the contents are memory mapped rather than read into a buffer.
+		 */
+		[[nodiscard]] bool is_mapped() const { return mapping_ != nullptr; }
+	};
+}
@@ -0,0 +1,123 @@
+#include "work_stealing.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace seam::utils
+{
+	namespace
+	{
+		// Items a worker has not started yet, [begin, end).
+		struct alignas(64) share
+		{
+			std::mutex mutex;
+			std::size_t begin = 0;
+			std::size_t end = 0;
+		};
+	}
+
+	void parallel_for(const std::size_t count, std::size_t worker_count, const std::function<void(std::size_t worker, std::size_t item)>& work)
+	{
+		worker_count = std::max<std::size_t>(std::min(worker_count, count), 1);
+		if (worker_count == 1)
+		{
+			for (std::size_t item = 0; item < count; ++item)
+			{
+				work(0, item);
+			}
+			return;
+		}
+
+		const auto shares = std::make_unique<share[]>(worker_count);
+		for (std::size_t worker = 0; worker < worker_count; ++worker)
+		{
+			shares[worker].begin = count * worker / worker_count;
+			shares[worker].end = count * (worker + 1) / worker_count;
+		}
+
+		// Moves the back half of the largest other share to the worker's own.
+		const auto steal = [&](const std::size_t worker)
+		{
+			for (;;)
+			{
+				auto victim = worker;
+				std::size_t largest = 0;
+				for (std::size_t other = 0; other < worker_count; ++other)
+				{
+					std::lock_guard lock{ shares[other].mutex };
+					if (other != worker && shares[other].end - shares[other].begin > largest)
+					{
+						largest = shares[other].end - shares[other].begin;
+						victim = other;
+					}
+				}
+
+				if (largest == 0)
+				{
+					return false; // items are never added, every share stays empty.
+				}
+
+				std::size_t begin, end;
+				{
+					std::lock_guard lock{ shares[victim].mutex };
+					auto& stolen = shares[victim];
+					if (stolen.begin == stolen.end)
+					{
+						continue; // emptied meanwhile, look again.
+					}
+					end = stolen.end;
+					begin = stolen.end - (stolen.end - stolen.begin + 1) / 2;
+					stolen.end = begin;
+				}
+
+				std::lock_guard lock{ shares[worker].mutex };
+				shares[worker].begin = begin;
+				shares[worker].end = end;
+				return true;
+			}
+		};
+
+		const auto run = [&](const std::size_t worker)
+		{
+			auto& own = shares[worker];
+			for (;;)
+			{
+				std::size_t item = 0;
+				bool found;
+				{
+					std::lock_guard lock{ own.mutex };
+					found = own.begin != own.end;
+					if (found)
+					{
+						item = own.begin++;
+					}
+				}
+
+				if (found)
+				{
+					work(worker, item);
+				}
+				else if (!steal(worker))
+				{
+					return;
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(worker_count - 1);
+		for (std::size_t worker = 1; worker < worker_count; ++worker)
+		{
+			threads.emplace_back(run, worker);
+		}
+		run(0);
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace seam::utils
+{
+	/**
+	 * Runs work on every item of [0, count) over a pool of worker threads.
+	 *
+	 * Each worker starts with a contiguous share of the items and takes them
+	 * from the front. A worker that runs out steals the back half of the
+	 * largest share left, so a few expensive items do not hold up the others.
+	 * The calling thread is worker 0, the others are started for the call and
+	 * joined before it returns.
+	 *
+	 * @param count number of items.
+	 * @param worker_count number of workers, at least 1.
+	 * @param work called with the worker index and the item, must not throw.
+	 */
+	void parallel_for(std::size_t count, std::size_t worker_count, const std::function<void(std::size_t worker, std::size_t item)>& work);
+}
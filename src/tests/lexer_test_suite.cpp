@@ -1,9 +1,27 @@
 #define CATCH_CONFIG_MAIN
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "../seam/types/module.hpp"
 #include "../seam/lexer/lexeme.hpp"
 #include "../seam/lexer/lexer.hpp"
+#include "../seam/lexer/line_index.hpp"
+#include "../seam/utils/arena.hpp"
+#include "../seam/utils/interner.hpp"
+#include "../seam/utils/small_vector.hpp"
+#include "../seam/utils/source_file.hpp"
 #include "3rdparty/catch2.hpp"
 
 TEST_CASE("Example lexed source", "[lexer]") {
@@ -61,4 +79,636 @@ TEST_CASE("Example lexed source", "[lexer]") {
 			REQUIRE(next_lexeme.value == expected_lexeme.value);
 		}
 	}
-}
\ No newline at end of file
+}
+
+TEST_CASE("Keywords and keyword-like identifiers", "[lexer]") {
+	const std::vector<seam::lexer::lexeme> expected_lexemes = {
+		{ seam::lexer::lexeme_type::kw_fn },
+		{ seam::lexer::lexeme_type::kw_as },
+		{ seam::lexer::lexeme_type::kw_return },
+		{ seam::lexer::lexeme_type::kw_type },
+		{ seam::lexer::lexeme_type::kw_try },
+		{ seam::lexer::lexeme_type::kw_catch },
+		{ seam::lexer::lexeme_type::kw_switch },
+		{ seam::lexer::lexeme_type::kw_throw },
+		{ seam::lexer::lexeme_type::kw_true },
+		{ seam::lexer::lexeme_type::kw_false },
+		{ seam::lexer::lexeme_type::kw_while },
+		{ seam::lexer::lexeme_type::kw_for },
+		{ seam::lexer::lexeme_type::kw_if },
+		{ seam::lexer::lexeme_type::kw_elseif },
+		{ seam::lexer::lexeme_type::kw_else },
+		{ seam::lexer::lexeme_type::kw_extern },
+		{ seam::lexer::lexeme_type::identifier, "f" },
+		{ seam::lexer::lexeme_type::identifier, "fn_" },
+		{ seam::lexer::lexeme_type::identifier, "Fn" },
+		{ seam::lexer::lexeme_type::identifier, "returns" },
+		{ seam::lexer::lexeme_type::identifier, "elsei" },
+		{ seam::lexer::lexeme_type::identifier, "externs" },
+		{ seam::lexer::lexeme_type::identifier, "fo" },
+		{ seam::lexer::lexeme_type::identifier, "_if" },
+		{ seam::lexer::lexeme_type::eof },
+	};
+
+	seam::lexer::lexer lexer(
+		std::make_shared<seam::types::module>("test"),
+		"fn as return type try catch switch throw true false while for if elseif else extern "
+		"f fn_ Fn returns elsei externs fo _if");
+
+	for (const auto& expected_lexeme : expected_lexemes)
+	{
+		lexer.next_lexeme();
+		const auto& next_lexeme = lexer.current_lexeme();
+		REQUIRE(next_lexeme.type == expected_lexeme.type);
+		if (!expected_lexeme.value.empty())
+		{
+			REQUIRE(next_lexeme.value == expected_lexeme.value);
+		}
+	}
+}
+
+
+TEST_CASE("Maximal munch symbols", "[lexer]") {
+	const std::vector<seam::lexer::lexeme_type> expected_types = {
+		seam::lexer::lexeme_type::symbol_add_assign,
+		seam::lexer::lexeme_type::symbol_add,
+		seam::lexer::lexeme_type::symbol_arrow,
+		seam::lexer::lexeme_type::symbol_minus_assign,
+		seam::lexer::lexeme_type::symbol_minus,
+		seam::lexer::lexeme_type::symbol_colon_equals,
+		seam::lexer::lexeme_type::symbol_colon,
+		seam::lexer::lexeme_type::symbol_eq,
+		seam::lexer::lexeme_type::symbol_equals,
+		seam::lexer::lexeme_type::symbol_neq,
+		seam::lexer::lexeme_type::symbol_not,
+		seam::lexer::lexeme_type::symbol_lteq,
+		seam::lexer::lexeme_type::symbol_lt,
+		seam::lexer::lexeme_type::symbol_gteq,
+		seam::lexer::lexeme_type::symbol_gt,
+		seam::lexer::lexeme_type::symbol_and,
+		seam::lexer::lexeme_type::symbol_or,
+		seam::lexer::lexeme_type::symbol_divide_assign,
+		seam::lexer::lexeme_type::symbol_divide,
+		seam::lexer::lexeme_type::symbol_mod,
+		seam::lexer::lexeme_type::symbol_open_parenthesis,
+		seam::lexer::lexeme_type::symbol_close_parenthesis,
+		seam::lexer::lexeme_type::symbol_comma,
+		seam::lexer::lexeme_type::symbol_question_mark,
+		seam::lexer::lexeme_type::symbol_multiply,
+		seam::lexer::lexeme_type::eof,
+	};
+
+	seam::lexer::lexer lexer(std::make_shared<seam::types::module>("test"), "+=+->-=-:=: ===!=!<=<>=>&&||/=/%(),?*");
+
+	for (const auto expected_type : expected_types)
+	{
+		lexer.next_lexeme();
+		REQUIRE(lexer.current_lexeme().type == expected_type);
+	}
+}
+
+TEST_CASE("Unknown symbols are rejected", "[lexer]") {
+	seam::lexer::lexer lexer(std::make_shared<seam::types::module>("test"), "a & b");
+
+	lexer.next_lexeme();
+	REQUIRE_THROWS(lexer.next_lexeme());
+}
+
+TEST_CASE("Line lookup across comments and whitespace runs", "[lexer]") {
+	std::string source = "first";
+	source += std::string(70, ' ') + "\n\t\t\t\n" + std::string(40, '\t') + "second\n";
+	source += "// short comment with a / and // inside\n";
+	source += "/// long\ncomment\n\n banner " + std::string(100, '=') + "\n ///third\n";
+	source += "fourth_identifier_which_is_longer_than_any_simd_block // trailing\n";
+	source += "// comment at end of file without a newline";
+
+	const std::vector<std::pair<std::string_view, std::size_t>> expected_identifiers = {
+		{ "first", 1 },
+		{ "second", 3 },
+		{ "third", 9 },
+		{ "fourth_identifier_which_is_longer_than_any_simd_block", 10 },
+	};
+
+	seam::lexer::lexer lexer(std::make_shared<seam::types::module>("test"), source);
+	const seam::lexer::line_index lines{ source };
+
+	for (const auto& [value, line] : expected_identifiers)
+	{
+		lexer.next_lexeme();
+		REQUIRE(lexer.current_lexeme().type == seam::lexer::lexeme_type::identifier);
+		REQUIRE(lexer.current_lexeme().value == value);
+		REQUIRE(lines.locate(lexer.current_lexeme().position).line == line);
+	}
+
+	lexer.next_lexeme();
+	REQUIRE(lexer.current_lexeme().type == seam::lexer::lexeme_type::eof);
+}
+
+TEST_CASE("Unterminated long comment", "[lexer]") {
+	seam::lexer::lexer lexer(std::make_shared<seam::types::module>("test"), "/// never closed // //\n\n");
+
+	REQUIRE_THROWS(lexer.next_lexeme());
+}
+
+TEST_CASE("Line index resolves offsets to line and column", "[lexer]") {
+	const std::string source = "ab\n\ncdef\n" + std::string(100, ' ') + "g";
+	const seam::lexer::line_index lines{ source };
+
+	const auto check = [&](const std::uint32_t offset, const std::size_t line, const std::size_t column)
+	{
+		const auto location = lines.locate({ offset });
+		REQUIRE(location.line == line);
+		REQUIRE(location.column == column);
+	};
+
+	check(0, 1, 1);
+	check(1, 1, 2);
+	check(2, 1, 3); // newline belongs to the line it ends
+	check(3, 2, 1);
+	check(4, 3, 1);
+	check(7, 3, 4);
+	check(109, 4, 101);
+}
+
+TEST_CASE("Batched and streaming lexing agree", "[lexer]") {
+	const std::string_view source = R"(
+		/// banner ///
+		fn main() @constructor // comment
+		{
+			x: string = "a \" b"
+			y := (1 + 0x2f) * 3 >= 4 && !z
+			peek(a, b)
+		}
+	)";
+
+	const auto module = std::make_shared<seam::types::module>("test");
+	seam::lexer::lexer streaming(module, source);
+	seam::lexer::lexer batched(module, source, seam::lexer::lexer_mode::batched);
+	seam::lexer::lexer cached(module, seam::lexer::lexer::tokenize(module, source));
+
+	do
+	{
+		REQUIRE(batched.peek_lexeme().type == streaming.peek_lexeme().type);
+
+		streaming.next_lexeme();
+		batched.next_lexeme();
+		cached.next_lexeme();
+
+		for (const auto* other : { &batched.current_lexeme(), &cached.current_lexeme() })
+		{
+			REQUIRE(other->type == streaming.current_lexeme().type);
+			REQUIRE(other->value == streaming.current_lexeme().value);
+			REQUIRE(other->position.offset == streaming.current_lexeme().position.offset);
+		}
+	} while (streaming.current_lexeme().type != seam::lexer::lexeme_type::eof);
+
+	batched.next_lexeme();
+	REQUIRE(batched.current_lexeme().type == seam::lexer::lexeme_type::eof);
+}
+
+TEST_CASE("Unterminated string literal", "[lexer]") {
+	seam::lexer::lexer lexer(std::make_shared<seam::types::module>("test"), "x := \"never closed");
+
+	lexer.next_lexeme();
+	lexer.next_lexeme();
+	REQUIRE_THROWS(lexer.next_lexeme());
+}
+
+TEST_CASE("Number literals with prefixes, exponents and suffixes", "[lexer]") {
+	const auto module = std::make_shared<seam::types::module>("test");
+	seam::lexer::lexer lexer(module, "0xFF_u8 0b1010 1_000 1.5e-3f32 2E+8 1e");
+
+	for (const auto expected : { "0xFF_u8", "0b1010", "1_000", "1.5e-3f32", "2E+8", "1e" })
+	{
+		lexer.next_lexeme();
+		REQUIRE(lexer.current_lexeme().type == seam::lexer::lexeme_type::literal_number);
+		REQUIRE(lexer.current_lexeme().value == expected);
+	}
+
+	SECTION("identical literals share their decoded constant") {
+		using built_in_type = seam::ir::ast::type::built_in_type;
+
+		auto& constants = module->constants;
+		const auto byte = constants.number("0xFF_u8");
+		REQUIRE(byte == constants.number("0xFF_u8"));
+		REQUIRE(std::get<std::uint64_t>(byte->value) == 255);
+		REQUIRE(byte->suffix_type == module->types.built_in(built_in_type::u8));
+
+		REQUIRE(std::get<std::uint64_t>(constants.number("0b1010")->value) == 10);
+		REQUIRE(std::get<std::uint64_t>(constants.number("1_000")->value) == 1000);
+		REQUIRE(constants.number("1_000")->suffix_type == nullptr);
+		REQUIRE(std::get<double>(constants.number("1.5e-3f32")->value) == 1.5e-3);
+		REQUIRE(constants.number("1.5e-3f32")->suffix_type == module->types.built_in(built_in_type::f32));
+		REQUIRE(std::get<double>(constants.number("2E+8")->value) == 2e8);
+	}
+
+	SECTION("malformed literals are rejected") {
+		auto& constants = module->constants;
+		REQUIRE_THROWS_AS(constants.number("1e"), std::invalid_argument);
+		REQUIRE_THROWS_AS(constants.number("256u8"), std::invalid_argument);
+		REQUIRE_THROWS_AS(constants.number("1.5i32"), std::invalid_argument);
+		REQUIRE_THROWS_AS(constants.number("0x"), std::invalid_argument);
+		REQUIRE_THROWS_AS(constants.number("18446744073709551616"), std::invalid_argument);
+	}
+
+	SECTION("literals fit the types they are used as") {
+		using built_in_type = seam::ir::ast::type::built_in_type;
+
+		auto& constants = module->constants;
+		const auto type = [&](const built_in_type built_in) { return module->types.built_in(built_in); };
+		REQUIRE(seam::types::fits(*constants.number("255"), type(built_in_type::u8)));
+		REQUIRE_FALSE(seam::types::fits(*constants.number("256"), type(built_in_type::u8)));
+		REQUIRE(seam::types::fits(*constants.number("1"), type(built_in_type::f32)));
+		REQUIRE_FALSE(seam::types::fits(*constants.number("1.5"), type(built_in_type::i64)));
+		REQUIRE_FALSE(seam::types::fits(*constants.number("1"), type(built_in_type::bool_)));
+	}
+
+	SECTION("folded values are spelled as suffixed literals") {
+		using built_in_type = seam::ir::ast::type::built_in_type;
+
+		auto& constants = module->constants;
+		REQUIRE(constants.number(std::uint64_t{ 8 }, built_in_type::i32) == constants.number("8i32"));
+		REQUIRE(constants.number(0.1, built_in_type::f64)->spelling == "0.1f64");
+		REQUIRE(std::get<double>(constants.number(1.2345678901234568e+20, built_in_type::f64)->value) == 1.2345678901234568e+20);
+		REQUIRE_THROWS_AS(constants.number(std::uint64_t{ 256 }, built_in_type::u8), std::invalid_argument);
+		REQUIRE_THROWS_AS(constants.number(-1.0, built_in_type::f64), std::invalid_argument);
+		REQUIRE_THROWS_AS(constants.number(std::uint64_t{ 1 }, built_in_type::bool_), std::invalid_argument);
+	}
+}
+
+TEST_CASE("Peeking several lexemes ahead", "[lexer]") {
+	const std::string_view source = "a := b + c";
+
+	const auto module = std::make_shared<seam::types::module>("test");
+	for (const auto mode : { seam::lexer::lexer_mode::streaming, seam::lexer::lexer_mode::batched })
+	{
+		seam::lexer::lexer lexer(module, source, mode);
+		lexer.next_lexeme();
+
+		REQUIRE(lexer.peek_lexeme(4).value == "c");
+		REQUIRE(lexer.peek_lexeme(5).type == seam::lexer::lexeme_type::eof);
+		REQUIRE(lexer.peek_lexeme(2).value == "b");
+		REQUIRE(lexer.current_lexeme().value == "a");
+
+		lexer.next_lexeme();
+		REQUIRE(lexer.current_lexeme().type == seam::lexer::lexeme_type::symbol_colon_equals);
+		REQUIRE(lexer.peek_lexeme().value == "b");
+		REQUIRE(lexer.peek_lexeme(3).value == "c");
+
+		REQUIRE_THROWS_AS(lexer.peek_lexeme(0), std::out_of_range);
+		REQUIRE_THROWS_AS(lexer.peek_lexeme(seam::lexer::lexer::max_lookahead + 1), std::out_of_range);
+	}
+}
+
+TEST_CASE("Restoring a checkpoint", "[lexer]") {
+	const std::string_view source = "fn f() { a // b\n c } d";
+
+	const auto module = std::make_shared<seam::types::module>("test");
+	for (const auto mode : { seam::lexer::lexer_mode::streaming, seam::lexer::lexer_mode::batched })
+	{
+		seam::lexer::lexer lexer(module, source, mode);
+		for (auto i = 0; i < 5; ++i)
+		{
+			lexer.next_lexeme();
+		}
+		REQUIRE(lexer.current_lexeme().type == seam::lexer::lexeme_type::symbol_open_brace);
+
+		const auto checkpoint = lexer.checkpoint();
+		REQUIRE(lexer.peek_lexeme(2).value == "c");
+		while (lexer.current_lexeme().type != seam::lexer::lexeme_type::eof)
+		{
+			lexer.next_lexeme();
+		}
+
+		lexer.restore(checkpoint);
+		REQUIRE(lexer.current_lexeme().type == seam::lexer::lexeme_type::symbol_open_brace);
+		REQUIRE(lexer.current_lexeme().position.offset == 7);
+
+		lexer.next_lexeme();
+		REQUIRE(lexer.current_lexeme().value == "a");
+		lexer.next_lexeme();
+		REQUIRE(lexer.current_lexeme().value == "c");
+	}
+}
+
+TEST_CASE("Types are unique", "[types]") {
+	using built_in_type = seam::ir::ast::type::built_in_type;
+
+	seam::types::type_context types;
+	REQUIRE(types.built_in(built_in_type::i32) == types.built_in(built_in_type::i32));
+	REQUIRE(types.built_in(built_in_type::i32) != types.built_in(built_in_type::u32));
+
+	const auto optional_i32 = types.optional(types.built_in(built_in_type::i32));
+	REQUIRE(optional_i32 == types.optional(types.built_in(built_in_type::i32)));
+	REQUIRE(optional_i32 != types.optional(types.built_in(built_in_type::u32)));
+	REQUIRE(std::get<seam::ir::ast::optional_descriptor>(optional_i32->value).value_type == types.built_in(built_in_type::i32));
+}
+
+TEST_CASE("Small vectors spill past their inline capacity", "[utils]") {
+	int values[5] = { 0, 1, 2, 3, 4 };
+
+	seam::utils::small_vector<int*, 2> list;
+	list.push_back(&values[0]);
+	list.push_back(&values[1]);
+	const auto inline_data = list.data();
+	REQUIRE(list.capacity() == 2);
+
+	list.push_back(&values[2]);
+	REQUIRE(list.capacity() > 2);
+	REQUIRE(list.data() != inline_data);
+
+	SECTION("moving steals a spilled buffer") {
+		const auto data = list.data();
+		const auto moved = std::move(list);
+		REQUIRE(moved.data() == data);
+		REQUIRE(moved.size() == 3);
+		REQUIRE(list.empty());
+	}
+
+	SECTION("inserting and erasing keep the order") {
+		int* inserted[] = { &values[3], &values[4] };
+		list.insert(list.cbegin() + 1, std::begin(inserted), std::end(inserted));
+		list.erase(list.cbegin());
+		REQUIRE(list.size() == 4);
+		REQUIRE(list[0] == &values[3]);
+		REQUIRE(list[1] == &values[4]);
+		REQUIRE(list[2] == &values[1]);
+		REQUIRE(list.back() == &values[2]);
+	}
+}
+
+TEST_CASE("Interned spellings map to dense ids", "[utils]") {
+	seam::utils::interner interner;
+
+	SECTION("ids are dense and equal for equal spellings") {
+		const auto alpha = interner.intern("alpha");
+		const auto beta = interner.intern("beta");
+		const auto empty = interner.intern("");
+		REQUIRE(static_cast<std::uint32_t>(alpha) == 0);
+		REQUIRE(static_cast<std::uint32_t>(beta) == 1);
+		REQUIRE(static_cast<std::uint32_t>(empty) == 2);
+		REQUIRE(interner.intern(std::string{ "alp" } + "ha") == alpha);
+		REQUIRE(interner.intern("") == empty);
+		REQUIRE(interner.size() == 3);
+		REQUIRE(interner.spelling(beta) == "beta");
+		REQUIRE(interner.spelling(empty).empty());
+	}
+
+	SECTION("spellings stay valid after what they were interned from is gone") {
+		seam::utils::symbol_id id;
+		{
+			auto source = std::make_unique<std::string>("fn temporary() {}");
+			id = interner.intern(std::string_view{ *source }.substr(3, 9));
+			source->assign(source->size(), 'x');
+		}
+		const auto spelling = interner.spelling(id);
+
+		// Enough spellings to grow the storage and rehash the lookup table.
+		for (auto index = 0; index < 10000; ++index)
+		{
+			interner.intern("symbol_" + std::to_string(index));
+		}
+		REQUIRE(interner.spelling(id) == "temporary");
+		REQUIRE(interner.spelling(id).data() == spelling.data());
+		REQUIRE(interner.intern("temporary") == id);
+	}
+
+	SECTION("interning concurrently agrees with interning") {
+		constexpr auto name_count = 2000;
+		constexpr auto thread_count = 4;
+
+		std::vector<std::string> names;
+		for (auto index = 0; index < name_count; ++index)
+		{
+			names.push_back("name_" + std::to_string(index % (name_count / 2)) + (index < name_count / 2 ? "" : "_"));
+		}
+
+		// Every thread interns every name, starting at a different one.
+		std::vector<std::vector<seam::utils::symbol_id>> ids(thread_count, std::vector<seam::utils::symbol_id>(name_count));
+		std::vector<std::thread> threads;
+		for (auto thread = 0; thread < thread_count; ++thread)
+		{
+			threads.emplace_back([&, thread]
+			{
+				for (auto step = 0; step < name_count; ++step)
+				{
+					const auto index = (step + thread * name_count / thread_count) % name_count;
+					ids[thread][index] = interner.intern_concurrently(names[index]);
+				}
+			});
+		}
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		REQUIRE(interner.size() == name_count);
+		std::vector<bool> seen(name_count);
+		for (auto index = 0; index < name_count; ++index)
+		{
+			const auto id = ids[0][index];
+			for (auto thread = 1; thread < thread_count; ++thread)
+			{
+				REQUIRE(ids[thread][index] == id);
+			}
+			REQUIRE(interner.intern(names[index]) == id);
+			REQUIRE(interner.spelling(id) == names[index]);
+
+			REQUIRE(static_cast<std::uint32_t>(id) < name_count);
+			REQUIRE(!seen[static_cast<std::uint32_t>(id)]);
+			seen[static_cast<std::uint32_t>(id)] = true;
+		}
+	}
+}
+
+TEST_CASE("Arenas hand out aligned memory and release it together", "[utils]") {
+	// Records the order objects are destroyed in.
+	struct tracked
+	{
+		std::vector<int>& destroyed;
+		int id;
+
+		~tracked() { destroyed.push_back(id); }
+	};
+
+	const auto is_aligned = [](const void* pointer, const std::size_t alignment) { return reinterpret_cast<std::uintptr_t>(pointer) % alignment == 0; };
+
+	seam::utils::arena arena{ 128 };
+
+	SECTION("allocations are aligned") {
+		for (const std::size_t alignment : { 1, 2, 4, 8, 16, 64 })
+		{
+			arena.allocate(1, 1);
+			REQUIRE(is_aligned(arena.allocate(24, alignment), alignment));
+		}
+
+		struct alignas(32) wide { char bytes[40]; };
+		arena.allocate(3, 1);
+		REQUIRE(is_aligned(arena.make<wide>(), alignof(wide)));
+		REQUIRE(is_aligned(arena.make<double>(1.5), alignof(double)));
+		REQUIRE(arena.bytes_used() <= arena.bytes_reserved());
+	}
+
+	SECTION("blocks grow and oversized allocations get their own") {
+		const auto first = static_cast<char*>(arena.allocate(100, 1));
+		std::fill(first, first + 100, 'a');
+		const auto reserved = arena.bytes_reserved();
+		REQUIRE(reserved >= 100);
+
+		const auto second = static_cast<char*>(arena.allocate(100, 1)); // does not fit the first block.
+		std::fill(second, second + 100, 'b');
+		REQUIRE(arena.bytes_reserved() >= reserved + 2 * 128);
+
+		const auto large = static_cast<char*>(arena.allocate(100000, 16));
+		std::fill(large, large + 100000, 'c');
+		REQUIRE(arena.bytes_reserved() >= reserved + 100000);
+		REQUIRE(is_aligned(large, 16));
+
+		REQUIRE(std::count(first, first + 100, 'a') == 100);
+		REQUIRE(std::count(second, second + 100, 'b') == 100);
+		REQUIRE(arena.bytes_used() >= 100200);
+	}
+
+	SECTION("destructors run newest first on release") {
+		std::vector<int> destroyed;
+		for (auto id = 0; id < 100; ++id)
+		{
+			arena.make<tracked>(tracked{ destroyed, id });
+		}
+		destroyed.clear(); // the temporaries moved from.
+
+		arena.release();
+		REQUIRE(destroyed.size() == 100);
+		REQUIRE(std::is_sorted(destroyed.crbegin(), destroyed.crend()));
+		REQUIRE(arena.bytes_used() == 0);
+		REQUIRE(arena.bytes_reserved() == 0);
+
+		arena.make<tracked>(tracked{ destroyed, 100 }); // usable again after release.
+		destroyed.clear();
+		arena.release();
+		REQUIRE(destroyed == std::vector<int>{ 100 });
+	}
+
+	SECTION("adopted allocations are released with the adopting arena") {
+		std::vector<int> destroyed;
+		arena.make<tracked>(tracked{ destroyed, 0 });
+		const auto kept = static_cast<char*>(arena.allocate(16, 1));
+		std::fill(kept, kept + 16, 'k');
+		{
+			seam::utils::arena other{ 64 };
+			other.make<tracked>(tracked{ destroyed, 1 });
+			const auto adopted = static_cast<char*>(other.allocate(1000, 1));
+			std::fill(adopted, adopted + 1000, 'o');
+			destroyed.clear();
+
+			const auto used = arena.bytes_used() + other.bytes_used();
+			const auto reserved = arena.bytes_reserved() + other.bytes_reserved();
+			arena.adopt(other);
+			REQUIRE(arena.bytes_used() == used);
+			REQUIRE(arena.bytes_reserved() == reserved);
+			REQUIRE(other.bytes_used() == 0);
+			REQUIRE(other.bytes_reserved() == 0);
+
+			other.make<tracked>(tracked{ destroyed, 2 }); // the adopted arena stays usable.
+			destroyed.clear();
+			REQUIRE(std::count(adopted, adopted + 1000, 'o') == 1000);
+		}
+		REQUIRE(destroyed == std::vector<int>{ 2 });
+
+		arena.allocate(500, 8); // allocation goes on after adopting.
+		REQUIRE(std::count(kept, kept + 16, 'k') == 16);
+
+		arena.release();
+		REQUIRE(destroyed == std::vector<int>{ 2, 1, 0 });
+	}
+}
+
+TEST_CASE("Source files are mapped or read", "[utils]") {
+	const auto directory = std::filesystem::temp_directory_path();
+	const auto write_file = [&](const char* name, const std::string& contents)
+	{
+		const auto path = (directory / name).string();
+		std::ofstream{ path, std::ios::binary | std::ios::trunc } << contents;
+		return path;
+	};
+
+	// Larger than a read chunk, so reading takes several.
+	std::string large;
+	for (auto line = 0; large.size() < 200 * 1024; ++line)
+	{
+		large += "fn f" + std::to_string(line) + "() -> i32 { return " + std::to_string(line) + " }\n";
+	}
+
+	SECTION("regular files are mapped") {
+		const auto path = write_file("seam_source_file_test.seam", large);
+		seam::utils::source_file file{ path };
+		REQUIRE(file.is_mapped());
+		REQUIRE(file.path() == path);
+		REQUIRE(file.contents() == large);
+
+		const auto contents = file.contents();
+		const auto moved = std::move(file);
+		REQUIRE(moved.contents().data() == contents.data());
+		REQUIRE(file.contents().empty());
+		std::filesystem::remove(path);
+	}
+
+	SECTION("empty files are read") {
+		const auto path = write_file("seam_source_file_test.seam", "");
+		const seam::utils::source_file file{ path };
+		REQUIRE(!file.is_mapped());
+		REQUIRE(file.contents().empty());
+		std::filesystem::remove(path);
+	}
+
+	SECTION("missing files cannot be opened") {
+		const auto path = (directory / "seam_source_file_missing.seam").string();
+		std::filesystem::remove(path);
+		REQUIRE_THROWS_AS(seam::utils::source_file{ path }, std::runtime_error);
+	}
+
+#if !defined(_WIN32)
+	// Opens "-" with standard input redirected to a descriptor.
+	const auto open_stdin = [](const int descriptor)
+	{
+		const auto saved = ::dup(STDIN_FILENO);
+		::dup2(descriptor, STDIN_FILENO);
+		::close(descriptor);
+		seam::utils::source_file file{ "-" };
+		::dup2(saved, STDIN_FILENO);
+		::close(saved);
+		return file;
+	};
+
+	SECTION("standard input is mapped when it is a regular file") {
+		const auto path = write_file("seam_source_file_test.seam", large);
+		const auto file = open_stdin(::open(path.c_str(), O_RDONLY));
+		REQUIRE(file.is_mapped());
+		REQUIRE(file.contents() == large);
+		std::filesystem::remove(path);
+	}
+
+	SECTION("standard input is read when it is a pipe") {
+		int pipe[2];
+		REQUIRE(::pipe(pipe) == 0);
+		std::thread writer{ [&]
+		{
+			for (std::size_t written = 0; written < large.size();)
+			{
+				const auto count = ::write(pipe[1], large.data() + written, large.size() - written);
+				if (count <= 0)
+				{
+					break;
+				}
+				written += static_cast<std::size_t>(count);
+			}
+			::close(pipe[1]);
+		} };
+
+		const auto file = open_stdin(pipe[0]);
+		writer.join();
+		REQUIRE(!file.is_mapped());
+		REQUIRE(file.contents() == large);
+	}
+#endif
+}
@@ -0,0 +1,1007 @@
+#define CATCH_CONFIG_MAIN
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../seam/ir/ast/flat_expressions.hpp"
+#include "../seam/ir/ast/visitor.hpp"
+#include "../seam/parser/parser.hpp"
+#include "../seam/parser/scoped_table.hpp"
+#include "../seam/parser/passes/pass_manager.hpp"
+#include "../seam/types/module.hpp"
+#include "../seam/types/module_cache.hpp"
+#include "../seam/utils/exception.hpp"
+#include "../seam/utils/work_stealing.hpp"
+#include "3rdparty/catch2.hpp"
+
+namespace
+{
+	// Spells out every node of a module in visiting order with its range and type,
+	// what calls resolved to, and the dependencies and flat body of every function,
+	// so modules parsed in different ways can be compared.
+	struct describer
+	{
+		const seam::types::module& module;
+		bool with_ids; // whether symbol ids are spelled out, which depend on what the module interned before.
+		std::ostringstream out;
+		std::unordered_map<const seam::ir::ast::node*, std::size_t> ordinals; // of the nodes described so far.
+
+		void describe(const seam::ir::ast::type* type)
+		{
+			if (!type)
+			{
+				out << " untyped";
+			}
+			else if (const auto built_in = std::get_if<seam::ir::ast::type::built_in_type>(&type->value))
+			{
+				out << " t" << static_cast<int>(*built_in);
+			}
+			else if (const auto optional = std::get_if<seam::ir::ast::optional_descriptor>(&type->value))
+			{
+				out << " ?";
+				describe(optional->value_type);
+			}
+			else
+			{
+				out << " class";
+			}
+		}
+
+		void describe(const seam::ir::ast::expression::function_signature* signature)
+		{
+			out << ' ' << module.interner.spelling(signature->name);
+			if (with_ids)
+			{
+				out << '#' << static_cast<std::uint32_t>(signature->name);
+			}
+			describe(signature->return_type);
+		}
+
+		bool visit(seam::ir::ast::node* node)
+		{
+			using namespace seam::ir::ast;
+
+			ordinals.emplace(node, ordinals.size());
+			out << '(' << static_cast<int>(node->kind) << ' ' << node->range.start.offset << '-' << node->range.end.offset;
+			if (const auto expression = node->as<expression::expression>())
+			{
+				describe(expression->eval_type);
+			}
+
+			if (const auto literal = node->as<expression::number_literal>())
+			{
+				out << ' ' << literal->constant->spelling;
+			}
+			else if (const auto variable = node->as<expression::variable_ref>())
+			{
+				out << ' ' << module.interner.spelling(variable->var->name);
+				if (with_ids)
+				{
+					out << '#' << static_cast<std::uint32_t>(variable->var->name);
+				}
+				describe(variable->var->type_);
+			}
+			else if (const auto symbol = node->as<expression::symbol_wrapper>())
+			{
+				describe(static_cast<expression::resolved_symbol*>(symbol->value)->signature);
+			}
+			else if (const auto signature = node->as<expression::function_signature>())
+			{
+				describe(signature);
+			}
+			else if (const auto definition = node->as<statement::function_definition>())
+			{
+				std::vector<std::string_view> dependencies;
+				for (const auto dependency : definition->function_dependencies)
+				{
+					dependencies.push_back(module.interner.spelling(dependency->name));
+				}
+				std::sort(dependencies.begin(), dependencies.end());
+				for (const auto dependency : dependencies)
+				{
+					out << " calls " << dependency;
+				}
+			}
+			return true;
+		}
+
+		void leave(seam::ir::ast::node* node)
+		{
+			const auto definition = node->as<seam::ir::ast::statement::function_definition>();
+			if (definition && definition->flat_body)
+			{
+				for (const auto& expression : definition->flat_body->expressions)
+				{
+					out << " [" << ordinals.at(expression.node) << ' ' << static_cast<int>(expression.kind()) << ' ' << expression.left << ' '
+						<< expression.right << ' ' << static_cast<int>(expression.operation()) << ']';
+				}
+				for (const auto argument : definition->flat_body->arguments)
+				{
+					out << ' ' << argument;
+				}
+			}
+			out << ')';
+		}
+	};
+
+	std::string describe(const seam::types::module& module, const bool with_ids = true)
+	{
+		describer vst{ module, with_ids };
+		module.body->visit(&vst);
+		return vst.out.str();
+	}
+
+	std::string describe(const seam::utils::exception& error)
+	{
+		return "error at " + std::to_string(error.position.offset) + ": " + error.what();
+	}
+
+	// Parses a source with every pass, describing the module or the error.
+	std::string parse_and_describe(const std::string& source, const seam::parser::body_parsing bodies = seam::parser::body_parsing::eager,
+		const bool with_ids = true)
+	{
+		const auto module = std::make_shared<seam::types::module>("test");
+		seam::parser::parser parser{ module, "test", source };
+		try
+		{
+			module->body = parser.parse(bodies);
+		}
+		catch (const seam::utils::exception& error)
+		{
+			return describe(error);
+		}
+		return describe(*module, with_ids);
+	}
+
+	// Parses a source, then replaces the first occurrence of a text in it and reparses it.
+	std::string reparse_and_describe(const std::string& source, const std::string& replaced, const std::string& replacement)
+	{
+		const auto module = std::make_shared<seam::types::module>("test");
+		{
+			seam::parser::parser parser{ module, "test", source };
+			module->body = parser.parse();
+		}
+
+		const auto found = source.find(replaced);
+		REQUIRE(found != std::string::npos);
+		const auto offset = static_cast<std::uint32_t>(found);
+		const auto edited = std::string{ source }.replace(offset, replaced.size(), replacement);
+
+		seam::parser::parser parser{ module, "test", edited };
+		try
+		{
+			parser.reparse({ { { { offset }, { static_cast<std::uint32_t>(offset + replaced.size()) } }, static_cast<std::uint32_t>(replacement.size()) } });
+		}
+		catch (const seam::utils::exception& error)
+		{
+			return describe(error);
+		}
+		return describe(*module, false);
+	}
+
+	std::string edit(std::string source, const std::string& replaced, const std::string& replacement)
+	{
+		return source.replace(source.find(replaced), replaced.size(), replacement);
+	}
+
+	// Spells out an expression, parenthesising every operation.
+	std::string spell(const seam::types::module& module, seam::ir::ast::expression::expression* expression)
+	{
+		using namespace seam::ir::ast;
+
+		if (const auto literal = expression->as<expression::number_literal>())
+		{
+			return std::string{ literal->constant->spelling };
+		}
+		if (const auto literal = expression->as<expression::bool_literal>())
+		{
+			return literal->value ? "true" : "false";
+		}
+		if (const auto variable = expression->as<expression::variable_ref>())
+		{
+			return std::string{ module.interner.spelling(variable->var->name) };
+		}
+		if (const auto symbol = expression->as<expression::symbol_wrapper>())
+		{
+			return std::string{ module.interner.spelling(static_cast<expression::resolved_symbol*>(symbol->value)->signature->name) };
+		}
+		if (const auto unary = expression->as<expression::unary>())
+		{
+			return "(" + seam::lexer::lexeme::to_string(unary->operation) + spell(module, unary->right) + ")";
+		}
+		if (const auto binary = expression->as<expression::binary>())
+		{
+			return "(" + spell(module, binary->left) + " " + seam::lexer::lexeme::to_string(binary->operation) + " " + spell(module, binary->right) + ")";
+		}
+		if (const auto call = expression->as<expression::call>())
+		{
+			std::string spelling = spell(module, call->function) + "(";
+			for (const auto argument : call->arguments)
+			{
+				spelling += (spelling.back() == '(' ? "" : ", ") + spell(module, argument);
+			}
+			return spelling + ")";
+		}
+		return "<expression>";
+	}
+
+	std::string spell(const seam::types::module& module, seam::ir::ast::statement::statement* statement);
+
+	std::string spell(const seam::types::module& module, seam::ir::ast::statement::normal_block* block)
+	{
+		std::string spelling = "{";
+		for (const auto statement : block->body)
+		{
+			spelling += " " + spell(module, statement) + ";";
+		}
+		return spelling + " }";
+	}
+
+	// Spells out a statement, the statements of blocks in braces.
+	std::string spell(const seam::types::module& module, seam::ir::ast::statement::statement* statement)
+	{
+		using namespace seam::ir::ast;
+
+		if (const auto assignment = statement->as<statement::assignment>())
+		{
+			return spell(module, assignment->to) + " = " + spell(module, assignment->from);
+		}
+		if (const auto expression = statement->as<statement::expression_>())
+		{
+			return spell(module, expression->value);
+		}
+		if (const auto ret = statement->as<statement::ret>())
+		{
+			return ret->value ? "return " + spell(module, ret->value) : "return";
+		}
+		if (const auto if_stat = statement->as<statement::if_stat>())
+		{
+			return "if " + spell(module, if_stat->condition) + " " + spell(module, if_stat->main_body)
+				+ (if_stat->else_body ? " else " + spell(module, if_stat->else_body) : "");
+		}
+		if (const auto loop = statement->as<statement::while_loop>())
+		{
+			return "while " + spell(module, loop->condition) + " " + spell(module, loop->body);
+		}
+		if (const auto block = statement->as<statement::normal_block>())
+		{
+			return spell(module, block);
+		}
+		return "<statement>";
+	}
+
+	// Parses a source with every pass, throwing its error.
+	std::shared_ptr<seam::types::module> parse_module(const std::string& source)
+	{
+		const auto module = std::make_shared<seam::types::module>("test");
+		seam::parser::parser parser{ module, "test", source };
+		module->body = parser.parse();
+		return module;
+	}
+
+	seam::ir::ast::statement::function_definition* find_function(const seam::types::module& module, const std::string_view name)
+	{
+		for (const auto statement : module.body->body)
+		{
+			const auto definition = statement->as<seam::ir::ast::statement::function_definition>();
+			if (definition && module.interner.spelling(definition->signature->name) == name)
+			{
+				return definition;
+			}
+		}
+		return nullptr;
+	}
+
+	// Parses the statements of a constructor next to a function g returning an i32, spelling them out after the passes ran.
+	std::vector<std::string> parse_statements(const std::string& statements)
+	{
+		const auto module = parse_module("fn g() -> i32\n{\n\treturn 1\n}\n\nfn main() @constructor\n{\n" + statements + "}\n");
+		std::vector<std::string> spellings;
+		for (const auto statement : find_function(*module, "main")->body->body)
+		{
+			spellings.push_back(spell(*module, statement));
+		}
+		return spellings;
+	}
+}
+
+TEST_CASE("Call graph components come after the components they call", "[types]") {
+	using namespace seam::ir::ast;
+
+	// main -> even <-> odd -> puts, loop -> loop
+	seam::types::module module{ "test" };
+	std::vector<statement::function_definition*> definitions;
+	const auto make_signature = [&](const char* name)
+	{
+		return module.arena.make<expression::function_signature>(module.name, module.interner.intern(name), name,
+			module.types.built_in(type::built_in_type::void_), expression::parameter_list{}, expression::attribute_list{});
+	};
+	for (const auto name : { "main", "even", "odd", "loop" })
+	{
+		definitions.push_back(module.arena.make<statement::function_definition>(seam::utils::position_range{}, make_signature(name), nullptr));
+	}
+	const auto puts = make_signature("puts");
+
+	const auto [main, even, odd, loop] = std::array{ definitions[0], definitions[1], definitions[2], definitions[3] };
+	main->function_dependencies = { even->signature };
+	even->function_dependencies = { odd->signature };
+	odd->function_dependencies = { even->signature, puts };
+	loop->function_dependencies = { loop->signature };
+
+	auto& calls = module.calls;
+	calls.build(definitions);
+	REQUIRE(calls.size() == 5);
+	REQUIRE(calls.find(puts) == 4);
+	REQUIRE(calls.definition(4) == nullptr);
+	REQUIRE(calls.calls(0, 1));
+	REQUIRE_FALSE(calls.calls(1, 0));
+	REQUIRE(std::vector<std::uint32_t>(calls.callers(1).begin(), calls.callers(1).end()) == std::vector<std::uint32_t>{ 0, 2 });
+
+	REQUIRE(calls.component_count() == 4);
+	REQUIRE(calls.component(1) == calls.component(2));
+	REQUIRE(calls.is_recursive(1));
+	REQUIRE(calls.is_recursive(3));
+	REQUIRE_FALSE(calls.is_recursive(0));
+
+	const auto position = [&](const std::vector<std::uint32_t>& order, const std::uint32_t function)
+	{
+		return std::find(order.cbegin(), order.cend(), function) - order.cbegin();
+	};
+	REQUIRE(position(calls.bottom_up(), 4) < position(calls.bottom_up(), 2));
+	REQUIRE(position(calls.bottom_up(), 1) < position(calls.bottom_up(), 0));
+	REQUIRE(position(calls.top_down(), 0) < position(calls.top_down(), 1));
+}
+
+TEST_CASE("Passes run in order once their analyses are valid", "[passes]") {
+	using namespace seam::parser::passes;
+
+	struct recorder final : pass
+	{
+		std::vector<const char*>& log;
+
+		recorder(const char* name, const analysis_set required, const analysis_set provided, const analysis_set preserved, std::vector<const char*>& log) :
+			pass(name, pass_scope::module, required, provided, preserved), log(log)
+		{}
+
+		void run_module(pass_context& context) override
+		{
+			log.push_back(name);
+		}
+	};
+
+	std::vector<const char*> log;
+	pass_manager manager;
+	REQUIRE_THROWS_AS(manager.add<recorder>("early", analysis::function_table, 0, all_analyses, log), std::logic_error);
+
+	manager.add<recorder>("collect", 0, analysis::function_table, all_analyses, log);
+	manager.add<recorder>("resolve", analysis::function_table, analysis::resolved_symbols, all_analyses, log);
+	manager.add<recorder>("rewrite", analysis::resolved_symbols, 0, analysis::function_table, log);
+	REQUIRE_THROWS_AS(manager.add<recorder>("stale", analysis::resolved_symbols, 0, all_analyses, log), std::logic_error);
+
+	seam::types::module module{ "test" };
+	pass_context context{ module, nullptr };
+	const auto statistics = manager.run(context);
+	REQUIRE(log == std::vector<const char*>{ "collect", "resolve", "rewrite" });
+	REQUIRE(statistics.size() == 3);
+	REQUIRE(std::string{ statistics[1].name } == "resolve");
+}
+
+TEST_CASE("Work is stolen until every item ran once", "[utils]") {
+	constexpr std::size_t item_count = 1000;
+	constexpr std::size_t worker_count = 4;
+
+	// The items of the first worker's share are the slow ones, the others steal them.
+	std::vector<std::atomic<int>> runs(item_count);
+	std::vector<std::atomic<std::size_t>> items_by_worker(worker_count);
+	seam::utils::parallel_for(item_count, worker_count, [&](const std::size_t worker, const std::size_t item)
+	{
+		if (item < item_count / worker_count)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds{ 100 });
+		}
+		++runs[item];
+		++items_by_worker[worker];
+	});
+
+	for (const auto& count : runs)
+	{
+		REQUIRE(count == 1);
+	}
+
+	std::size_t total = 0;
+	for (const auto& count : items_by_worker)
+	{
+		total += count;
+	}
+	REQUIRE(total == item_count);
+}
+
+TEST_CASE("Reparsing agrees with parsing the edited source", "[parser]") {
+	const std::string source =
+		"fn g() -> i32\n"
+		"{\n"
+		"\treturn 1\n"
+		"}\n"
+		"\n"
+		"fn f() -> i32\n"
+		"{\n"
+		"\ty := g()\n"
+		"\tz := y + 2\n"
+		"\treturn z\n"
+		"}\n"
+		"\n"
+		"fn main() @constructor\n"
+		"{\n"
+		"\tf()\n"
+		"}\n";
+
+	const auto check = [&](const std::string& replaced, const std::string& replacement)
+	{
+		const auto reparsed = reparse_and_describe(source, replaced, replacement);
+		REQUIRE(reparsed == parse_and_describe(edit(source, replaced, replacement), seam::parser::body_parsing::eager, false));
+		return reparsed;
+	};
+
+	SECTION("changing a literal") {
+		check("return 1", "return 12345");
+	}
+
+	SECTION("changing a return type retypes the callers") {
+		check("fn g() -> i32", "fn g() -> i64");
+		check("fn g() -> i32", "fn g() -> u8");
+	}
+
+	SECTION("changing the number of parameters") {
+		check("fn g()", "fn g(a: i32, b: i32)");
+	}
+
+	SECTION("renaming a called function") {
+		const auto reparsed = check("fn g()", "fn h()");
+		REQUIRE(reparsed.rfind("error at ", 0) == 0);
+	}
+
+	SECTION("inserting a function") {
+		check("fn f()", "fn h() -> u8\n{\n\treturn 2\n}\n\nfn f()");
+	}
+
+	SECTION("falling back to parsing everything") {
+		check("fn f()", "type T = i64\n\nfn f()");
+		check("\treturn 1\n}", "\treturn 1\n");
+	}
+}
+
+TEST_CASE("Skipped bodies only see the types defined before them", "[parser]") {
+	const auto body =
+		"fn f() -> i32\n"
+		"{\n"
+		"\tx: T = 1\n"
+		"\treturn x\n"
+		"}\n"
+		"\n"
+		"fn main() @constructor\n"
+		"{\n"
+		"\tf()\n"
+		"}\n";
+	const std::string before = std::string{ "type T = i64\n" } + body;
+	const std::string after = std::string{ body } + "type T = i64\n";
+
+	const auto eager = parse_and_describe(after, seam::parser::body_parsing::eager, false);
+	REQUIRE(eager.rfind("error at ", 0) == 0);
+	REQUIRE(parse_and_describe(after, seam::parser::body_parsing::lazy, false) == eager);
+	REQUIRE(parse_and_describe(before, seam::parser::body_parsing::lazy, false) == parse_and_describe(before, seam::parser::body_parsing::eager, false));
+}
+
+TEST_CASE("Bodies parsed in parallel match bodies parsed eagerly", "[parser]") {
+	constexpr std::size_t function_count = 64;
+	constexpr std::size_t worker_count = 4;
+
+	std::string source;
+	for (std::size_t function = 0; function < function_count; ++function)
+	{
+		const auto name = "f" + std::to_string(function);
+		const auto callee = function + 1 < function_count ? "f" + std::to_string(function + 1) + "()" : std::string{ "1" };
+		source += "type t" + name + " = i" + std::to_string(8 << function % 4) + "\n"
+			"fn " + name + "() -> i32\n"
+			"{\n"
+			"\tlocal_" + name + ": t" + name + " = 2\n"
+			"\tshared := " + callee + " + 3\n"
+			"\tif (shared > 4)\n"
+			"\t{\n"
+			"\t\tinner_" + name + " := shared * 5\n"
+			"\t}\n"
+			"\treturn shared\n"
+			"}\n";
+	}
+	source += "fn main() @constructor\n{\n\tf0()\n}\n";
+
+	const auto parse = [](const std::string& source, const seam::parser::body_parsing bodies)
+	{
+		const auto module = std::make_shared<seam::types::module>("test");
+		seam::parser::parser parser{ module, "test", source };
+		try
+		{
+			module->body = parser.parse(bodies, worker_count);
+		}
+		catch (const seam::utils::exception& error)
+		{
+			return describe(error);
+		}
+		return describe(*module);
+	};
+
+	SECTION("the same nodes and symbol ids") {
+		REQUIRE(parse(source, seam::parser::body_parsing::parallel) == parse(source, seam::parser::body_parsing::eager));
+	}
+
+	SECTION("the same first error") {
+		for (const auto broken : { "f60", "f7", "f33" })
+		{
+			auto edited = edit(source, std::string{ "\tlocal_" } + broken + ": t" + broken, std::string{ "\tlocal_" } + broken + ": undefined_" + broken);
+			edited = edit(edited, "inner_f9 := shared", "inner_f9 := )");
+			const auto eager = parse(edited, seam::parser::body_parsing::eager);
+			REQUIRE(eager.rfind("error at ", 0) == 0);
+			REQUIRE(parse(edited, seam::parser::body_parsing::parallel) == eager);
+		}
+	}
+
+	SECTION("types defined after a body stay out of it") {
+		const auto edited = edit(source, "type tf3 = ", "type tf3x = ") + "type tf3 = i64\n";
+		const auto eager = parse(edited, seam::parser::body_parsing::eager);
+		REQUIRE(eager.rfind("error at ", 0) == 0);
+		REQUIRE(parse(edited, seam::parser::body_parsing::parallel) == eager);
+	}
+}
+
+TEST_CASE("Constant expressions are folded", "[passes]") {
+	using statements = std::vector<std::string>;
+
+	SECTION("wrapping at the width and signedness of their type") {
+		REQUIRE(parse_statements("\ta: u8 = 0 - 1\n") == statements{ "a = 255u8" });
+		REQUIRE(parse_statements("\ta: i8 = 100 + 100\n") == statements{ "a = (-56i8)" });
+		REQUIRE(parse_statements("\ta: i32 = 2147483647 + 2\n") == statements{ "a = (-2147483647i32)" });
+		REQUIRE(parse_statements("\ta: u64 = 0 - 1\n") == statements{ "a = 18446744073709551615u64" });
+	}
+
+	SECTION("division by zero is left to fail when it runs") {
+		REQUIRE(parse_statements("\ta := 7 / 0\n\tb := 7 % 0\n") == statements{ "a = (7 / 0)", "b = (7 % 0)" });
+	}
+
+	SECTION("signed division and remainder truncate towards zero") {
+		REQUIRE(parse_statements("\ta := (0 - 7) / 2\n\tb := (0 - 7) % 2\n\tc := 7 % (0 - 2)\n")
+			== statements{ "a = (-3i32)", "b = (-1i32)", "c = 1i32" });
+	}
+
+	SECTION("variables bound with := are propagated") {
+		REQUIRE(parse_statements("\ta := 3\n\tb := a * 2\n\tc := g() + b\n") == statements{ "a = 3", "b = 6i32", "c = (g() + 6i32)" });
+	}
+
+	SECTION("branches that never run are dropped") {
+		REQUIRE(parse_statements("\tif (true)\n\t{\n\t\tg()\n\t}\n") == statements{ "g()" });
+		REQUIRE(parse_statements("\tif (1 > 2)\n\t{\n\t\tg()\n\t}\n\telse\n\t{\n\t\ta := 4\n\t}\n") == statements{ "a = 4" });
+		REQUIRE(parse_statements("\twhile (false)\n\t{\n\t\tg()\n\t}\n").empty());
+		REQUIRE(parse_statements("\tif (g() > 2)\n\t{\n\t\ta := 4\n\t}\n") == statements{ "if (g() > 2) { a = 4; }" });
+	}
+
+	SECTION("calls in dropped branches are no dependencies") {
+		const auto dependencies = [](const std::string& condition)
+		{
+			const auto module = parse_module("fn g() -> i32\n{\n\treturn 1\n}\n\nfn main() @constructor\n{\n\tif (" + condition + ")\n\t{\n\t\tg()\n\t}\n}\n");
+			const auto main = find_function(*module, "main");
+			REQUIRE(module->calls.callees(module->calls.find(main->signature)).size() == main->function_dependencies.size());
+			return main->function_dependencies.size();
+		};
+		REQUIRE(dependencies("2 > 1") == 1);
+		REQUIRE(dependencies("1 > 2") == 0);
+	}
+}
+
+TEST_CASE("Every expression is typed", "[types]") {
+	using namespace seam::ir::ast;
+	using built_in_type = type::built_in_type;
+
+	const auto module = parse_module(
+		"fn g(a: u8, b: bool) -> i64\n"
+		"{\n"
+		"\treturn 1\n"
+		"}\n"
+		"\n"
+		"fn h() -> u16\n"
+		"{\n"
+		"\treturn 7\n"
+		"}\n"
+		"\n"
+		"fn main() @constructor\n"
+		"{\n"
+		"\ts := \"text\"\n"
+		"\tx := g(1, true)\n"
+		"\ty := -x + 2\n"
+		"\tz := x * 2 > 3 && !(y < x)\n"
+		"\ti := 1\n"
+		"\tf := 1.5 * 2\n"
+		"}\n");
+
+	const auto type_of = [](expression::expression* expression)
+	{
+		REQUIRE(expression->eval_type);
+		return std::get<built_in_type>(expression->eval_type->value);
+	};
+	const auto& statements = find_function(*module, "main")->body->body;
+	const auto value = [&](const std::size_t statement) { return statements[statement]->as<statement::assignment>()->from; };
+
+	SECTION("every kind of expression") {
+		struct checker
+		{
+			std::vector<node_kind> kinds;
+
+			bool visit(expression::symbol_wrapper* node)
+			{
+				return false; // names a function, which has no type of its own.
+			}
+
+			bool visit(expression::expression* node)
+			{
+				REQUIRE(node->eval_type);
+				kinds.push_back(node->kind);
+				return true;
+			}
+		};
+
+		checker vst;
+		module->body->visit(&vst);
+		for (const auto kind : { node_kind::unary, node_kind::binary, node_kind::variable_ref, node_kind::call,
+			node_kind::bool_literal, node_kind::string_literal, node_kind::number_literal })
+		{
+			REQUIRE(std::find(vst.kinds.cbegin(), vst.kinds.cend(), kind) != vst.kinds.cend());
+		}
+		REQUIRE(type_of(value(0)) == built_in_type::string);
+		REQUIRE(type_of(value(1)) == built_in_type::i64);
+		REQUIRE(type_of(value(3)) == built_in_type::bool_);
+	}
+
+	SECTION("literals settle to what they are used as") {
+		REQUIRE(type_of(value(1)->as<expression::call>()->arguments[0]) == built_in_type::u8);
+		REQUIRE(type_of(value(2)->as<expression::binary>()->right) == built_in_type::i64);
+		REQUIRE(type_of(find_function(*module, "h")->body->body[0]->as<statement::ret>()->value) == built_in_type::u16);
+		REQUIRE(type_of(value(4)) == built_in_type::i32);
+		REQUIRE(type_of(value(5)) == built_in_type::f64);
+	}
+
+	SECTION("literals that do not fit are reported where they are") {
+		const auto error_at = [](const std::string& statement, const std::string& literal)
+		{
+			const auto source = "fn main() @constructor\n{\n" + statement + "\n}\n";
+			return parse_and_describe(source).rfind("error at " + std::to_string(source.find(literal)) + ": number literal '" + literal + "'", 0) == 0;
+		};
+		REQUIRE(error_at("\ta: u8 = 1 + 300", "300"));
+		REQUIRE(error_at("\ta: i32 = 2147483648", "2147483648"));
+		REQUIRE(error_at("\ta: i32 = -2147483649", "2147483649"));
+		REQUIRE(error_at("\ta: i8 = 2.5", "2.5"));
+	}
+
+	SECTION("the smallest signed values can be spelled") {
+		const auto smallest = parse_statements("\ta: i32 = -2147483648\n\tb: i8 = -128\n\tc := -2147483648\n");
+		REQUIRE(smallest == std::vector<std::string>{ "a = (-2147483648)", "b = (-128)", "c = (-2147483648)" });
+	}
+}
+
+TEST_CASE("Cached modules read back as they were written", "[types]") {
+	const auto source =
+		"type count = u32\n"
+		"\n"
+		"extern puts(text: string) -> i32\n"
+		"\n"
+		"fn twice(a: i64) -> i64\n"
+		"{\n"
+		"\treturn 2\n"
+		"}\n"
+		"\n"
+		"fn main() @constructor\n"
+		"{\n"
+		"\tx := twice(-3) * 2 + 1\n"
+		"\tc: count = 4 + 5\n"
+		"\tif (x > 2 && !(x == 7))\n"
+		"\t{\n"
+		"\t\tputs(\"big\")\n"
+		"\t}\n"
+		"\twhile (x < 10)\n"
+		"\t{\n"
+		"\t\ty := 1.5 > 2.5\n"
+		"\t}\n"
+		"}\n";
+	const auto module = parse_module(source);
+	const auto hash = seam::types::hash_source(source);
+	const auto path = (std::filesystem::temp_directory_path() / "seam_module_cache_test.seamast").string();
+	seam::types::write_module(*module, hash, path);
+
+	std::string bytes;
+	{
+		std::ifstream file{ path, std::ios::binary };
+		bytes.assign(std::istreambuf_iterator<char>{ file }, {});
+	}
+	const auto rewrite = [&](const std::string& contents)
+	{
+		std::ofstream{ path, std::ios::binary | std::ios::trunc } << contents;
+	};
+
+	SECTION("the tree, its types, resolved calls, flat bodies and dependencies") {
+		const auto cached = seam::types::read_module(path, hash);
+		REQUIRE(cached);
+		REQUIRE(describe(*cached) == describe(*module));
+	}
+
+	SECTION("caches of another source or version are ignored") {
+		REQUIRE(seam::types::read_module(path, hash + 1) == nullptr);
+
+		auto other_version = bytes;
+		const auto version = seam::types::module_cache_version + 1;
+		std::memcpy(&other_version[8], &version, sizeof(version));
+		rewrite(other_version);
+		REQUIRE(seam::types::read_module(path, hash) == nullptr);
+
+		std::filesystem::remove(path);
+		REQUIRE(seam::types::read_module(path, hash) == nullptr);
+	}
+
+	SECTION("truncated caches are malformed") {
+		for (std::size_t size = 0; size < bytes.size(); size += 7)
+		{
+			rewrite(bytes.substr(0, size));
+			REQUIRE_THROWS_AS(seam::types::read_module(path, hash), std::runtime_error);
+		}
+	}
+
+	SECTION("corrupted caches are malformed") {
+		// header: magic, version, byte order mark, source hash, then the module name and the symbol count.
+		const auto symbol_count = 8 + 4 + 4 + 8 + 4 + module->name.size();
+		for (const auto corrupted : { std::size_t{ 0 }, symbol_count, symbol_count + 3 })
+		{
+			auto contents = bytes;
+			contents[corrupted] = '\xff';
+			rewrite(contents);
+			REQUIRE_THROWS_AS(seam::types::read_module(path, hash), std::runtime_error);
+		}
+
+		rewrite(bytes + '\0');
+		REQUIRE_THROWS_AS(seam::types::read_module(path, hash), std::runtime_error);
+	}
+
+	std::filesystem::remove(path);
+}
+
+TEST_CASE("Operators bind by priority", "[parser]") {
+	using statements = std::vector<std::string>;
+
+	// Operands are calls and variables, so nothing is folded.
+	const auto spell_value = [](const std::string& expression)
+	{
+		const auto spellings = parse_statements("\tx := g()\n\ty := g()\n\tz := g()\n\tp := x < y\n\tq := y < z\n\ta := " + expression + "\n");
+		REQUIRE(spellings.size() == 6);
+		return spellings.back().substr(spellings.back().find('=') + 2);
+	};
+
+	SECTION("precedence") {
+		REQUIRE(spell_value("x + y * z") == "(x + (y * z))");
+		REQUIRE(spell_value("x * y + z") == "((x * y) + z)");
+		REQUIRE(spell_value("x - y % z / x") == "(x - ((y % z) / x))");
+		REQUIRE(spell_value("x + y < z * x") == "((x + y) < (z * x))");
+		REQUIRE(spell_value("x < y || y < z && p") == "((x < y) || ((y < z) && p))");
+		REQUIRE(spell_value("p && q || x == y") == "((p && q) || (x == y))");
+	}
+
+	SECTION("left associativity") {
+		REQUIRE(spell_value("x - y - z") == "((x - y) - z)");
+		REQUIRE(spell_value("x / y * z % x") == "(((x / y) * z) % x)");
+		REQUIRE(spell_value("p || q || p") == "((p || q) || p)");
+		REQUIRE(spell_value("x + y - z + x") == "(((x + y) - z) + x)");
+	}
+
+	SECTION("unary operators bind tighter than binary ones") {
+		REQUIRE(spell_value("-x * y") == "((-x) * y)");
+		REQUIRE(spell_value("x * -y") == "(x * (-y))");
+		REQUIRE(spell_value("- -x - y") == "((-(-x)) - y)");
+		REQUIRE(spell_value("!p && q") == "((!p) && q)");
+		REQUIRE(spell_value("!!p || !q") == "((!(!p)) || (!q))");
+	}
+
+	SECTION("parentheses and call arguments are expressions of their own") {
+		REQUIRE(spell_value("(x + y) * z") == "((x + y) * z)");
+		REQUIRE(spell_value("x * (y - (z - x))") == "(x * (y - (z - x)))");
+		REQUIRE(spell_value("-(x + y)") == "(-(x + y))");
+		REQUIRE(spell_value("!(x < y) && p") == "((!(x < y)) && p)");
+		REQUIRE(spell_value("g() * x + g()") == "((g() * x) + g())");
+		REQUIRE(spell_value("-g() - -g()") == "((-g()) - (-g()))");
+	}
+
+	SECTION("call arguments") {
+		const auto module = parse_module(
+			"fn h(a: i32, b: i32) -> i32\n"
+			"{\n"
+			"\treturn 1\n"
+			"}\n"
+			"\n"
+			"fn main() @constructor\n"
+			"{\n"
+			"\tx := h(1, 2)\n"
+			"\ty := x * h(x + x * x, -x) - h(h(x, x), (x - x) * x)\n"
+			"}\n");
+		const auto& body = find_function(*module, "main")->body->body;
+		REQUIRE(spell(*module, body[1]) == "y = ((x * h((x + (x * x)), (-x))) - h(h(x, x), ((x - x) * x)))");
+	}
+
+	SECTION("long chains are parsed without recursion") {
+		using namespace seam::ir::ast;
+
+		// Deep enough to overflow the stack of a parser recursing per operator.
+		constexpr std::size_t length = 100000;
+		std::string source = "fn g() -> i32\n{\n\treturn 1\n}\n\nfn main() @constructor\n{\n\tx := g()\n\ta := x";
+		for (std::size_t index = 0; index < length / 2; ++index)
+		{
+			source += " - x * x";
+		}
+		source += "\n\tb := ";
+		for (std::size_t index = 0; index < length; ++index)
+		{
+			source += index % 2 ? "- " : "-";
+		}
+		source += "x\n}\n";
+
+		const auto module = parse_module(source);
+		const auto& body = find_function(*module, "main")->body->body;
+
+		// x - x * x - x * x ... nests to the left, with a product of two variables as every right operand.
+		std::size_t chain = 0;
+		auto expression = body[1]->as<statement::assignment>()->from;
+		while (const auto binary = expression->as<expression::binary>())
+		{
+			const auto product = binary->right->as<expression::binary>();
+			if (binary->operation != seam::lexer::lexeme_type::symbol_minus || !product || product->operation != seam::lexer::lexeme_type::symbol_multiply
+				|| !product->left->is<expression::variable_ref>() || !product->right->is<expression::variable_ref>())
+			{
+				break;
+			}
+			expression = binary->left;
+			++chain;
+		}
+		REQUIRE(expression->is<expression::variable_ref>());
+		REQUIRE(chain == length / 2);
+
+		std::size_t depth = 0;
+		expression = body[2]->as<statement::assignment>()->from;
+		while (const auto unary = expression->as<expression::unary>())
+		{
+			expression = unary->right;
+			++depth;
+		}
+		REQUIRE(expression->is<expression::variable_ref>());
+		REQUIRE(depth == length);
+	}
+}
+
+TEST_CASE("Scoped bindings shadow outer ones until their scope closes", "[parser]") {
+	int values[5] = {};
+	const auto [x, y, z, far] = std::array{ seam::utils::symbol_id{ 0 }, seam::utils::symbol_id{ 1 }, seam::utils::symbol_id{ 2 }, seam::utils::symbol_id{ 1000 } };
+
+	seam::parser::scoped_table<int*> table;
+	table.push_scope();
+	table.bind(x, &values[0]);
+	table.bind(y, &values[1]);
+
+	SECTION("lookups of unbound names miss") {
+		REQUIRE(table.find(z) == nullptr);
+		REQUIRE(table.find(far) == nullptr);
+
+		table.push_scope();
+		table.bind(z, &values[2]);
+		table.pop_scope();
+		REQUIRE(table.find(z) == nullptr);
+	}
+
+	SECTION("popping a scope restores the bindings it shadowed") {
+		table.push_scope();
+		table.bind(x, &values[2]);
+		REQUIRE(table.find(x) == &values[2]);
+		REQUIRE(table.find(y) == &values[1]);
+
+		table.push_scope();
+		table.bind(x, &values[3]);
+		table.bind(far, &values[4]);
+		table.bind(x, &values[4]); // rebinding in the same scope shadows too.
+		REQUIRE(table.find(x) == &values[4]);
+		REQUIRE(table.find(far) == &values[4]);
+		REQUIRE(table.size() == 6);
+
+		table.pop_scope();
+		REQUIRE(table.find(x) == &values[2]);
+		REQUIRE(table.find(far) == nullptr);
+		REQUIRE(table.size() == 3);
+
+		table.pop_scope();
+		REQUIRE(table.find(x) == &values[0]);
+		REQUIRE(table.find(y) == &values[1]);
+
+		table.pop_scope();
+		REQUIRE(table.find(x) == nullptr);
+		REQUIRE(table.size() == 0);
+	}
+
+	SECTION("hidden bindings are skipped until shown again") {
+		table.push_scope();
+		table.bind(x, &values[2]);
+		table.bind(z, &values[3]);
+
+		table.hide(2);
+		REQUIRE(table.find(x) == &values[0]);
+		REQUIRE(table.find(y) == &values[1]);
+		REQUIRE(table.find(z) == nullptr);
+
+		table.push_scope();
+		table.bind(z, &values[4]); // made after hide, found as usual.
+		REQUIRE(table.find(z) == &values[4]);
+		table.pop_scope();
+		REQUIRE(table.find(z) == nullptr);
+
+		table.show_all();
+		REQUIRE(table.find(x) == &values[2]);
+		REQUIRE(table.find(z) == &values[3]);
+	}
+}
+
+TEST_CASE("Reparsing over and over keeps the arena bounded", "[parser]") {
+	std::string source =
+		"fn g() -> i32\n"
+		"{\n"
+		"\treturn 1\n"
+		"}\n"
+		"\n"
+		"fn f() -> i32\n"
+		"{\n"
+		"\ty := g()\n"
+		"\treturn y + 2\n"
+		"}\n"
+		"\n"
+		"fn main() @constructor\n"
+		"{\n"
+		"\tf()\n"
+		"}\n";
+	for (auto function = 0; function < 30; ++function)
+	{
+		source += "\nfn h" + std::to_string(function) + "() -> i32\n{\n\tx := " + std::to_string(function) + "\n\treturn x * 2 - 1\n}\n";
+	}
+
+	const auto module = parse_module(source);
+	const auto parsed_bytes = module->arena.bytes_used();
+	REQUIRE(module->parsed_bytes == parsed_bytes);
+
+	// Every edit changes the literal g returns, reparsing g and its caller f.
+	auto peak_bytes = parsed_bytes;
+	auto full_parses = 0;
+	for (auto edit = 0; edit < 500; ++edit)
+	{
+		const auto literal = source.find("return ") + 7;
+		const auto length = static_cast<std::uint32_t>(source.find('\n', literal) - literal);
+		const auto replacement = std::to_string(edit % 2 ? edit : edit * 1000);
+		source.replace(literal, length, replacement);
+
+		const auto bytes_before = module->arena.bytes_used();
+		seam::parser::parser parser{ module, "test", source };
+		parser.reparse({ { { { static_cast<std::uint32_t>(literal) }, { static_cast<std::uint32_t>(literal + length) } }, static_cast<std::uint32_t>(replacement.size()) } });
+
+		full_parses += module->arena.bytes_used() < bytes_before;
+		peak_bytes = std::max(peak_bytes, module->arena.bytes_used());
+	}
+
+	REQUIRE(full_parses > 0);
+	REQUIRE(full_parses < 50); // most edits are still reparsed in place.
+	REQUIRE(peak_bytes <= 3 * parsed_bytes);
+	REQUIRE(describe(*module, false) == parse_and_describe(source, seam::parser::body_parsing::eager, false));
+}